@@ -0,0 +1,158 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <backtest/backtest.h>
+#include <backtest/marketevents.h>
+#include <ready_trader_go/config.h>
+#include <ready_trader_go/error.h>
+
+#include "trader-3.h"
+
+using namespace ReadyTraderGo;
+
+static void usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [--exchange FILE] [--trader FILE] [--start SECONDS] [--end SECONDS]\n"
+              << "       [MARKET_DATA_FILE...]\n"
+              << "\n"
+              << "Replay each market data file (by default, the one named in the exchange\n"
+              << "configuration) to the auto-trader and print its results. A file may be a\n"
+              << "CSV file or a binary one written by convert-market-data. The market runs\n"
+              << "on a simulated clock, so a backtest runs as fast as it can and gives the\n"
+              << "same results every time.\n"
+              << "\n"
+              << "  --exchange FILE  exchange configuration (default exchange.json)\n"
+              << "  --trader FILE    auto-trader configuration (default trader-3.json)\n"
+              << "  --start SECONDS  time to start trading, after the market has opened (default 0)\n"
+              << "  --end SECONDS    time after which market events are ignored (default none)\n";
+}
+
+static boost::property_tree::ptree readConfig(const std::string& filename)
+{
+    boost::property_tree::ptree tree;
+    try
+    {
+        boost::property_tree::read_json(filename, tree);
+    }
+    catch (const boost::property_tree::json_parser_error& err)
+    {
+        throw ReadyTraderGoError("failed while reading configuration file: '" + filename + "': " + err.message());
+    }
+    return tree;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string exchangeFilename = "exchange.json";
+    std::string traderFilename = "trader-3.json";
+    double startTime = 0.0;
+    double endTime = 0.0;
+    std::vector<std::string> marketDataFilenames;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--exchange") == 0 && hasValue)
+        {
+            exchangeFilename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--trader") == 0 && hasValue)
+        {
+            traderFilename = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--start") == 0 && hasValue)
+        {
+            startTime = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--end") == 0 && hasValue)
+        {
+            endTime = std::strtod(argv[++i], nullptr);
+        }
+        else if (argv[i][0] == '-')
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        else
+        {
+            marketDataFilenames.emplace_back(argv[i]);
+        }
+    }
+
+    // The auto-trader's log messages would outnumber everything else
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        BacktestConfig backtestConfig;
+        backtestConfig.readFromPropertyTree(readConfig(exchangeFilename));
+        backtestConfig.mStartTime = startTime;
+        backtestConfig.mEndTime = endTime;
+        Config traderConfig;
+        traderConfig.readFromPropertyTree(readConfig(traderFilename));
+
+        if (marketDataFilenames.empty())
+        {
+            marketDataFilenames.push_back(backtestConfig.mMarketDataFile);
+        }
+
+        std::cout << "MarketDataFile,Status,BuyVolume,SellVolume,EtfPosition,FuturePosition,TotalFees,"
+                     "AccountBalance,ProfitOrLoss,MaxDrawdown,Messages,Errors,EndTime,Seconds,Reason\n";
+        for (const std::string& filename : marketDataFilenames)
+        {
+            backtestConfig.mMarketDataFile = filename;
+            const auto start = std::chrono::steady_clock::now();
+
+            SimulatedClock clock;
+            boost::asio::io_context context;
+            AutoTrader trader{context};
+            configureAutoTrader(trader, traderConfig);
+            Backtest backtest{context, backtestConfig, readMarketEvents(filename)};
+            backtest.Start(trader);
+            clock.Run(context);
+
+            const BacktestResult& result = backtest.GetResult();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << filename << ',' << result.mStatus << ',' << result.mBuyVolume << ',' << result.mSellVolume
+                      << ',' << result.mEtfPosition << ',' << result.mFuturePosition << ',' << result.mTotalFees
+                      << ',' << result.mAccountBalance << ',' << result.mProfitOrLoss << ',' << result.mMaxDrawdown
+                      << ',' << result.mMessageCount << ',' << result.mErrorCount << ',' << std::fixed
+                      << std::setprecision(3) << result.mEndTime << ',' << seconds << ',' << result.mBreachReason
+                      << std::defaultfloat << std::endl;
+        }
+    }
+    catch (const ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ready_trader_go/fielddecoding.h"
+#include "ready_trader_go/protocol.h"
+#include "ready_trader_go/types.h"
+
+using namespace ReadyTraderGo;
+
+// Times decoding the levels of order book messages with readLongs, with the
+// scalar decoder and with the whole of OrderBookMessage::Deserialise (which
+// is compiled with the library's flags rather than this program's).
+
+constexpr std::size_t MESSAGE_COUNT = 4096;
+constexpr int ROUNDS = 2000;
+
+struct Levels
+{
+    std::array<Price, TOP_LEVEL_COUNT> mAskPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> mAskVolumes;
+    std::array<Price, TOP_LEVEL_COUNT> mBidPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> mBidVolumes;
+};
+
+// Every decoded field is added up, so none of the decoding can be optimised away.
+template<typename P, typename V>
+static unsigned long sum(const std::array<P, TOP_LEVEL_COUNT>& askPrices,
+                         const std::array<V, TOP_LEVEL_COUNT>& askVolumes,
+                         const std::array<P, TOP_LEVEL_COUNT>& bidPrices,
+                         const std::array<V, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    unsigned long result = 0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        result += askPrices[i] + askVolumes[i] + bidPrices[i] + bidVolumes[i];
+    }
+    return result;
+}
+
+template<typename Decode>
+static void time(const char* name, const std::vector<unsigned char>& messages, std::size_t messageSize,
+                 Decode&& decode)
+{
+    unsigned long checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        for (std::size_t i = 0; i < MESSAGE_COUNT; ++i)
+        {
+            checksum += decode(messages.data() + i * messageSize);
+        }
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << elapsed.count() / (MESSAGE_COUNT * ROUNDS) << " ns/message"
+              << "  (checksum " << checksum << ")\n";
+}
+
+int main()
+{
+    std::mt19937 random(42);
+    std::array<Price, TOP_LEVEL_COUNT> askPrices, bidPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> askVolumes, bidVolumes;
+
+    const std::size_t messageSize = OrderBookMessage().Size();
+    std::vector<unsigned char> messages(MESSAGE_COUNT * messageSize);
+    for (std::size_t i = 0; i < MESSAGE_COUNT; ++i)
+    {
+        for (std::size_t j = 0; j < TOP_LEVEL_COUNT; ++j)
+        {
+            askPrices[j] = random() % 200000;
+            askVolumes[j] = random() % 1000;
+            bidPrices[j] = random() % 200000;
+            bidVolumes[j] = random() % 1000;
+        }
+        OrderBookMessage(Instrument::ETF, i, askPrices, askVolumes, bidPrices, bidVolumes)
+            .Serialise(messages.data() + i * messageSize);
+    }
+
+    // The levels follow the instrument and sequence number.
+    constexpr std::size_t levelsOffset = MessageFieldSize::BYTE + MessageFieldSize::LONG;
+
+    std::cout << "readLongs decoder: " << READ_LONGS_DECODER << "\n";
+
+    Levels levels;
+    time("readLongs", messages, messageSize, [&levels](unsigned char const* data) {
+        data += levelsOffset;
+        data = readLongs(data, levels.mAskPrices.data(), TOP_LEVEL_COUNT);
+        data = readLongs(data, levels.mAskVolumes.data(), TOP_LEVEL_COUNT);
+        data = readLongs(data, levels.mBidPrices.data(), TOP_LEVEL_COUNT);
+        readLongs(data, levels.mBidVolumes.data(), TOP_LEVEL_COUNT);
+        return sum(levels.mAskPrices, levels.mAskVolumes, levels.mBidPrices, levels.mBidVolumes);
+    });
+    time("readLongsScalar", messages, messageSize, [&levels](unsigned char const* data) {
+        data += levelsOffset;
+        data = readLongsScalar(data, levels.mAskPrices.data(), TOP_LEVEL_COUNT);
+        data = readLongsScalar(data, levels.mAskVolumes.data(), TOP_LEVEL_COUNT);
+        data = readLongsScalar(data, levels.mBidPrices.data(), TOP_LEVEL_COUNT);
+        readLongsScalar(data, levels.mBidVolumes.data(), TOP_LEVEL_COUNT);
+        return sum(levels.mAskPrices, levels.mAskVolumes, levels.mBidPrices, levels.mBidVolumes);
+    });
+
+    OrderBookMessage message;
+    time("OrderBookMessage", messages, messageSize, [&message, messageSize](unsigned char const* data) {
+        message.Deserialise(data, messageSize);
+        return sum(message.mAskPrices, message.mAskVolumes, message.mBidPrices, message.mBidVolumes);
+    });
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "backtest/marketevents.h"
+#include "matching_engine/matchingbook.h"
+#include "referenceorderbook.h"
+
+using namespace ReadyTraderGo;
+
+// Times replaying a day of market data through the backtest's MatchingBook
+// and through the map-based reference book it replaced, which matches orders
+// in the same way (see matchingbook_tests).
+
+constexpr int ROUNDS = 5;
+
+// Replays into a fresh pair of books, one per instrument as in the backtest,
+// from makeBooks. The fastest of ROUNDS replays is reported.
+template<typename MakeBooks>
+static void time(const char* name, const std::vector<MarketEvent>& events, MakeBooks&& makeBooks)
+{
+    double best = 0.0;
+    unsigned long checksum = 0;
+    for (int round = 0; round < ROUNDS; ++round)
+    {
+        auto books = makeBooks();
+        std::vector<Order> orders;
+        orders.reserve(events.size());
+        std::unordered_map<unsigned long, Order*> live[2];
+        live[0].reserve(1ul << 18);
+        live[1].reserve(1ul << 18);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (const MarketEvent& event : events)
+        {
+            const auto i = static_cast<std::size_t>(event.mInstrument);
+            if (event.mOperation == MarketEventOperation::INSERT)
+            {
+                const auto volume = static_cast<unsigned long>(std::max<std::int32_t>(event.mVolume, 0));
+                Order& order = orders.emplace_back(Order{event.mOrderId, event.mInstrument, event.mLifespan,
+                                                         event.mSide, event.mPrice, volume, volume});
+                books[i].Insert(event.mTime, order);
+                if (order.mRemainingVolume != 0)
+                {
+                    live[i][order.mClientOrderId] = &order;
+                }
+                continue;
+            }
+
+            auto it = live[i].find(event.mOrderId);
+            if (it == live[i].end())
+            {
+                continue;
+            }
+            Order& order = *it->second;
+            if (event.mOperation == MarketEventOperation::CANCEL)
+            {
+                books[i].Cancel(event.mTime, order);
+            }
+            else if (event.mVolume < 0)
+            {
+                const long volume = static_cast<long>(order.mVolume) + event.mVolume;
+                books[i].Amend(event.mTime, order, static_cast<unsigned long>(std::max(volume, 0l)));
+            }
+            if (order.mRemainingVolume == 0)
+            {
+                live[i].erase(it);
+            }
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = (round == 0) ? elapsed.count() : std::min(best, elapsed.count());
+        checksum = books[0].GetLastTradedPrice() + books[1].GetLastTradedPrice() + live[0].size() + live[1].size();
+    }
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << best * 1e3 << " ms" << std::setprecision(2) << std::setw(8)
+              << events.size() / best / 1e6 << " M events/s" << "  (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char* argv[])
+{
+    const std::string filename = (argc > 1) ? argv[1] : "data/market_data1.csv";
+    const MarketEvents marketEvents = readMarketEvents(filename);
+    const std::vector<MarketEvent> events(marketEvents.begin(), marketEvents.end());
+    std::cout << filename << ": " << events.size() << " events\n";
+
+    time("ReferenceOrderBook", events, []() -> std::array<ReferenceOrderBook, 2> {
+        return {{{Instrument::FUTURE, 0.0, 0.0}, {Instrument::ETF, -0.0001, 0.0002}}};
+    });
+    time("MatchingBook", events, []() -> std::array<MatchingBook, 2> {
+        return {{{Instrument::FUTURE, 100, 0.0, 0.0}, {Instrument::ETF, 100, -0.0001, 0.0002}}};
+    });
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <backtest/marketeventfile.h>
+#include <backtest/marketevents.h>
+#include <ready_trader_go/error.h>
+
+using namespace ReadyTraderGo;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: " << argv[0] << " CSV_FILE BINARY_FILE\n"
+                  << "\n"
+                  << "Convert a market data file to the binary format, which the backtest maps\n"
+                  << "into memory instead of parsing.\n";
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const MarketEvents events{readMarketEventsCsv(argv[1])};
+        writeMarketEventFile(argv[2], events);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << argv[1] << ": " << events.size() << " events";
+        if (!events.empty())
+        {
+            std::cout << " from " << events.begin()->mTime << "s to " << (events.end() - 1)->mTime << "s";
+        }
+        std::cout << ", written to " << argv[2] << " in " << std::fixed << std::setprecision(3) << seconds << "s"
+                  << std::endl;
+    }
+    catch (const ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
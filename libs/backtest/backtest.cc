@@ -0,0 +1,630 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <boost/asio/post.hpp>
+
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/protocol.h>
+
+#include "backtest.h"
+
+namespace ReadyTraderGo {
+
+static Backtest::Clock::duration toDuration(double seconds)
+{
+    return std::chrono::duration_cast<Backtest::Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+static std::size_t instrumentIndex(Instrument instrument)
+{
+    return static_cast<std::size_t>(instrument);
+}
+
+// The price the exchange marks a book to: its last traded price or, before
+// anything has traded, its midpoint
+static unsigned long markPrice(const MatchingBook& book)
+{
+    const unsigned long lastTraded = book.GetLastTradedPrice();
+    return (lastTraded != 0) ? lastTraded : static_cast<unsigned long>(std::lrint(book.GetMidpointPrice()));
+}
+
+void configureAutoTrader(BaseAutoTrader& autoTrader, const Config& config)
+{
+    autoTrader.SetLoginDetails(config.mTeamName, config.mSecret);
+    autoTrader.SetMessageFrequencyLimit(toDuration(config.mMessageFrequencyInterval), config.mMessageFrequencyLimit);
+    autoTrader.SetActiveOrderCountLimit(config.mActiveOrderCountLimit);
+    autoTrader.SetActiveVolumeLimit(config.mActiveVolumeLimit);
+    autoTrader.SetPositionLimit(config.mPositionLimit);
+    autoTrader.SetStaleAfter(toDuration(config.mInfoStaleAfter));
+    autoTrader.SetStrategy(config.mStrategy);
+}
+
+Backtest::Backtest(boost::asio::io_context& context, BacktestConfig config, MarketEvents events)
+    : mContext(context),
+      mConfig(std::move(config)),
+      mTickSize(static_cast<unsigned long>(std::lround(mConfig.mTickSize * 100.0))),
+      mEvents(std::move(events)),
+      mFutureBook(Instrument::FUTURE, mTickSize, 0.0, 0.0),
+      mEtfBook(Instrument::ETF, mTickSize, mConfig.mMakerFee, mConfig.mTakerFee),
+      mMarketTimer(context),
+      mTickTimer(context),
+      mAccount(mTickSize, mConfig.mEtfClamp),
+      mFrequencyLimiter(DEFAULT_MESSAGE_FREQUENCY_INTERVAL, DEFAULT_MESSAGE_FREQUENCY_LIMIT)
+{
+    if (!SimulatedClock::GetInstalled())
+    {
+        throw ReadyTraderGoError("a backtest needs a simulated clock");
+    }
+    if (mConfig.mMarketEventInterval <= 0.0 || mConfig.mTickInterval <= 0.0)
+    {
+        throw ReadyTraderGoError("backtest market event interval and tick interval must be positive");
+    }
+    if (mConfig.mStartTime < 0.0 || (mConfig.mEndTime != 0.0 && mConfig.mEndTime <= mConfig.mStartTime))
+    {
+        throw ReadyTraderGoError("backtest end time must be after its start time");
+    }
+
+    mFrequencyLimiter = FrequencyLimiter(toDuration(mConfig.mMessageFrequencyInterval),
+                                         mConfig.mMessageFrequencyLimit);
+    mUnhedgedLots.emplace(context, Clock::duration::zero());
+    mUnhedgedLots->Expiring = [this]() {
+        if (!mIsFinished)
+        {
+            HardBreach(AdvanceTime(), 0, "held unhedged lots for longer than the time limit");
+        }
+    };
+
+    mFutureBook.TradeOccurred = [this](MatchingBook& book) { TradeOccurredHandler(book); };
+    mEtfBook.TradeOccurred = [this](MatchingBook& book) { TradeOccurredHandler(book); };
+
+    // The books are as they were at the start time, and nothing is sent to
+    // the auto-trader about how they got there
+    mEndEvent = (mConfig.mEndTime != 0.0) ? mEvents.Seek(mConfig.mEndTime) : mEvents.size();
+    ProcessMarketEvents(mConfig.mStartTime);
+    mResult.mMarketEventCount = mEndEvent - mNextEvent;
+}
+
+double Backtest::AdvanceTime()
+{
+    if (!mIsStarted)
+    {
+        return mConfig.mStartTime;
+    }
+    const double now = GetTime();
+    ProcessMarketEvents(now);
+    return now;
+}
+
+double Backtest::GetTime() const
+{
+    return mConfig.mStartTime + std::chrono::duration<double>(Clock::now() - mStartTime).count();
+}
+
+Backtest::Clock::time_point Backtest::GetClockTime(double time) const
+{
+    return mStartTime + toDuration(time - mConfig.mStartTime);
+}
+
+void Backtest::Finish(double now)
+{
+    if (mIsFinished)
+    {
+        return;
+    }
+    mIsFinished = true;
+
+    mResult.mEndTime = now;
+    mResult.mRealTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - mRealStartTime).count();
+    mResult.mProfitOrLoss = mAccount.mProfitOrLoss;
+    mResult.mMaxDrawdown = mAccount.mMaxDrawdown;
+    mResult.mTotalFees = mAccount.mTotalFees;
+    mResult.mAccountBalance = mAccount.mAccountBalance;
+    mResult.mEtfPosition = mAccount.mEtfPosition;
+    mResult.mFuturePosition = mAccount.mFuturePosition;
+    mResult.mBuyVolume = mAccount.mBuyVolume;
+    mResult.mSellVolume = mAccount.mSellVolume;
+
+    mMarketTimer.cancel();
+    mTickTimer.cancel();
+    // This may be called from the unhedged lots' own timer
+    boost::asio::post(mContext, [this] { mUnhedgedLots.reset(); });
+    if (mConnection)
+    {
+        mConnection->Close();
+    }
+}
+
+void Backtest::HardBreach(double now, unsigned long clientOrderId, const std::string& message)
+{
+    if (mIsFinished)
+    {
+        return;
+    }
+    mResult.mStatus = "BREACH";
+    mResult.mBreachReason = message;
+    SendError(clientOrderId, message);
+    Finish(now);
+}
+
+void Backtest::ProcessMarketEvents(double now)
+{
+    while (mNextEvent < mEndEvent && mEvents[mNextEvent].mTime < now)
+    {
+        const MarketEvent& event = mEvents[mNextEvent++];
+        MatchingBook& book = (event.mInstrument == Instrument::FUTURE) ? mFutureBook : mEtfBook;
+        auto& orders = mMarketOrders[instrumentIndex(event.mInstrument)];
+
+        if (event.mOperation == MarketEventOperation::INSERT)
+        {
+            const auto volume = static_cast<unsigned long>(std::max<std::int32_t>(event.mVolume, 0));
+            Order& order = mOrderPool.emplace_back(Order{event.mOrderId, event.mInstrument, event.mLifespan,
+                                                         event.mSide, event.mPrice, volume, volume});
+            book.Insert(event.mTime, order);
+            if (order.mRemainingVolume != 0)
+            {
+                orders[order.mClientOrderId] = &order;
+            }
+            continue;
+        }
+
+        auto it = orders.find(event.mOrderId);
+        if (it == orders.end())
+        {
+            continue;
+        }
+        Order& order = *it->second;
+        if (event.mOperation == MarketEventOperation::CANCEL)
+        {
+            book.Cancel(event.mTime, order);
+        }
+        else if (event.mVolume < 0)
+        {
+            const long volume = static_cast<long>(order.mVolume) + event.mVolume;
+            book.Amend(event.mTime, order, static_cast<unsigned long>(std::max(volume, 0l)));
+        }
+        if (order.mRemainingVolume == 0)
+        {
+            orders.erase(it);
+        }
+    }
+
+    mIsMarketDataDone = mNextEvent == mEndEvent;
+}
+
+void Backtest::SendError(unsigned long clientOrderId, const std::string& message)
+{
+    ++mResult.mErrorCount;
+    mConnection->Deliver(MessageType::ERROR_MESSAGE, ErrorMessage{clientOrderId, message});
+}
+
+void Backtest::SendTradeTicks(MatchingBook& book)
+{
+    const std::size_t index = instrumentIndex(book.GetInstrument());
+    mIsTradeTicksPosted[index] = false;
+
+    TradeTicksMessage ticks;
+    if (!mIsFinished && book.TradeTicks(ticks.mAskPrices, ticks.mAskVolumes, ticks.mBidPrices, ticks.mBidVolumes))
+    {
+        ticks.mInstrument = book.GetInstrument();
+        ticks.mSequenceNumber = ++mTradeTicksSequences[index];
+        mSubscription->Publish(MessageType::TRADE_TICKS, ticks);
+    }
+}
+
+void Backtest::Start(BaseAutoTrader& autoTrader)
+{
+    if (mIsStarted)
+    {
+        throw ReadyTraderGoError("backtest has already started");
+    }
+
+    auto connection = std::make_unique<BacktestConnection>(mContext);
+    mConnection = connection.get();
+    mConnection->MessageSent = [this](unsigned char t, unsigned char const* d, std::size_t s) {
+        MessageHandler(t, d, s);
+    };
+    autoTrader.SetExecutionConnection(std::move(connection));
+
+    mSubscription = std::make_shared<BacktestSubscription>(mContext);
+    autoTrader.SetInformationSubscription(std::shared_ptr<ISubscription>(mSubscription));
+
+    mStartTime = Clock::now();
+    mRealStartTime = std::chrono::steady_clock::now();
+    mIsStarted = true;
+    MarketTimerHandler(1);
+    TickTimerHandler(1);
+}
+
+// Tick n of a timer is due at (n - 1) intervals after the market opens. If
+// the timers fall behind, the ticks they missed are skipped, as they are in
+// the exchange. Market event ticks with no events to process are skipped
+// too, since they would do nothing.
+void Backtest::MarketTimerHandler(unsigned long tickNumber)
+{
+    if (mIsFinished)
+    {
+        return;
+    }
+    const double now = AdvanceTime();
+    if (mIsMarketDataDone)
+    {
+        return;
+    }
+
+    // The first tick after the next event's time is the one that takes it
+    const double next = std::max(now, mEvents[mNextEvent].mTime);
+    tickNumber = std::max(tickNumber, static_cast<unsigned long>(next / mConfig.mMarketEventInterval) + 1);
+    mMarketTimer.expires_at(GetClockTime(tickNumber * mConfig.mMarketEventInterval));
+    mMarketTimer.async_wait([this, tickNumber](const boost::system::error_code& error) {
+        if (!error)
+        {
+            MarketTimerHandler(tickNumber + 1);
+        }
+    });
+}
+
+void Backtest::TickTimerHandler(unsigned long tickNumber)
+{
+    if (mIsFinished)
+    {
+        return;
+    }
+    const double now = GetTime();
+    tickNumber = std::max(tickNumber, static_cast<unsigned long>(now / mConfig.mTickInterval) + 1);
+
+    mAccount.Update(mFutureBook.GetLastTradedPrice(), mEtfBook.GetLastTradedPrice());
+
+    for (MatchingBook* book : {&mFutureBook, &mEtfBook})
+    {
+        OrderBookMessage message;
+        message.mInstrument = book->GetInstrument();
+        message.mSequenceNumber = tickNumber;
+        book->TopLevels(message.mAskPrices, message.mAskVolumes, message.mBidPrices, message.mBidVolumes);
+        mSubscription->Publish(MessageType::ORDER_BOOK_UPDATE, message);
+    }
+
+    if (mIsMarketDataDone)
+    {
+        Finish(now);
+        return;
+    }
+
+    mTickTimer.expires_at(GetClockTime(tickNumber * mConfig.mTickInterval));
+    mTickTimer.async_wait([this, tickNumber](const boost::system::error_code& error) {
+        if (!error)
+        {
+            TickTimerHandler(tickNumber + 1);
+        }
+    });
+}
+
+void Backtest::TradeOccurredHandler(MatchingBook& book)
+{
+    if (!mIsStarted)
+    {
+        return;
+    }
+    const std::size_t index = instrumentIndex(book.GetInstrument());
+    if (!mIsTradeTicksPosted[index])
+    {
+        mIsTradeTicksPosted[index] = true;
+        boost::asio::post(mContext, [this, &book] { SendTradeTicks(book); });
+    }
+}
+
+void Backtest::MessageHandler(unsigned char messageType, unsigned char const* data, std::size_t size)
+{
+    if (mIsFinished)
+    {
+        return;
+    }
+    const double now = AdvanceTime();
+    ++mResult.mMessageCount;
+
+    if (!mFrequencyLimiter.Admit())
+    {
+        HardBreach(now, 0, "message frequency limit breached");
+        return;
+    }
+
+    if (!mIsLoggedIn)
+    {
+        if (messageType == MessageType::LOGIN && size == LoginMessage{}.Size())
+        {
+            mIsLoggedIn = true;
+            return;
+        }
+        mResult.mStatus = "DISCONNECTED";
+        mResult.mBreachReason = "first message received was not a login";
+        Finish(now);
+        return;
+    }
+
+    if (messageType == MessageType::AMEND_ORDER && size == AmendMessage{}.Size())
+    {
+        auto amend = makeMessage<AmendMessage>(data, size);
+        AmendMessageHandler(now, amend.mClientOrderId, amend.mNewVolume);
+    }
+    else if (messageType == MessageType::CANCEL_ORDER && size == CancelMessage{}.Size())
+    {
+        auto cancel = makeMessage<CancelMessage>(data, size);
+        CancelMessageHandler(now, cancel.mClientOrderId);
+    }
+    else if (messageType == MessageType::HEDGE_ORDER && size == HedgeMessage{}.Size())
+    {
+        auto hedge = makeMessage<HedgeMessage>(data, size);
+        HedgeMessageHandler(now, hedge.mClientOrderId, hedge.mSide, hedge.mPrice, hedge.mVolume);
+    }
+    else if (messageType == MessageType::INSERT_ORDER && size == InsertMessage{}.Size())
+    {
+        auto insert = makeMessage<InsertMessage>(data, size);
+        InsertMessageHandler(now, insert.mClientOrderId, insert.mSide, insert.mPrice, insert.mVolume,
+                             insert.mLifespan);
+    }
+    else
+    {
+        mResult.mStatus = "DISCONNECTED";
+        mResult.mBreachReason = "received invalid message with type " + std::to_string(messageType);
+        Finish(now);
+    }
+}
+
+void Backtest::AmendMessageHandler(double now, unsigned long clientOrderId, unsigned long volume)
+{
+    if (static_cast<long>(clientOrderId) > mLastClientOrderId)
+    {
+        SendError(clientOrderId, "out-of-order client_order_id in amend message");
+        return;
+    }
+
+    auto it = mOrders.find(clientOrderId);
+    if (it == mOrders.end())
+    {
+        return;
+    }
+    if (volume > it->second->mVolume)
+    {
+        SendError(clientOrderId, "amend operation would increase order volume");
+        return;
+    }
+    mEtfBook.Amend(now, *it->second, volume);
+}
+
+void Backtest::CancelMessageHandler(double now, unsigned long clientOrderId)
+{
+    if (static_cast<long>(clientOrderId) > mLastClientOrderId)
+    {
+        SendError(clientOrderId, "out-of-order client_order_id in cancel message");
+        return;
+    }
+
+    auto it = mOrders.find(clientOrderId);
+    if (it != mOrders.end())
+    {
+        mEtfBook.Cancel(now, *it->second);
+    }
+}
+
+void Backtest::HedgeMessageHandler(double now, unsigned long clientOrderId, Side side, unsigned long price,
+                                   unsigned long volume)
+{
+    if (static_cast<long>(clientOrderId) <= mLastClientOrderId)
+    {
+        SendError(clientOrderId, "duplicate or out-of-order client_order_id");
+        return;
+    }
+    mLastClientOrderId = static_cast<long>(clientOrderId);
+
+    if (side != Side::BUY && side != Side::SELL)
+    {
+        SendError(clientOrderId, std::to_string(static_cast<int>(side)) + " is not a valid side");
+        return;
+    }
+    if (price < MINIMUM_BID || price > MAXIMUM_ASK)
+    {
+        SendError(clientOrderId, std::to_string(price) + " is not a valid price");
+        return;
+    }
+    if (price % mTickSize != 0)
+    {
+        SendError(clientOrderId, "price is not a multiple of tick size");
+        return;
+    }
+    if (volume < 1)
+    {
+        SendError(clientOrderId, std::to_string(volume) + " is not a valid volume");
+        return;
+    }
+    if (!mIsStarted)
+    {
+        SendError(clientOrderId, "order rejected: market not yet open");
+        return;
+    }
+
+    auto [volumeTraded, averagePrice] = mFutureBook.TryTrade(side, price, volume);
+    if (volumeTraded == 0)
+    {
+        // The trade could have failed because there were no orders on the
+        // opposite side, in which case the last traded price is used
+        const unsigned long best = (side == Side::BUY) ? mFutureBook.GetBestAsk() : mFutureBook.GetBestBid();
+        if (best == 0)
+        {
+            const unsigned long lastTraded = mFutureBook.GetLastTradedPrice();
+            if (lastTraded == 0)
+            {
+                SendError(clientOrderId, "order rejected: cannot determine future price");
+                return;
+            }
+            if ((side == Side::SELL && lastTraded >= price) || (side == Side::BUY && lastTraded <= price))
+            {
+                averagePrice = lastTraded;
+            }
+        }
+    }
+
+    if (averagePrice == 0)
+    {
+        mConnection->Deliver(MessageType::HEDGE_FILLED, HedgeFilledMessage{clientOrderId, 0, 0});
+        return;
+    }
+
+    mAccount.Transact(Instrument::FUTURE, side, averagePrice, volume, 0);
+    mUnhedgedLots->Update(mAccount.mEtfPosition + mAccount.mFuturePosition);
+    mAccount.Update(markPrice(mFutureBook), markPrice(mEtfBook));
+
+    mConnection->Deliver(MessageType::HEDGE_FILLED, HedgeFilledMessage{clientOrderId, averagePrice, volume});
+
+    if (std::abs(mAccount.mFuturePosition) > mConfig.mPositionLimit)
+    {
+        HardBreach(now, clientOrderId, "future position limit breached");
+    }
+}
+
+void Backtest::InsertMessageHandler(double now, unsigned long clientOrderId, Side side, unsigned long price,
+                                    unsigned long volume, Lifespan lifespan)
+{
+    if (static_cast<long>(clientOrderId) <= mLastClientOrderId)
+    {
+        SendError(clientOrderId, "duplicate or out-of-order client_order_id");
+        return;
+    }
+    mLastClientOrderId = static_cast<long>(clientOrderId);
+
+    if (side != Side::BUY && side != Side::SELL)
+    {
+        SendError(clientOrderId, std::to_string(static_cast<int>(side)) + " is not a valid side");
+        return;
+    }
+    if (lifespan != Lifespan::FILL_AND_KILL && lifespan != Lifespan::GOOD_FOR_DAY)
+    {
+        SendError(clientOrderId, std::to_string(static_cast<int>(lifespan)) + " is not a valid lifespan");
+        return;
+    }
+    if (price < MINIMUM_BID || price > MAXIMUM_ASK)
+    {
+        SendError(clientOrderId, std::to_string(price) + " is not a valid price");
+        return;
+    }
+    if (price % mTickSize != 0)
+    {
+        SendError(clientOrderId, "price is not a multiple of tick size");
+        return;
+    }
+    if (mOrders.size() == mConfig.mActiveOrderCountLimit)
+    {
+        SendError(clientOrderId, "order rejected: active order count limit breached");
+        return;
+    }
+    if (volume < 1)
+    {
+        SendError(clientOrderId, std::to_string(volume) + " is not a valid volume");
+        return;
+    }
+    if (mActiveVolume + volume > mConfig.mActiveVolumeLimit)
+    {
+        SendError(clientOrderId, "order rejected: active order volume limit breached");
+        return;
+    }
+    if (!mIsStarted)
+    {
+        SendError(clientOrderId, "order rejected: market not yet open");
+        return;
+    }
+    if ((side == Side::BUY && !mSellPrices.empty() && price >= *mSellPrices.begin())
+        || (side == Side::SELL && !mBuyPrices.empty() && price <= *mBuyPrices.rbegin()))
+    {
+        SendError(clientOrderId, "order rejected: in cross with an existing order");
+        return;
+    }
+
+    Order& order = mOrderPool.emplace_back(Order{clientOrderId, Instrument::ETF, lifespan, side, price, volume,
+                                                 volume, 0, this});
+    mOrders.emplace(clientOrderId, &order);
+    ((side == Side::BUY) ? mBuyPrices : mSellPrices).insert(price);
+    mActiveVolume += volume;
+    mEtfBook.Insert(now, order);
+}
+
+void Backtest::OnOrderAmended(double now, Order& order, unsigned long volumeRemoved)
+{
+    mConnection->Deliver(MessageType::ORDER_STATUS, OrderStatusMessage{order.mClientOrderId,
+                                                                       order.mVolume - order.mRemainingVolume,
+                                                                       order.mRemainingVolume,
+                                                                       order.mTotalFees});
+    mActiveVolume -= volumeRemoved;
+    if (order.mRemainingVolume == 0)
+    {
+        RemoveOrder(order);
+    }
+}
+
+void Backtest::OnOrderCancelled(double now, Order& order, unsigned long volumeRemoved)
+{
+    mConnection->Deliver(MessageType::ORDER_STATUS, OrderStatusMessage{order.mClientOrderId,
+                                                                       order.mVolume - volumeRemoved,
+                                                                       order.mRemainingVolume,
+                                                                       order.mTotalFees});
+    mActiveVolume -= volumeRemoved;
+    RemoveOrder(order);
+}
+
+void Backtest::OnOrderPlaced(double now, Order& order)
+{
+    // Only send an order status if the order has not partially filled
+    if (order.mVolume == order.mRemainingVolume)
+    {
+        mConnection->Deliver(MessageType::ORDER_STATUS,
+                             OrderStatusMessage{order.mClientOrderId, 0, order.mRemainingVolume, order.mTotalFees});
+    }
+}
+
+void Backtest::OnOrderFilled(double now, Order& order, unsigned long price, unsigned long volume, long fee)
+{
+    mActiveVolume -= volume;
+    if (order.mRemainingVolume == 0)
+    {
+        RemoveOrder(order);
+    }
+
+    mAccount.Transact(Instrument::ETF, order.mSide, price, volume, fee);
+    mUnhedgedLots->Update(mAccount.mEtfPosition + mAccount.mFuturePosition);
+    mAccount.Update(markPrice(mFutureBook), price);
+
+    mConnection->Deliver(MessageType::ORDER_FILLED, OrderFilledMessage{order.mClientOrderId, price, volume});
+    mConnection->Deliver(MessageType::ORDER_STATUS, OrderStatusMessage{order.mClientOrderId,
+                                                                       order.mVolume - order.mRemainingVolume,
+                                                                       order.mRemainingVolume,
+                                                                       order.mTotalFees});
+
+    if (std::abs(mAccount.mEtfPosition) > mConfig.mPositionLimit)
+    {
+        HardBreach(now, order.mClientOrderId, "ETF position limit breached");
+    }
+}
+
+void Backtest::RemoveOrder(const Order& order)
+{
+    mOrders.erase(order.mClientOrderId);
+    auto& prices = (order.mSide == Side::BUY) ? mBuyPrices : mSellPrices;
+    prices.erase(prices.find(order.mPrice));
+}
+
+}
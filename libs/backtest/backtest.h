@@ -0,0 +1,231 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_BACKTEST_BACKTEST_H
+#define CPPREADY_TRADER_GO_LIBS_BACKTEST_BACKTEST_H
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/config.h>
+#include <ready_trader_go/frequencylimiter.h>
+#include <ready_trader_go/traderclock.h>
+#include <ready_trader_go/unhedgedlots.h>
+#include <matching_engine/account.h>
+#include <matching_engine/matchingbook.h>
+
+#include "backtestconnection.h"
+#include "marketevents.h"
+
+namespace ReadyTraderGo {
+
+// The parts of the exchange's configuration (exchange.json) a backtest uses
+struct BacktestConfig
+{
+    void readFromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        mMarketDataFile = tree.get<std::string>("Engine.MarketDataFile");
+        mMarketEventInterval = tree.get<double>("Engine.MarketEventInterval", 0.01);
+        mTickInterval = tree.get<double>("Engine.TickInterval", 0.25);
+
+        mMakerFee = tree.get<double>("Fees.Maker", -0.0001);
+        mTakerFee = tree.get<double>("Fees.Taker", 0.0002);
+
+        mEtfClamp = tree.get<double>("Instrument.EtfClamp", 0.002);
+        mTickSize = tree.get<double>("Instrument.TickSize", 1.0);
+
+        mActiveOrderCountLimit = tree.get<unsigned long>("Limits.ActiveOrderCountLimit", 10);
+        mActiveVolumeLimit = tree.get<unsigned long>("Limits.ActiveVolumeLimit", 200);
+        mMessageFrequencyInterval = tree.get<double>("Limits.MessageFrequencyInterval", 1.0);
+        mMessageFrequencyLimit = tree.get<unsigned long>("Limits.MessageFrequencyLimit", 50);
+        mPositionLimit = tree.get<long>("Limits.PositionLimit", 100);
+    }
+
+    std::string mMarketDataFile;
+    double mMarketEventInterval = 0.01;
+    double mTickInterval = 0.25;
+
+    double mMakerFee = -0.0001;
+    double mTakerFee = 0.0002;
+
+    double mEtfClamp = 0.002;
+    double mTickSize = 1.0;
+
+    unsigned long mActiveOrderCountLimit = 10;
+    unsigned long mActiveVolumeLimit = 200;
+    double mMessageFrequencyInterval = 1.0;
+    unsigned long mMessageFrequencyLimit = 50;
+    long mPositionLimit = 100;
+
+    // The part of the day to trade, in seconds since the market opened; an
+    // end time of zero is the end of the market data. These are not in
+    // exchange.json.
+    double mStartTime = 0.0;
+    double mEndTime = 0.0;
+};
+
+// The outcome of a backtest: the auto-trader's final score board entry, and
+// some counts
+struct BacktestResult
+{
+    std::string mStatus = "OK";    // "OK", or "BREACH" if the auto-trader broke a rule
+    std::string mBreachReason;
+    double mEndTime = 0.0;         // market time at which the match ended
+    double mRealTime = 0.0;        // seconds the match took
+
+    long mProfitOrLoss = 0;        // cents
+    long mMaxDrawdown = 0;
+    long mTotalFees = 0;
+    long mAccountBalance = 0;
+    long mEtfPosition = 0;
+    long mFuturePosition = 0;
+    unsigned long mBuyVolume = 0;
+    unsigned long mSellVolume = 0;
+
+    unsigned long mMarketEventCount = 0;  // between the start and end times
+    unsigned long mMessageCount = 0;  // received from the auto-trader
+    unsigned long mErrorCount = 0;    // sent to the auto-trader
+};
+
+// Apply an auto-trader's configuration, as AutoTraderAppHandler does
+void configureAutoTrader(BaseAutoTrader& autoTrader, const Config& config);
+
+// An in-process exchange that replays a day of market data to a single
+// auto-trader through a BacktestConnection and a BacktestSubscription.
+//
+// Everything the Python exchange does for a competitor is done the same
+// way: the order books, order checks, fees, position and unhedged lots
+// limits, order book updates on each tick and trade ticks after each trade,
+// and the account (marked to the last traded prices, with the ETF clamped).
+// The market runs on the SimulatedClock installed on the calling thread,
+// which must also be installed when the auto-trader is made, so that the
+// auto-trader's timers and time limits are on the same clock. The clock
+// jumps from one thing to do to the next: the next batch of market events
+// (taken on the exchange's market event timer, as the exchange takes them),
+// the next order book tick, or the next of the auto-trader's own timers. A
+// backtest therefore takes no longer than its handlers do, and gives the
+// same result every time it is run.
+//
+// With a start time, the market events before it are put into the books
+// before the auto-trader connects, and the market (and the ticks' sequence
+// numbers) carry on from there. The match ends, and the connection is closed,
+// at the first tick after the last market event before the end time, or as
+// soon as the auto-trader breaches a limit.
+class Backtest : private IOrderListener
+{
+public:
+    using Clock = TraderClock;
+
+    Backtest(boost::asio::io_context& context, BacktestConfig config, MarketEvents events);
+
+    Backtest(const Backtest&) = delete;
+    Backtest& operator=(const Backtest&) = delete;
+
+    // Connect the auto-trader and open the market. The result is ready once
+    // the simulated clock has run the context out of work.
+    void Start(BaseAutoTrader& autoTrader);
+
+    const BacktestResult& GetResult() const noexcept { return mResult; }
+    bool IsFinished() const noexcept { return mIsFinished; }
+
+private:
+    // Market time, in seconds since the market opened, after any market
+    // events up to then have been processed
+    double AdvanceTime();
+    double GetTime() const;
+    Clock::time_point GetClockTime(double time) const;
+    void Finish(double now);
+    void HardBreach(double now, unsigned long clientOrderId, const std::string& message);
+    void ProcessMarketEvents(double now);
+    void SendError(unsigned long clientOrderId, const std::string& message);
+    void SendTradeTicks(MatchingBook& book);
+
+    void MarketTimerHandler(unsigned long tickNumber);
+    void MessageHandler(unsigned char messageType, unsigned char const* data, std::size_t size);
+    void TickTimerHandler(unsigned long tickNumber);
+    void TradeOccurredHandler(MatchingBook& book);
+
+    void AmendMessageHandler(double now, unsigned long clientOrderId, unsigned long volume);
+    void CancelMessageHandler(double now, unsigned long clientOrderId);
+    void HedgeMessageHandler(double now, unsigned long clientOrderId, Side side, unsigned long price,
+                             unsigned long volume);
+    void InsertMessageHandler(double now, unsigned long clientOrderId, Side side, unsigned long price,
+                              unsigned long volume, Lifespan lifespan);
+
+    // The auto-trader's orders
+    void OnOrderAmended(double now, Order& order, unsigned long volumeRemoved) override;
+    void OnOrderCancelled(double now, Order& order, unsigned long volumeRemoved) override;
+    void OnOrderPlaced(double now, Order& order) override;
+    void OnOrderFilled(double now, Order& order, unsigned long price, unsigned long volume, long fee) override;
+    void RemoveOrder(const Order& order);
+
+    boost::asio::io_context& mContext;
+    BacktestConfig mConfig;
+    unsigned long mTickSize;  // in cents
+
+    MarketEvents mEvents;
+    std::size_t mNextEvent = 0;
+    std::size_t mEndEvent = 0;
+    bool mIsMarketDataDone = false;
+
+    MatchingBook mFutureBook;
+    MatchingBook mEtfBook;
+    // Orders are kept for the whole match, since market events and the
+    // auto-trader's messages may refer to them after they leave the books
+    std::deque<Order> mOrderPool;
+    std::unordered_map<unsigned long, Order*> mMarketOrders[2];
+
+    Clock::time_point mStartTime;
+    std::chrono::steady_clock::time_point mRealStartTime;
+    bool mIsStarted = false;
+    bool mIsFinished = false;
+    TraderTimer mMarketTimer;
+    TraderTimer mTickTimer;
+
+    BacktestConnection* mConnection = nullptr;
+    std::shared_ptr<BacktestSubscription> mSubscription;
+    std::array<unsigned long, 2> mTradeTicksSequences{1, 1};
+    std::array<bool, 2> mIsTradeTicksPosted{false, false};
+
+    // The competitor
+    bool mIsLoggedIn = false;
+    long mLastClientOrderId = -1;
+    unsigned long mActiveVolume = 0;
+    std::unordered_map<unsigned long, Order*> mOrders;
+    std::multiset<unsigned long> mBuyPrices;
+    std::multiset<unsigned long> mSellPrices;
+    Account mAccount;
+    FrequencyLimiter mFrequencyLimiter;
+    std::optional<UnhedgedLots> mUnhedgedLots;
+
+    BacktestResult mResult;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_BACKTEST_BACKTEST_H
@@ -0,0 +1,151 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <memory>
+
+#include <boost/asio/post.hpp>
+#include <boost/endian/conversion.hpp>
+
+#include <ready_trader_go/connectivity.h>
+
+#include "backtestconnection.h"
+
+namespace ReadyTraderGo {
+
+unsigned char* BacktestMessageQueue::Prepare(unsigned char messageType, std::size_t size)
+{
+    const std::size_t length = MESSAGE_HEADER_SIZE + size;
+    const std::size_t offset = mBuffer.size();
+    mBuffer.resize(offset + length);
+    unsigned char* data = mBuffer.data() + offset;
+    boost::endian::store_big_u16(data, static_cast<uint16_t>(length));
+    data[MESSAGE_TYPE_OFFSET] = messageType;
+    return data + MESSAGE_HEADER_SIZE;
+}
+
+void BacktestMessageQueue::Drain(const Handler& handler)
+{
+    mDraining.clear();
+    mDraining.swap(mBuffer);
+
+    const unsigned char* upto = mDraining.data();
+    const unsigned char* const end = upto + mDraining.size();
+    while (upto < end)
+    {
+        const std::size_t length = boost::endian::load_big_u16(upto);
+        handler(upto[MESSAGE_TYPE_OFFSET], upto + MESSAGE_HEADER_SIZE, length - MESSAGE_HEADER_SIZE);
+        upto += length;
+    }
+}
+
+void BacktestConnection::AsyncRead()
+{
+    mIsReading = true;
+    ScheduleReceive();
+}
+
+void BacktestConnection::Close()
+{
+    mIsClosed = true;
+    ScheduleReceive();
+}
+
+void BacktestConnection::CommitMessage(SendMode)
+{
+    if (mIsClosed)
+    {
+        mSent.Drain([](unsigned char, unsigned char const*, std::size_t) {});
+        return;
+    }
+    mSent.Drain([this](unsigned char type, unsigned char const* data, std::size_t size) {
+        if (MessageSent && !mIsClosed)
+        {
+            MessageSent(type, data, size);
+        }
+    });
+}
+
+void BacktestConnection::Deliver(unsigned char messageType, const ISerialisable& message)
+{
+    if (mIsClosed)
+    {
+        return;
+    }
+    message.Serialise(mDelivered.Prepare(messageType, message.Size()));
+    ScheduleReceive();
+}
+
+unsigned char* BacktestConnection::PrepareMessage(unsigned char messageType, std::size_t size)
+{
+    return mSent.Prepare(messageType, size);
+}
+
+void BacktestConnection::Receive()
+{
+    mIsReceivePosted = false;
+    mDelivered.Drain([this](unsigned char type, unsigned char const* data, std::size_t size) {
+        OnMessageReceipt(type, data, size);
+    });
+    if (mIsClosed && mDelivered.IsEmpty() && !mIsDisconnected)
+    {
+        mIsDisconnected = true;
+        OnDisconnect();
+    }
+}
+
+void BacktestConnection::ScheduleReceive()
+{
+    if (mIsReading && !mIsReceivePosted && !mIsDisconnected)
+    {
+        mIsReceivePosted = true;
+        boost::asio::post(mContext, [this] { Receive(); });
+    }
+}
+
+void BacktestSubscription::AsyncReceive()
+{
+    mIsReceiving = true;
+    if (!mPublished.IsEmpty() && !mIsReceivePosted)
+    {
+        mIsReceivePosted = true;
+        boost::asio::post(mContext, [self = std::weak_ptr<ISubscription>(shared_from_this())] {
+            if (auto subscription = self.lock())
+            {
+                static_cast<BacktestSubscription*>(subscription.get())->Receive();
+            }
+        });
+    }
+}
+
+void BacktestSubscription::Publish(unsigned char messageType, const ISerialisable& message)
+{
+    message.Serialise(mPublished.Prepare(messageType, message.Size()));
+    if (mIsReceiving)
+    {
+        AsyncReceive();
+    }
+}
+
+void BacktestSubscription::Receive()
+{
+    mIsReceivePosted = false;
+    mPublished.Drain([this](unsigned char type, unsigned char const* data, std::size_t size) {
+        OnMessageReceipt(type, data, size);
+    });
+}
+
+}
@@ -0,0 +1,114 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_BACKTEST_BACKTESTCONNECTION_H
+#define CPPREADY_TRADER_GO_LIBS_BACKTEST_BACKTESTCONNECTION_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+
+#include <ready_trader_go/connectivitytypes.h>
+
+namespace ReadyTraderGo {
+
+// Messages written one after another into a buffer, each with the same
+// header as on the wire, to be handed over together
+class BacktestMessageQueue
+{
+public:
+    using Handler = std::function<void(unsigned char, unsigned char const*, std::size_t)>;
+
+    bool IsEmpty() const noexcept { return mBuffer.empty(); }
+
+    // Reserve space for a message and return where its payload goes
+    unsigned char* Prepare(unsigned char messageType, std::size_t size);
+
+    // Take every message queued so far and call the handler with each. Any
+    // queued while the handler runs are left for the next call.
+    void Drain(const Handler& handler);
+
+private:
+    std::vector<unsigned char> mBuffer;
+    std::vector<unsigned char> mDraining;
+};
+
+// The auto-trader's end of an in-process execution connection.
+//
+// Messages the auto-trader commits are passed to MessageSent straight away.
+// Messages from the exchange are queued by Deliver and handed to the
+// auto-trader on a later turn of the event loop, as if they had arrived over
+// a socket, so the exchange never calls into the auto-trader while the
+// auto-trader is calling into it.
+class BacktestConnection : public IConnection
+{
+public:
+    explicit BacktestConnection(boost::asio::io_context& context) : mContext(context) {}
+
+    void AsyncRead() override;
+    void CommitMessage(SendMode mode) override;
+    unsigned char* PrepareMessage(unsigned char messageType, std::size_t size) override;
+
+    // Called by the exchange. A closed connection disconnects the auto-trader
+    // once the messages already delivered have been handled, and drops any
+    // more in either direction.
+    void Close();
+    void Deliver(unsigned char messageType, const ISerialisable& message);
+    bool IsClosed() const noexcept { return mIsClosed; }
+
+    // Called with each message the auto-trader sends
+    std::function<void(unsigned char, unsigned char const*, std::size_t)> MessageSent;
+
+private:
+    void Receive();
+    void ScheduleReceive();
+
+    boost::asio::io_context& mContext;
+    BacktestMessageQueue mSent;
+    BacktestMessageQueue mDelivered;
+    bool mIsReading = false;
+    bool mIsReceivePosted = false;
+    bool mIsClosed = false;
+    bool mIsDisconnected = false;
+};
+
+// The auto-trader's end of an in-process information subscription. Messages
+// published by the exchange are received on a later turn of the event loop.
+class BacktestSubscription : public ISubscription
+{
+public:
+    explicit BacktestSubscription(boost::asio::io_context& context) : mContext(context) {}
+
+    void AsyncReceive() override;
+
+    // Called by the exchange
+    void Publish(unsigned char messageType, const ISerialisable& message);
+
+private:
+    void Receive();
+
+    boost::asio::io_context& mContext;
+    BacktestMessageQueue mPublished;
+    bool mIsReceiving = false;
+    bool mIsReceivePosted = false;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_BACKTEST_BACKTESTCONNECTION_H
@@ -0,0 +1,165 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/error.h>
+
+#include "marketeventfile.h"
+
+namespace ReadyTraderGo {
+
+namespace interprocess = boost::interprocess;
+
+// Return true if each of the event's one-byte fields holds one of its
+// enumeration's values
+static bool hasValidFields(const MarketEvent& event)
+{
+    return static_cast<unsigned char>(event.mInstrument) <= static_cast<unsigned char>(Instrument::ETF)
+           && static_cast<unsigned char>(event.mOperation) <= static_cast<unsigned char>(MarketEventOperation::INSERT)
+           && static_cast<unsigned char>(event.mSide) <= static_cast<unsigned char>(Side::BUY)
+           && static_cast<unsigned char>(event.mLifespan) <= static_cast<unsigned char>(Lifespan::GOOD_FOR_DAY);
+}
+
+bool isMarketEventFile(const std::string& filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    char magic[sizeof(MARKET_EVENT_FILE_MAGIC)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, MARKET_EVENT_FILE_MAGIC, sizeof(magic)) == 0;
+}
+
+MarketEvents mapMarketEventFile(const std::string& filename)
+{
+    std::shared_ptr<interprocess::mapped_region> region;
+    try
+    {
+        interprocess::file_mapping file{filename.c_str(), interprocess::read_only};
+        region = std::make_shared<interprocess::mapped_region>(file, interprocess::read_only);
+    }
+    catch (const interprocess::interprocess_exception& e)
+    {
+        throw ReadyTraderGoError("failed to map market data file: '" + filename + "': " + e.what());
+    }
+    region->advise(interprocess::mapped_region::advice_sequential);
+
+    const auto* data = static_cast<const unsigned char*>(region->get_address());
+    const std::size_t size = region->get_size();
+    MarketEventFileHeader header;
+    if (size < sizeof(header))
+    {
+        throw ReadyTraderGoError("market data file is too short: '" + filename + "'");
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.mMagic, MARKET_EVENT_FILE_MAGIC, sizeof(header.mMagic)) != 0
+        || header.mVersion != MARKET_EVENT_FILE_VERSION || header.mEventSize != sizeof(MarketEvent))
+    {
+        throw ReadyTraderGoError("unsupported market data file format: '" + filename + "'");
+    }
+    if (header.mIndexCount != 0 && !(header.mIndexInterval > 0.0))
+    {
+        throw ReadyTraderGoError("market data file has an invalid index interval: '" + filename + "'");
+    }
+    const std::size_t indexSize = header.mIndexCount * sizeof(std::uint64_t);
+    const std::size_t eventsSize = header.mEventCount * sizeof(MarketEvent);
+    if (header.mIndexCount > size / sizeof(std::uint64_t) || header.mEventCount > size / sizeof(MarketEvent)
+        || size != sizeof(header) + indexSize + eventsSize)
+    {
+        throw ReadyTraderGoError("market data file is truncated or corrupt: '" + filename + "'");
+    }
+
+    // MarketEvents::Seek trusts the index, so every entry must be the first
+    // event at or after its slot's time
+    const auto* index = reinterpret_cast<const std::uint64_t*>(data + sizeof(header));
+    const auto* events = reinterpret_cast<const MarketEvent*>(data + sizeof(header) + indexSize);
+    for (std::size_t i = 0; i < header.mIndexCount; ++i)
+    {
+        const double slotTime = static_cast<double>(i) * header.mIndexInterval;
+        if (index[i] > header.mEventCount || (i != 0 && index[i] < index[i - 1])
+            || (index[i] < header.mEventCount && events[index[i]].mTime < slotTime)
+            || (index[i] != 0 && !(events[index[i] - 1].mTime < slotTime)))
+        {
+            throw ReadyTraderGoError("market data file has an invalid index at entry " + std::to_string(i) + ": '"
+                                     + filename + "'");
+        }
+    }
+
+    // Nor is anything that switches on an event's fields expecting a value
+    // outside its enumeration
+    for (std::size_t i = 0; i < header.mEventCount; ++i)
+    {
+        if (!hasValidFields(events[i]))
+        {
+            throw ReadyTraderGoError("market data file has an invalid event at position " + std::to_string(i)
+                                     + ": '" + filename + "'");
+        }
+    }
+    return MarketEvents(std::move(region), events, header.mEventCount, index, header.mIndexCount,
+                        header.mIndexInterval);
+}
+
+void writeMarketEventFile(const std::string& filename, const MarketEvents& events)
+{
+    std::vector<std::uint64_t> index;
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        if (i != 0 && events[i].mTime < events[i - 1].mTime)
+        {
+            throw ReadyTraderGoError("market events are not in time order at event " + std::to_string(i));
+        }
+        // Every slot up to this event's time starts at or before it
+        const double slots = std::floor(events[i].mTime / MARKET_EVENT_FILE_INDEX_INTERVAL);
+        while (static_cast<double>(index.size()) <= slots)
+        {
+            index.push_back(i);
+        }
+    }
+
+    MarketEventFileHeader header{};
+    std::memcpy(header.mMagic, MARKET_EVENT_FILE_MAGIC, sizeof(header.mMagic));
+    header.mVersion = MARKET_EVENT_FILE_VERSION;
+    header.mEventSize = sizeof(MarketEvent);
+    header.mEventCount = events.size();
+    header.mIndexCount = index.size();
+    header.mIndexInterval = MARKET_EVENT_FILE_INDEX_INTERVAL;
+
+    std::ofstream file{filename, std::ios::binary | std::ios::trunc};
+    if (!file)
+    {
+        throw ReadyTraderGoError("failed to open market data file for writing: '" + filename + "'");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(index.data()),
+               static_cast<std::streamsize>(index.size() * sizeof(std::uint64_t)));
+    file.write(reinterpret_cast<const char*>(events.begin()),
+               static_cast<std::streamsize>(events.size() * sizeof(MarketEvent)));
+    if (!file.flush())
+    {
+        throw ReadyTraderGoError("failed to write market data file: '" + filename + "'");
+    }
+}
+
+}
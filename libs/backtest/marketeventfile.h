@@ -0,0 +1,67 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_BACKTEST_MARKETEVENTFILE_H
+#define CPPREADY_TRADER_GO_LIBS_BACKTEST_MARKETEVENTFILE_H
+
+#include <cstdint>
+#include <string>
+
+#include "marketevents.h"
+
+namespace ReadyTraderGo {
+
+// A binary market data file holds the same events as a CSV file, laid out
+// so that it can be mapped into memory and used as it is:
+//
+//     MarketEventFileHeader
+//     std::uint64_t index[mIndexCount]
+//     MarketEvent events[mEventCount]
+//
+// Entry k of the index is the position of the first event at or after k
+// times mIndexInterval seconds. Numbers are in the byte order of the machine
+// that wrote the file; a file from a machine with the other byte order fails
+// the version check.
+constexpr char MARKET_EVENT_FILE_MAGIC[8] = {'R', 'T', 'G', 'E', 'V', 'E', 'N', 'T'};
+constexpr std::uint32_t MARKET_EVENT_FILE_VERSION = 1;
+constexpr double MARKET_EVENT_FILE_INDEX_INTERVAL = 1.0;
+
+struct MarketEventFileHeader
+{
+    char mMagic[8];
+    std::uint32_t mVersion;
+    std::uint32_t mEventSize;
+    std::uint64_t mEventCount;
+    std::uint64_t mIndexCount;
+    double mIndexInterval;
+};
+
+static_assert(sizeof(MarketEventFileHeader) == 40, "market event file header must be 40 bytes");
+
+// Return true if the file starts with the binary market data file magic
+bool isMarketEventFile(const std::string& filename);
+
+// Map a binary market data file into memory. The events are used where they
+// are, and the file stays mapped while any copy of the result is alive.
+MarketEvents mapMarketEventFile(const std::string& filename);
+
+// Write events, which must be in time order, to a binary market data file
+void writeMarketEventFile(const std::string& filename, const MarketEvents& events);
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_BACKTEST_MARKETEVENTFILE_H
@@ -0,0 +1,254 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <ready_trader_go/error.h>
+
+#include "marketeventfile.h"
+#include "marketevents.h"
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t MARKET_EVENT_FIELD_COUNT = 8;
+
+namespace {
+
+struct Field
+{
+    const char* mBegin;
+    const char* mEnd;
+
+    bool IsEmpty() const noexcept { return mBegin == mEnd; }
+    bool Is(const char* text) const noexcept
+    {
+        const std::size_t length = std::strlen(text);
+        return static_cast<std::size_t>(mEnd - mBegin) == length && std::memcmp(mBegin, text, length) == 0;
+    }
+};
+
+}
+
+static MarketEventOperation operationFromField(const Field& field)
+{
+    if (field.Is("Insert") || field.Is("INSERT"))
+    {
+        return MarketEventOperation::INSERT;
+    }
+    if (field.Is("Cancel") || field.Is("CANCEL"))
+    {
+        return MarketEventOperation::CANCEL;
+    }
+    if (field.Is("Amend") || field.Is("AMEND"))
+    {
+        return MarketEventOperation::AMEND;
+    }
+    throw ReadyTraderGoError("unknown operation '" + std::string(field.mBegin, field.mEnd) + "'");
+}
+
+static Side sideFromField(const Field& field)
+{
+    if (field.IsEmpty() || field.Is("B") || field.Is("BID") || field.Is("BUY"))
+    {
+        return Side::BUY;
+    }
+    if (field.Is("A") || field.Is("ASK") || field.Is("SELL"))
+    {
+        return Side::SELL;
+    }
+    throw ReadyTraderGoError("unknown side '" + std::string(field.mBegin, field.mEnd) + "'");
+}
+
+static Lifespan lifespanFromField(const Field& field)
+{
+    if (field.IsEmpty() || field.Is("G") || field.Is("GFD") || field.Is("GOOD_FOR_DAY"))
+    {
+        return Lifespan::GOOD_FOR_DAY;
+    }
+    if (field.Is("F") || field.Is("FAK") || field.Is("FILL_AND_KILL"))
+    {
+        return Lifespan::FILL_AND_KILL;
+    }
+    throw ReadyTraderGoError("unknown lifespan '" + std::string(field.mBegin, field.mEnd) + "'");
+}
+
+// Numbers are followed by a comma, a line end or the end of the text, any of
+// which stops strtod and strtoul
+static double doubleFromField(const Field& field)
+{
+    return field.IsEmpty() ? 0.0 : std::strtod(field.mBegin, nullptr);
+}
+
+template<typename T>
+static T checkedFromField(const Field& field, double value, const char* name)
+{
+    if (value < static_cast<double>(std::numeric_limits<T>::min())
+        || value > static_cast<double>(std::numeric_limits<T>::max()))
+    {
+        throw ReadyTraderGoError(std::string(name) + " '" + std::string(field.mBegin, field.mEnd)
+                                 + "' is out of range");
+    }
+    return static_cast<T>(value);
+}
+
+MarketEvents::MarketEvents(std::vector<MarketEvent> events)
+{
+    auto owner = std::make_shared<const std::vector<MarketEvent>>(std::move(events));
+    mBegin = owner->data();
+    mEnd = mBegin + owner->size();
+    mOwner = std::move(owner);
+}
+
+MarketEvents::MarketEvents(std::shared_ptr<const void> owner, const MarketEvent* events, std::size_t count,
+                           const std::uint64_t* index, std::size_t indexCount, double indexInterval)
+    : mOwner(std::move(owner)),
+      mBegin(events),
+      mEnd(events + count),
+      mIndex(index),
+      mIndexCount(indexCount),
+      mIndexInterval(indexInterval)
+{
+}
+
+std::size_t MarketEvents::Seek(double time) const noexcept
+{
+    const MarketEvent* first = mBegin;
+    const MarketEvent* last = mEnd;
+    if (mIndexCount != 0 && time > 0.0)
+    {
+        // The event sought is between the index entries either side of time
+        const auto slot = static_cast<std::size_t>(time / mIndexInterval);
+        if (slot < mIndexCount)
+        {
+            first = mBegin + mIndex[slot];
+            last = (slot + 1 < mIndexCount) ? mBegin + mIndex[slot + 1] : mEnd;
+        }
+        else
+        {
+            first = mBegin + mIndex[mIndexCount - 1];
+        }
+    }
+    const MarketEvent* it = std::lower_bound(first, last, time, [](const MarketEvent& event, double t) {
+        return event.mTime < t;
+    });
+    return static_cast<std::size_t>(it - mBegin);
+}
+
+MarketEvents readMarketEvents(const std::string& filename)
+{
+    if (isMarketEventFile(filename))
+    {
+        return mapMarketEventFile(filename);
+    }
+    return MarketEvents(readMarketEventsCsv(filename));
+}
+
+std::vector<MarketEvent> readMarketEventsCsv(const std::string& filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    if (!file)
+    {
+        throw ReadyTraderGoError("failed to open market data file: '" + filename + "'");
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    const std::string text = contents.str();
+
+    std::vector<MarketEvent> events;
+    events.reserve(text.size() / 32);
+
+    const char* upto = text.c_str();
+    const char* const end = upto + text.size();
+    unsigned long lineNumber = 0;
+
+    // Skip the header row
+    upto = static_cast<const char*>(std::memchr(upto, '\n', end - upto));
+    upto = (upto == nullptr) ? end : upto + 1;
+
+    while (upto < end)
+    {
+        ++lineNumber;
+        const char* lineEnd = static_cast<const char*>(std::memchr(upto, '\n', end - upto));
+        if (lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+        const char* next = lineEnd + 1;
+        if (lineEnd != upto && lineEnd[-1] == '\r')
+        {
+            --lineEnd;
+        }
+        if (lineEnd == upto)
+        {
+            upto = next;
+            continue;
+        }
+
+        std::array<Field, MARKET_EVENT_FIELD_COUNT> fields;
+        std::size_t count = 0;
+        for (const char* begin = upto; count < MARKET_EVENT_FIELD_COUNT; ++count)
+        {
+            const char* comma = static_cast<const char*>(std::memchr(begin, ',', lineEnd - begin));
+            fields[count] = Field{begin, (comma == nullptr) ? lineEnd : comma};
+            if (comma == nullptr)
+            {
+                ++count;
+                break;
+            }
+            begin = comma + 1;
+        }
+        if (count != MARKET_EVENT_FIELD_COUNT)
+        {
+            throw ReadyTraderGoError("malformed market event in '" + filename + "' on row "
+                                     + std::to_string(lineNumber));
+        }
+
+        try
+        {
+            MarketEvent event;
+            event.mTime = doubleFromField(fields[0]);
+            event.mInstrument = (std::strtoul(fields[1].mBegin, nullptr, 10) == 0) ? Instrument::FUTURE
+                                                                                   : Instrument::ETF;
+            event.mOperation = operationFromField(fields[2]);
+            event.mOrderId = checkedFromField<std::uint32_t>(fields[3], doubleFromField(fields[3]), "order id");
+            event.mSide = sideFromField(fields[4]);
+            event.mVolume = checkedFromField<std::int32_t>(fields[5], doubleFromField(fields[5]), "volume");
+            event.mPrice = checkedFromField<std::uint32_t>(fields[6],
+                                                           doubleFromField(fields[6]) * MARKET_DATA_PRICE_SCALING,
+                                                           "price");
+            event.mLifespan = lifespanFromField(fields[7]);
+            events.push_back(event);
+        }
+        catch (const ReadyTraderGoError& e)
+        {
+            throw ReadyTraderGoError("malformed market event in '" + filename + "' on row "
+                                     + std::to_string(lineNumber) + ": " + e.what());
+        }
+
+        upto = next;
+    }
+
+    return events;
+}
+
+}
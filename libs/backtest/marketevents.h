@@ -0,0 +1,95 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_BACKTEST_MARKETEVENTS_H
+#define CPPREADY_TRADER_GO_LIBS_BACKTEST_MARKETEVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// Prices in the market data files are in dollars
+constexpr double MARKET_DATA_PRICE_SCALING = 100.0;
+
+enum class MarketEventOperation : unsigned char { AMEND, CANCEL, INSERT };
+
+// An order event from a market data file, in the form the exchange's
+// MarketEventsReader uses. This is also the record layout of binary market
+// data files (see marketeventfile.h), so changing it needs a new file version.
+struct MarketEvent
+{
+    double mTime;                     // seconds since the market opened
+    std::uint32_t mOrderId;
+    std::int32_t mVolume;             // for an amend, minus the volume removed
+    std::uint32_t mPrice;             // in cents; inserts only
+    Instrument mInstrument;
+    MarketEventOperation mOperation;
+    Side mSide;                       // inserts only
+    Lifespan mLifespan;
+};
+
+static_assert(sizeof(MarketEvent) == 24, "market events must be 24 bytes");
+
+// A day of market events in time order, either read from a CSV file or
+// mapped from a binary one. Copies share the same events.
+class MarketEvents
+{
+public:
+    MarketEvents() = default;
+    explicit MarketEvents(std::vector<MarketEvent> events);
+    // Events held by owner, which is kept alive for as long as they are used.
+    // An index, if given, has the position of the first event at or after
+    // each multiple of indexInterval seconds.
+    MarketEvents(std::shared_ptr<const void> owner, const MarketEvent* events, std::size_t count,
+                 const std::uint64_t* index = nullptr, std::size_t indexCount = 0, double indexInterval = 0.0);
+
+    const MarketEvent* begin() const noexcept { return mBegin; }
+    const MarketEvent* end() const noexcept { return mEnd; }
+    bool empty() const noexcept { return mBegin == mEnd; }
+    std::size_t size() const noexcept { return static_cast<std::size_t>(mEnd - mBegin); }
+    const MarketEvent& operator[](std::size_t i) const noexcept { return mBegin[i]; }
+
+    // The position of the first event at or after the given time
+    std::size_t Seek(double time) const noexcept;
+
+private:
+    std::shared_ptr<const void> mOwner;
+    const MarketEvent* mBegin = nullptr;
+    const MarketEvent* mEnd = nullptr;
+    const std::uint64_t* mIndex = nullptr;
+    std::size_t mIndexCount = 0;
+    double mIndexInterval = 0.0;
+};
+
+// Read every event in a market data file. A binary file (see
+// marketeventfile.h) is mapped into memory; anything else is read as a CSV
+// file with the columns Time, Instrument, Operation, OrderId, Side, Volume,
+// Price and Lifespan.
+MarketEvents readMarketEvents(const std::string& filename);
+
+// Read every event in a CSV market data file
+std::vector<MarketEvent> readMarketEventsCsv(const std::string& filename);
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_BACKTEST_MARKETEVENTS_H
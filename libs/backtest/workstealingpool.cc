@@ -0,0 +1,176 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <utility>
+
+#include "workstealingpool.h"
+
+namespace ReadyTraderGo {
+
+// The pool and queue of the thread running a task, if it belongs to a pool
+static thread_local WorkStealingPool* currentPool = nullptr;
+static thread_local std::size_t currentQueue = 0;
+
+WorkStealingPool::WorkStealingPool(std::size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    mQueues.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        mQueues.push_back(std::make_unique<Queue>());
+    }
+    mThreads.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        mThreads.emplace_back([this, i] { Worker(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mAllDone.wait(lock, [this] { return mPendingCount == 0; });
+        mIsStopping = true;
+    }
+    mTaskQueued.notify_all();
+    for (std::thread& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit(Task task)
+{
+    std::size_t index;
+    if (currentPool == this)
+    {
+        index = currentQueue;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        index = mNextQueue;
+        mNextQueue = (mNextQueue + 1) % mQueues.size();
+    }
+
+    // Counted before it is queued, so no thread can take it before it is counted
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mQueuedCount;
+        ++mPendingCount;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mQueues[index]->mMutex);
+        mQueues[index]->mTasks.push_back(std::move(task));
+    }
+    mTaskQueued.notify_one();
+}
+
+bool WorkStealingPool::TryTake(std::size_t index, Task& task)
+{
+    {
+        Queue& own = *mQueues[index];
+        std::lock_guard<std::mutex> lock(own.mMutex);
+        if (!own.mTasks.empty())
+        {
+            task = std::move(own.mTasks.back());
+            own.mTasks.pop_back();
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < mQueues.size(); ++i)
+    {
+        Queue& other = *mQueues[(index + i) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(other.mMutex);
+        if (!other.mTasks.empty())
+        {
+            task = std::move(other.mTasks.front());
+            other.mTasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mAllDone.wait(lock, [this] { return mPendingCount == 0; });
+    if (mError)
+    {
+        std::rethrow_exception(std::exchange(mError, nullptr));
+    }
+}
+
+void WorkStealingPool::Worker(std::size_t index)
+{
+    currentPool = this;
+    currentQueue = index;
+
+    Task task;
+    while (true)
+    {
+        if (!TryTake(index, task))
+        {
+            // A task counted as queued may already have been taken by another
+            // thread, in which case this just looks again
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskQueued.wait(lock, [this] { return mIsStopping || mQueuedCount != 0; });
+            if (mIsStopping)
+            {
+                return;
+            }
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mQueuedCount;
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        task = nullptr;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (error && !mError)
+        {
+            mError = error;
+        }
+        if (--mPendingCount == 0)
+        {
+            mAllDone.notify_all();
+        }
+    }
+}
+
+}
@@ -0,0 +1,86 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_BACKTEST_WORKSTEALINGPOOL_H
+#define CPPREADY_TRADER_GO_LIBS_BACKTEST_WORKSTEALINGPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ReadyTraderGo {
+
+// Runs tasks on a fixed number of threads, each with its own queue. A thread
+// takes the newest task from its own queue and, when that's empty, steals the
+// oldest from another's, so a thread that draws short tasks doesn't sit idle
+// while another works through a backlog of long ones.
+//
+// Tasks submitted from outside the pool are dealt to the queues in turn, and
+// tasks submitted by a task go to its own thread's queue.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // A thread count of zero means one per hardware thread
+    explicit WorkStealingPool(std::size_t threadCount = 0);
+    // Waits for the tasks already submitted
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    std::size_t GetThreadCount() const noexcept { return mThreads.size(); }
+
+    void Submit(Task task);
+
+    // Wait until every task submitted has finished. If any task threw, the
+    // first exception is rethrown here.
+    void Wait();
+
+private:
+    struct Queue
+    {
+        std::mutex mMutex;
+        std::deque<Task> mTasks;
+    };
+
+    bool TryTake(std::size_t index, Task& task);
+    void Worker(std::size_t index);
+
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mThreads;
+    std::size_t mNextQueue = 0;
+
+    std::mutex mMutex;
+    std::condition_variable mTaskQueued;
+    std::condition_variable mAllDone;
+    std::size_t mQueuedCount = 0;   // in the queues
+    std::size_t mPendingCount = 0;  // in the queues or running
+    std::exception_ptr mError;
+    bool mIsStopping = false;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_BACKTEST_WORKSTEALINGPOOL_H
@@ -0,0 +1,94 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_MATCHING_ENGINE_ACCOUNT_H
+#define CPPREADY_TRADER_GO_LIBS_MATCHING_ENGINE_ACCOUNT_H
+
+#include <cmath>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// A competitor's cash, positions and profit, kept as the exchange's
+// CompetitorAccount keeps them. Amounts are in cents.
+struct Account
+{
+    Account(unsigned long tickSize, double etfClamp) : mTickSize(tickSize), mEtfClamp(etfClamp) {}
+
+    void Transact(Instrument instrument, Side side, unsigned long price, unsigned long volume, long fee);
+
+    // Mark the positions to the given prices. The ETF is valued at its price
+    // clamped to within the ETF clamp of the future's price.
+    void Update(unsigned long futurePrice, unsigned long etfPrice);
+
+    unsigned long mTickSize;
+    double mEtfClamp;
+
+    long mAccountBalance = 0;
+    long mEtfPosition = 0;
+    long mFuturePosition = 0;
+    unsigned long mBuyVolume = 0;
+    unsigned long mSellVolume = 0;
+    long mTotalFees = 0;
+    long mProfitOrLoss = 0;
+    long mMaxProfit = 0;
+    long mMaxDrawdown = 0;
+};
+
+inline void Account::Transact(Instrument instrument, Side side, unsigned long price, unsigned long volume, long fee)
+{
+    const long value = static_cast<long>(price * volume);
+    mAccountBalance += (side == Side::SELL) ? value : -value;
+    mAccountBalance -= fee;
+    mTotalFees += fee;
+
+    const long delta = (side == Side::SELL) ? -static_cast<long>(volume) : static_cast<long>(volume);
+    if (instrument == Instrument::FUTURE)
+    {
+        mFuturePosition += delta;
+    }
+    else
+    {
+        mEtfPosition += delta;
+        ((side == Side::SELL) ? mSellVolume : mBuyVolume) += volume;
+    }
+}
+
+inline void Account::Update(unsigned long futurePrice, unsigned long etfPrice)
+{
+    long delta = std::lrint(mEtfClamp * static_cast<double>(futurePrice));
+    delta -= delta % static_cast<long>(mTickSize);
+    const long minPrice = static_cast<long>(futurePrice) - delta;
+    const long maxPrice = static_cast<long>(futurePrice) + delta;
+    const long price = static_cast<long>(etfPrice);
+    const long clamped = (price < minPrice) ? minPrice : (price > maxPrice) ? maxPrice : price;
+
+    mProfitOrLoss = mAccountBalance + mFuturePosition * static_cast<long>(futurePrice) + mEtfPosition * clamped;
+    if (mProfitOrLoss > mMaxProfit)
+    {
+        mMaxProfit = mProfitOrLoss;
+    }
+    if (mMaxProfit - mProfitOrLoss > mMaxDrawdown)
+    {
+        mMaxDrawdown = mMaxProfit - mProfitOrLoss;
+    }
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_MATCHING_ENGINE_ACCOUNT_H
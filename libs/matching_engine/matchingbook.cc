@@ -0,0 +1,452 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include <ready_trader_go/error.h>
+
+#include "matchingbook.h"
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t BITS_PER_WORD = 64;
+
+// Fees are rounded half to even, like Python's round
+static long roundFee(unsigned long price, unsigned long volume, double rate)
+{
+    return std::lrint(static_cast<double>(price * volume) * rate);
+}
+
+// The index of the first set bit at or after from, or size if there isn't one
+static std::size_t findFirstSet(const std::vector<std::uint64_t>& bits, std::size_t from, std::size_t size)
+{
+    if (from >= size)
+    {
+        return size;
+    }
+    std::size_t word = from / BITS_PER_WORD;
+    std::uint64_t value = bits[word] & (~std::uint64_t{0} << (from % BITS_PER_WORD));
+    while (value == 0)
+    {
+        if (++word == bits.size())
+        {
+            return size;
+        }
+        value = bits[word];
+    }
+    return word * BITS_PER_WORD + static_cast<std::size_t>(__builtin_ctzll(value));
+}
+
+// The index of the last set bit before end, or end if there isn't one
+static std::size_t findLastSet(const std::vector<std::uint64_t>& bits, std::size_t end)
+{
+    if (end == 0)
+    {
+        return end;
+    }
+    std::size_t word = (end - 1) / BITS_PER_WORD;
+    const std::size_t shift = BITS_PER_WORD - 1 - (end - 1) % BITS_PER_WORD;
+    std::uint64_t value = bits[word] & (~std::uint64_t{0} >> shift);
+    while (value == 0)
+    {
+        if (word-- == 0)
+        {
+            return end;
+        }
+        value = bits[word];
+    }
+    return word * BITS_PER_WORD + BITS_PER_WORD - 1 - static_cast<std::size_t>(__builtin_clzll(value));
+}
+
+static void addTick(std::vector<std::pair<unsigned long, unsigned long>>& ticks, unsigned long price,
+                    unsigned long volume)
+{
+    for (auto& tick : ticks)
+    {
+        if (tick.first == price)
+        {
+            tick.second += volume;
+            return;
+        }
+    }
+    ticks.emplace_back(price, volume);
+}
+
+template<typename Compare>
+static void copyTicks(std::vector<std::pair<unsigned long, unsigned long>>& ticks,
+                      Compare compare,
+                      std::array<Price, TOP_LEVEL_COUNT>& prices,
+                      std::array<Volume, TOP_LEVEL_COUNT>& volumes)
+{
+    std::sort(ticks.begin(), ticks.end(), compare);
+    std::size_t i = 0;
+    for (; i < TOP_LEVEL_COUNT && i < ticks.size(); ++i)
+    {
+        prices[i] = ticks[i].first;
+        volumes[i] = ticks[i].second;
+    }
+    for (; i < TOP_LEVEL_COUNT; ++i)
+    {
+        prices[i] = 0;
+        volumes[i] = 0;
+    }
+    ticks.clear();
+}
+
+MatchingBook::Ladder::Ladder(bool isAsk, std::size_t window)
+    : mIsAsk(isAsk), mNear(window), mNearBits((window + BITS_PER_WORD - 1) / BITS_PER_WORD)
+{
+}
+
+bool MatchingBook::Ladder::GetNext(unsigned long tick, unsigned long& next) const noexcept
+{
+    bool isFound = false;
+    const std::size_t size = mNear.size();
+
+    if (mIsAsk)
+    {
+        const std::size_t from = (tick < mBase) ? 0 : std::min<unsigned long>(tick - mBase + 1, size);
+        const std::size_t index = findFirstSet(mNearBits, from, size);
+        if (index != size)
+        {
+            next = mBase + index;
+            isFound = true;
+        }
+        auto it = mFar.upper_bound(tick);
+        if (it != mFar.end() && (!isFound || it->first < next))
+        {
+            next = it->first;
+            isFound = true;
+        }
+    }
+    else
+    {
+        const std::size_t end = (tick < mBase) ? 0 : std::min<unsigned long>(tick - mBase, size);
+        const std::size_t index = findLastSet(mNearBits, end);
+        if (index != end)
+        {
+            next = mBase + index;
+            isFound = true;
+        }
+        auto it = mFar.lower_bound(tick);
+        if (it != mFar.begin() && (!isFound || std::prev(it)->first > next))
+        {
+            next = std::prev(it)->first;
+            isFound = true;
+        }
+    }
+
+    return isFound;
+}
+
+MatchingBook::Level& MatchingBook::Ladder::GetLevel(unsigned long tick)
+{
+    return IsNear(tick) ? mNear[tick - mBase] : mFar[tick];
+}
+
+MatchingBook::Level& MatchingBook::Ladder::Place(Order& order, unsigned long tick)
+{
+    Level& level = GetLevel(tick);
+    if (level.mHead == nullptr)
+    {
+        if (IsNear(tick))
+        {
+            const std::size_t index = tick - mBase;
+            mNearBits[index / BITS_PER_WORD] |= std::uint64_t{1} << (index % BITS_PER_WORD);
+        }
+        if (mLevelCount++ == 0 || IsBetter(tick, mBest))
+        {
+            mBest = tick;
+        }
+        level.mHead = &order;
+    }
+    else
+    {
+        level.mTail->mNext = &order;
+    }
+    order.mPrev = level.mTail;
+    order.mNext = nullptr;
+    level.mTail = &order;
+    level.mTotalVolume += order.mRemainingVolume;
+    return level;
+}
+
+void MatchingBook::Ladder::Remove(Order& order, Level& level, unsigned long tick)
+{
+    (order.mPrev ? order.mPrev->mNext : level.mHead) = order.mNext;
+    (order.mNext ? order.mNext->mPrev : level.mTail) = order.mPrev;
+    order.mPrev = nullptr;
+    order.mNext = nullptr;
+    if (level.mHead != nullptr)
+    {
+        return;
+    }
+
+    if (IsNear(tick))
+    {
+        const std::size_t index = tick - mBase;
+        mNearBits[index / BITS_PER_WORD] &= ~(std::uint64_t{1} << (index % BITS_PER_WORD));
+        level.mTotalVolume = 0;
+    }
+    else
+    {
+        mFar.erase(tick);
+    }
+    if (--mLevelCount != 0 && tick == mBest)
+    {
+        GetNext(tick, mBest);
+    }
+}
+
+MatchingBook::MatchingBook(Instrument instrument, unsigned long tickSize, double makerFee, double takerFee,
+                           std::size_t window)
+    : mInstrument(instrument),
+      mTickSize(tickSize),
+      mMakerFee(makerFee),
+      mTakerFee(takerFee),
+      mWindow(window),
+      mAsks(true, window),
+      mBids(false, window)
+{
+    if (tickSize == 0)
+    {
+        throw ReadyTraderGoError("matching book tick size must be positive");
+    }
+}
+
+void MatchingBook::Amend(double now, Order& order, unsigned long newVolume)
+{
+    if (order.mRemainingVolume == 0)
+    {
+        return;
+    }
+
+    const unsigned long fillVolume = order.mVolume - order.mRemainingVolume;
+    const unsigned long diff = order.mVolume - std::min(std::max(newVolume, fillVolume), order.mVolume);
+    Ladder& ladder = (order.mSide == Side::SELL) ? mAsks : mBids;
+    const unsigned long tick = order.mPrice / mTickSize;
+    Level& level = ladder.GetLevel(tick);
+    level.mTotalVolume -= diff;
+    order.mVolume -= diff;
+    order.mRemainingVolume -= diff;
+    if (order.mRemainingVolume == 0)
+    {
+        ladder.Remove(order, level, tick);
+    }
+    if (order.mListener)
+    {
+        order.mListener->OnOrderAmended(now, order, diff);
+    }
+}
+
+void MatchingBook::Cancel(double now, Order& order)
+{
+    if (order.mRemainingVolume == 0)
+    {
+        return;
+    }
+
+    Ladder& ladder = (order.mSide == Side::SELL) ? mAsks : mBids;
+    const unsigned long tick = order.mPrice / mTickSize;
+    Level& level = ladder.GetLevel(tick);
+    const unsigned long remaining = order.mRemainingVolume;
+    level.mTotalVolume -= remaining;
+    order.mRemainingVolume = 0;
+    ladder.Remove(order, level, tick);
+    if (order.mListener)
+    {
+        order.mListener->OnOrderCancelled(now, order, remaining);
+    }
+}
+
+void MatchingBook::Insert(double now, Order& order)
+{
+    if (order.mPrice % mTickSize != 0)
+    {
+        throw ReadyTraderGoError("order price is not a multiple of the tick size");
+    }
+
+    const unsigned long tick = order.mPrice / mTickSize;
+    if (!mIsBaseSet)
+    {
+        const unsigned long base = (tick > mWindow / 2) ? tick - mWindow / 2 : 0;
+        mAsks.SetBase(base);
+        mBids.SetBase(base);
+        mIsBaseSet = true;
+    }
+
+    if (order.mSide == Side::SELL && !mBids.IsEmpty() && tick <= mBids.GetBest())
+    {
+        Trade(now, order, mBids);
+    }
+    else if (order.mSide == Side::BUY && !mAsks.IsEmpty() && tick >= mAsks.GetBest())
+    {
+        Trade(now, order, mAsks);
+    }
+
+    if (order.mRemainingVolume == 0)
+    {
+        return;
+    }
+
+    if (order.mLifespan == Lifespan::FILL_AND_KILL)
+    {
+        const unsigned long remaining = order.mRemainingVolume;
+        order.mRemainingVolume = 0;
+        if (order.mListener)
+        {
+            order.mListener->OnOrderCancelled(now, order, remaining);
+        }
+        return;
+    }
+
+    ((order.mSide == Side::SELL) ? mAsks : mBids).Place(order, tick);
+    if (order.mListener)
+    {
+        order.mListener->OnOrderPlaced(now, order);
+    }
+}
+
+void MatchingBook::TopLevels(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                             std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                             std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                             std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes) const
+{
+    auto copyLevels = [this](const Ladder& ladder,
+                             std::array<Price, TOP_LEVEL_COUNT>& prices,
+                             std::array<Volume, TOP_LEVEL_COUNT>& volumes) {
+        std::size_t i = 0;
+        unsigned long tick = ladder.GetBest();
+        for (bool isLevel = !ladder.IsEmpty(); i < TOP_LEVEL_COUNT && isLevel; ++i)
+        {
+            prices[i] = tick * mTickSize;
+            volumes[i] = ladder.GetLevel(tick).mTotalVolume;
+            isLevel = ladder.GetNext(tick, tick);
+        }
+        for (; i < TOP_LEVEL_COUNT; ++i)
+        {
+            prices[i] = 0;
+            volumes[i] = 0;
+        }
+    };
+
+    copyLevels(mAsks, askPrices, askVolumes);
+    copyLevels(mBids, bidPrices, bidVolumes);
+}
+
+void MatchingBook::Trade(double now, Order& order, Ladder& ladder)
+{
+    while (order.mRemainingVolume > 0 && !ladder.IsEmpty())
+    {
+        const unsigned long tick = ladder.GetBest();
+        const unsigned long price = tick * mTickSize;
+        if ((order.mSide == Side::BUY) ? price > order.mPrice : price < order.mPrice)
+        {
+            break;
+        }
+        TradeLevel(now, order, price, ladder.GetLevel(tick), ladder, tick);
+    }
+}
+
+void MatchingBook::TradeLevel(double now, Order& order, unsigned long price, Level& level, Ladder& ladder,
+                              unsigned long tick)
+{
+    unsigned long remaining = order.mRemainingVolume;
+    bool isLevelEmpty = false;
+
+    while (remaining > 0 && !isLevelEmpty)
+    {
+        Order& passive = *level.mHead;
+        const unsigned long volume = std::min(remaining, passive.mRemainingVolume);
+        const long fee = roundFee(price, volume, mMakerFee);
+        remaining -= volume;
+        level.mTotalVolume -= volume;
+        passive.mRemainingVolume -= volume;
+        passive.mTotalFees += fee;
+        if (passive.mRemainingVolume == 0)
+        {
+            // The level goes with its last order, so don't touch it after this
+            isLevelEmpty = passive.mNext == nullptr;
+            ladder.Remove(passive, level, tick);
+        }
+        if (passive.mListener)
+        {
+            passive.mListener->OnOrderFilled(now, passive, price, volume, fee);
+        }
+    }
+
+    const unsigned long tradedVolume = order.mRemainingVolume - remaining;
+    addTick((order.mSide == Side::BUY) ? mAskTicks : mBidTicks, price, tradedVolume);
+
+    const long fee = roundFee(price, tradedVolume, mTakerFee);
+    order.mRemainingVolume = remaining;
+    order.mTotalFees += fee;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderFilled(now, order, price, tradedVolume, fee);
+    }
+
+    mLastTradedPrice = price;
+    if (TradeOccurred)
+    {
+        TradeOccurred(*this);
+    }
+}
+
+bool MatchingBook::TradeTicks(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                              std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                              std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                              std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    if (mAskTicks.empty() && mBidTicks.empty())
+    {
+        return false;
+    }
+
+    copyTicks(mAskTicks, [](const auto& a, const auto& b) { return a.first < b.first; }, askPrices, askVolumes);
+    copyTicks(mBidTicks, [](const auto& a, const auto& b) { return a.first > b.first; }, bidPrices, bidVolumes);
+    return true;
+}
+
+std::pair<unsigned long, unsigned long> MatchingBook::TryTrade(Side side,
+                                                               unsigned long limitPrice,
+                                                               unsigned long volume) const
+{
+    const Ladder& ladder = (side == Side::SELL) ? mBids : mAsks;
+    unsigned long totalVolume = 0;
+    unsigned long totalValue = 0;
+
+    unsigned long tick = ladder.GetBest();
+    for (bool isLevel = !ladder.IsEmpty(); totalVolume < volume && isLevel; isLevel = ladder.GetNext(tick, tick))
+    {
+        const unsigned long price = tick * mTickSize;
+        if ((side == Side::SELL) ? price < limitPrice : price > limitPrice)
+        {
+            break;
+        }
+        const unsigned long weight = std::min(volume - totalVolume,
+                                              ladder.GetLevel(tick).mTotalVolume);
+        totalVolume += weight;
+        totalValue += weight * price;
+    }
+
+    return {totalVolume, (totalVolume > 0) ? totalValue / totalVolume : 0};
+}
+
+}
@@ -0,0 +1,203 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_MATCHING_ENGINE_MATCHINGBOOK_H
+#define CPPREADY_TRADER_GO_LIBS_MATCHING_ENGINE_MATCHINGBOOK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// The number of ticks a MatchingBook holds in its level arrays, centred on the
+// price of the first order inserted. Levels outside them still work, but are
+// kept in a map.
+constexpr std::size_t DEFAULT_MATCHING_BOOK_WINDOW = 1ul << 15;
+
+class IOrderListener;
+
+// A request to buy or sell at a given price
+struct Order
+{
+    unsigned long mClientOrderId;
+    Instrument mInstrument;
+    Lifespan mLifespan;
+    Side mSide;
+    unsigned long mPrice;
+    unsigned long mVolume;
+    unsigned long mRemainingVolume;
+    long mTotalFees = 0;
+    IOrderListener* mListener = nullptr;
+
+    // The order's neighbours in its price level's queue, while it's in a book
+    Order* mPrev = nullptr;
+    Order* mNext = nullptr;
+};
+
+class IOrderListener
+{
+public:
+    virtual ~IOrderListener() = default;
+
+    virtual void OnOrderAmended(double now, Order& order, unsigned long volumeRemoved) {}
+    virtual void OnOrderCancelled(double now, Order& order, unsigned long volumeRemoved) {}
+    // Called when a good-for-day order is placed in the order book
+    virtual void OnOrderPlaced(double now, Order& order) {}
+    virtual void OnOrderFilled(double now, Order& order, unsigned long price, unsigned long volume, long fee) {}
+};
+
+// A collection of orders arranged by price-time priority, with the same
+// behaviour as the exchange's OrderBook (ready_trader_go/order_book.py):
+// fill-and-kill and good-for-day orders, maker and taker fees (rounded half
+// to even, as Python rounds), trade ticks and the hedge price.
+//
+// Each side keeps its price levels in an array indexed by tick, with a
+// bitmap of the levels that have orders, and each level's orders in a queue
+// linked through the orders themselves. Placing, amending and cancelling an
+// order take constant time, apart from finding the next level when the best
+// one empties, which is a scan of the bitmap.
+//
+// The book refers to orders but doesn't own them. An order is in the book
+// from when it's placed until it has no remaining volume, and mustn't be
+// destroyed or inserted again in the meantime. Prices of inserted orders
+// must be multiples of the tick size.
+class MatchingBook
+{
+public:
+    MatchingBook(Instrument instrument, unsigned long tickSize, double makerFee, double takerFee,
+                 std::size_t window = DEFAULT_MATCHING_BOOK_WINDOW);
+
+    MatchingBook(const MatchingBook&) = delete;
+    MatchingBook& operator=(const MatchingBook&) = delete;
+
+    // Decrease an order's volume, though not below the volume already filled
+    void Amend(double now, Order& order, unsigned long newVolume);
+    void Cancel(double now, Order& order);
+    // Match a new order and place what's left of it, unless it's fill-and-kill
+    void Insert(double now, Order& order);
+
+    // Zero if there are no orders on that side
+    unsigned long GetBestAsk() const noexcept { return mAsks.IsEmpty() ? 0 : mAsks.GetBest() * mTickSize; }
+    unsigned long GetBestBid() const noexcept { return mBids.IsEmpty() ? 0 : mBids.GetBest() * mTickSize; }
+    Instrument GetInstrument() const noexcept { return mInstrument; }
+    // Zero if nothing has traded yet
+    unsigned long GetLastTradedPrice() const noexcept { return mLastTradedPrice; }
+    // Zero unless there are orders on both sides
+    double GetMidpointPrice() const noexcept;
+    unsigned long GetTickSize() const noexcept { return mTickSize; }
+
+    void TopLevels(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                   std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                   std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                   std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes) const;
+
+    // Return true, and fill in the volume traded at each price since the last
+    // call, if anything has traded
+    bool TradeTicks(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                    std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                    std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                    std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes);
+
+    // Return the volume that would trade, and its average price per lot
+    // (rounded down), for the given order without changing the book
+    std::pair<unsigned long, unsigned long> TryTrade(Side side, unsigned long limitPrice, unsigned long volume) const;
+
+    // Called after each level an order trades with
+    std::function<void(MatchingBook&)> TradeOccurred;
+
+private:
+    struct Level
+    {
+        Order* mHead = nullptr;
+        Order* mTail = nullptr;
+        unsigned long mTotalVolume = 0;
+    };
+
+    // One side of the book. Ticks are prices divided by the tick size, and
+    // the best tick is the lowest for asks and the highest for bids.
+    class Ladder
+    {
+    public:
+        Ladder(bool isAsk, std::size_t window);
+
+        void SetBase(unsigned long base) noexcept { mBase = base; }
+
+        bool IsEmpty() const noexcept { return mLevelCount == 0; }
+        // Only valid if the ladder isn't empty
+        unsigned long GetBest() const noexcept { return mBest; }
+        // Return true, and set next to the best tick worse than the given one
+        // that has orders, if there is one
+        bool GetNext(unsigned long tick, unsigned long& next) const noexcept;
+        bool IsBetter(unsigned long a, unsigned long b) const noexcept { return mIsAsk ? a < b : a > b; }
+
+        // The const version is only for levels that have orders
+        Level& GetLevel(unsigned long tick);
+        const Level& GetLevel(unsigned long tick) const { return IsNear(tick) ? mNear[tick - mBase] : mFar.at(tick); }
+        Level& Place(Order& order, unsigned long tick);
+        // Take an order out of its level's queue, and the level out of the
+        // ladder if it has no orders left
+        void Remove(Order& order, Level& level, unsigned long tick);
+
+    private:
+        bool IsNear(unsigned long tick) const noexcept { return tick >= mBase && tick - mBase < mNear.size(); }
+
+        bool mIsAsk;
+        unsigned long mBase = 0;
+        std::vector<Level> mNear;
+        std::vector<std::uint64_t> mNearBits;
+        std::map<unsigned long, Level> mFar;
+        std::size_t mLevelCount = 0;
+        unsigned long mBest = 0;
+    };
+
+    void Trade(double now, Order& order, Ladder& ladder);
+    void TradeLevel(double now, Order& order, unsigned long price, Level& level, Ladder& ladder,
+                    unsigned long tick);
+
+    Instrument mInstrument;
+    unsigned long mTickSize;
+    double mMakerFee;
+    double mTakerFee;
+    std::size_t mWindow;
+    bool mIsBaseSet = false;
+
+    Ladder mAsks;
+    Ladder mBids;
+    std::vector<std::pair<unsigned long, unsigned long>> mAskTicks;  // price and volume traded
+    std::vector<std::pair<unsigned long, unsigned long>> mBidTicks;
+    unsigned long mLastTradedPrice = 0;
+};
+
+inline double MatchingBook::GetMidpointPrice() const noexcept
+{
+    if (mAsks.IsEmpty() || mBids.IsEmpty())
+    {
+        return 0.0;
+    }
+    return static_cast<double>((mBids.GetBest() + mAsks.GetBest()) * mTickSize) / 2.0;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_MATCHING_ENGINE_MATCHINGBOOK_H
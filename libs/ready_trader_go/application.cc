@@ -19,6 +19,7 @@
 #include <cstring>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <string>
 
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
@@ -127,6 +128,13 @@ void Application::SetUpLogging()
         throw ReadyTraderGoError(message);
     }
 
+#ifdef RTG_ASYNC_LOGGING
+#ifdef NDEBUG
+    AsyncLogBackend::Start(std::make_unique<std::ofstream>(std::move(logStream)), LogLevel::LL_INFO);
+#else
+    AsyncLogBackend::Start(std::make_unique<std::ofstream>(std::move(logStream)), LogLevel::LL_DEBUG);
+#endif
+#else
     boost::shared_ptr<boost::log::core> core = logging::core::get();
     core->add_global_attribute("TimeStamp", attrs::local_clock());
 
@@ -145,6 +153,7 @@ void Application::SetUpLogging()
 #ifdef NDEBUG
     mSink->set_filter(rtg_severity > LogLevel::LL_DEBUG);
 #endif
+#endif
 }
 
 void Application::SignalHandler(const boost::system::error_code& error, int signal)
@@ -168,6 +177,9 @@ void Application::SignalHandler(const boost::system::error_code& error, int sign
 
 void Application::TearDownLogging()
 {
+#ifdef RTG_ASYNC_LOGGING
+    AsyncLogBackend::Stop();
+#endif
     if (mSink)
     {
         logging::core::get()->remove_sink(mSink);
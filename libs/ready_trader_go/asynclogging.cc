@@ -0,0 +1,253 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/date_time/c_time.hpp>
+
+#include "asynclogging.h"
+
+namespace ReadyTraderGo {
+
+// How long the logging thread sleeps when every queue is empty
+constexpr std::chrono::milliseconds ASYNC_LOG_IDLE_INTERVAL{1};
+
+// A level above every real one, so nothing is recorded
+constexpr int ASYNC_LOG_DISABLED = 0x100;
+
+namespace {
+
+struct AsyncLogState
+{
+    std::atomic<int> mMinimumLevel{ASYNC_LOG_DISABLED};
+    std::atomic<unsigned long> mDropped{0};
+    std::atomic<bool> mStopping{false};
+
+    // Queues are never freed, so a thread may keep logging to its queue
+    // after the logging thread has been stopped and restarted
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<AsyncLogQueue>> mQueues;
+    std::atomic<std::size_t> mQueueCount{0};
+
+    std::unique_ptr<std::ostream> mStream;
+    std::thread mThread;
+};
+
+AsyncLogState& getState()
+{
+    static AsyncLogState state;
+    return state;
+}
+
+thread_local AsyncLogQueue* threadQueue = nullptr;
+
+}
+
+static void writeTime(std::ostream& stream, std::int64_t time)
+{
+    const std::time_t seconds = time / 1000000000;
+    std::tm tm{};
+    boost::date_time::c_time::localtime(&seconds, &tm);
+
+    char text[64];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d.%06ld", tm.tm_year + 1900, tm.tm_mon + 1,
+                  tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<long>(time % 1000000000 / 1000));
+    stream << text;
+}
+
+static void writeRecord(std::ostream& stream, unsigned char const* record)
+{
+    AsyncLogRecordHeader header;
+    std::memcpy(&header, record, sizeof(header));
+
+    writeTime(stream, header.mTime);
+    stream << " [" << std::left << std::setw(7) << std::setfill(' ') << header.mLevel << "] ["
+           << header.mChannel << "] ";
+
+    std::size_t offset = sizeof(header);
+    while (offset < header.mSize)
+    {
+        AsyncLogFormatter formatter;
+        std::memcpy(&formatter, record + offset, sizeof(formatter));
+        offset += sizeof(formatter);
+        offset += formatter(stream, record + offset);
+    }
+    stream << '\n';
+}
+
+static void runLoggingThread(AsyncLogState& state)
+{
+    std::vector<AsyncLogQueue*> queues;
+    bool stopping = false;
+
+    for (;;)
+    {
+        if (queues.size() != state.mQueueCount.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(state.mMutex);
+            queues.clear();
+            for (auto& queue : state.mQueues)
+            {
+                queues.push_back(queue.get());
+            }
+        }
+
+        // Write the oldest record at the front of any queue, so that records
+        // from different threads come out in time order
+        AsyncLogQueue* oldest = nullptr;
+        std::int64_t oldestTime = 0;
+        for (auto* queue : queues)
+        {
+            if (auto const* record = queue->Front())
+            {
+                std::int64_t time;
+                std::memcpy(&time, record + offsetof(AsyncLogRecordHeader, mTime), sizeof(time));
+                if (oldest == nullptr || time < oldestTime)
+                {
+                    oldest = queue;
+                    oldestTime = time;
+                }
+            }
+        }
+
+        if (oldest != nullptr)
+        {
+            writeRecord(*state.mStream, oldest->Front());
+            oldest->Pop();
+            continue;
+        }
+
+        if (unsigned long dropped = state.mDropped.exchange(0, std::memory_order_relaxed))
+        {
+            auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            writeTime(*state.mStream, now);
+            *state.mStream << " [" << std::left << std::setw(7) << LogLevel::LL_WARNING << "] [LOG] " << dropped
+                           << " log records dropped because a queue was full\n";
+        }
+
+        // Only finish once the queues have been seen to be empty after the
+        // stop was requested
+        if (stopping)
+        {
+            break;
+        }
+        stopping = state.mStopping.load(std::memory_order_acquire);
+        if (!stopping)
+        {
+            state.mStream->flush();
+            std::this_thread::sleep_for(ASYNC_LOG_IDLE_INTERVAL);
+        }
+    }
+    state.mStream->flush();
+}
+
+std::size_t formatLogString(std::ostream& stream, unsigned char const* data)
+{
+    std::uint16_t length;
+    std::memcpy(&length, data, sizeof(length));
+    stream.write(reinterpret_cast<const char*>(data + sizeof(length)), length);
+    return sizeof(length) + length;
+}
+
+void AsyncLogBackend::Start(std::unique_ptr<std::ostream>&& stream, LogLevel minimumLevel)
+{
+    auto& state = getState();
+    Stop();
+    state.mStream = std::move(stream);
+    state.mStopping.store(false, std::memory_order_relaxed);
+    state.mThread = std::thread(runLoggingThread, std::ref(state));
+    state.mMinimumLevel.store(static_cast<int>(minimumLevel), std::memory_order_release);
+}
+
+void AsyncLogBackend::Stop()
+{
+    auto& state = getState();
+    state.mMinimumLevel.store(ASYNC_LOG_DISABLED, std::memory_order_release);
+    if (state.mThread.joinable())
+    {
+        state.mStopping.store(true, std::memory_order_release);
+        state.mThread.join();
+    }
+    state.mStream.reset();
+}
+
+AsyncLogQueue* AsyncLogBackend::GetQueue(LogLevel level) noexcept
+{
+    auto& state = getState();
+    if (static_cast<int>(level) < state.mMinimumLevel.load(std::memory_order_relaxed))
+    {
+        return nullptr;
+    }
+
+    if (threadQueue == nullptr)
+    {
+        try
+        {
+            auto queue = std::make_unique<AsyncLogQueue>();
+            std::lock_guard<std::mutex> lock(state.mMutex);
+            threadQueue = queue.get();
+            state.mQueues.push_back(std::move(queue));
+            state.mQueueCount.store(state.mQueues.size(), std::memory_order_release);
+        }
+        catch (const std::exception&)
+        {
+            return nullptr;
+        }
+    }
+    return threadQueue;
+}
+
+void AsyncLogBackend::RecordDropped() noexcept
+{
+    getState().mDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+AsyncLogRecord::AsyncLogRecord(LogLevel level, const char* channel) noexcept
+    : mQueue(AsyncLogBackend::GetQueue(level))
+{
+    if (mQueue == nullptr)
+    {
+        return;
+    }
+
+    mRecord = mQueue->Reserve();
+    if (mRecord == nullptr)
+    {
+        AsyncLogBackend::RecordDropped();
+        return;
+    }
+
+    AsyncLogRecordHeader header;
+    header.mTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.mChannel = channel;
+    header.mSize = 0;
+    header.mLevel = level;
+    std::memcpy(mRecord, &header, sizeof(header));
+}
+
+}
@@ -0,0 +1,235 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ASYNCLOGGING_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ASYNCLOGGING_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <type_traits>
+
+#include "logging.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// In the asynchronous logging mode, RLOG copies its arguments in binary form
+// into a fixed size record in a queue belonging to the calling thread, and a
+// logging thread formats the records and writes them to the log file. Each
+// queue has a single producer (its thread) and a single consumer (the
+// logging thread) so neither side takes a lock. Records that don't fit are
+// truncated and records logged while a queue is full are dropped.
+constexpr std::size_t ASYNC_LOG_RECORD_SIZE = 256;
+constexpr std::size_t ASYNC_LOG_QUEUE_SIZE = 1024;
+
+// Each record starts with a header, followed by its arguments. Each argument
+// is a pointer to the function that formats it, followed by its value.
+struct AsyncLogRecordHeader
+{
+    std::int64_t mTime;
+    const char* mChannel;
+    std::uint16_t mSize;
+    LogLevel mLevel;
+};
+
+using AsyncLogFormatter = std::size_t (*)(std::ostream&, unsigned char const*);
+
+constexpr std::size_t ASYNC_LOG_STRING_HEADER_SIZE = sizeof(AsyncLogFormatter) + sizeof(std::uint16_t);
+
+// Types whose values can safely be formatted later, on the logging thread.
+// Anything else (including pointers and types that refer to other objects)
+// is formatted straight away by the thread that logs it.
+template<typename T>
+struct IsDeferredLogValue : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>> {};
+
+template<typename Tag>
+struct IsDeferredLogValue<TypedLong<Tag>> : std::true_type {};
+
+class AsyncLogQueue
+{
+public:
+    // Return the next free record, or nullptr if the queue is full. The
+    // record is not visible to the logging thread until it is published.
+    unsigned char* Reserve() noexcept;
+    void Publish() noexcept;
+
+    // Return the oldest published record, or nullptr if there are none.
+    unsigned char const* Front() const noexcept;
+    void Pop() noexcept;
+
+private:
+    alignas(64) std::atomic<std::size_t> mHead{0};
+    alignas(64) std::atomic<std::size_t> mTail{0};
+    std::size_t mCachedHead = 0;
+    std::array<std::array<unsigned char, ASYNC_LOG_RECORD_SIZE>, ASYNC_LOG_QUEUE_SIZE> mRecords;
+};
+
+class AsyncLogBackend
+{
+public:
+    // Start the logging thread, which writes records at or above the given
+    // level to the given stream. Nothing is recorded until this is called.
+    static void Start(std::unique_ptr<std::ostream>&& stream, LogLevel minimumLevel);
+
+    // Stop recording, write everything still queued and join the logging
+    // thread.
+    static void Stop();
+
+    // Return the calling thread's queue if a record at the given level
+    // should be made, otherwise nullptr.
+    static AsyncLogQueue* GetQueue(LogLevel level) noexcept;
+
+    static void RecordDropped() noexcept;
+};
+
+// Captures the arguments of a single RLOG statement.
+class AsyncLogRecord
+{
+public:
+    AsyncLogRecord(LogLevel level, const char* channel) noexcept;
+
+    explicit operator bool() const noexcept { return mRecord != nullptr; }
+
+    void Publish() noexcept;
+
+    template<typename T>
+    AsyncLogRecord& operator<<(const T& value);
+
+private:
+    class FormatBuffer : public std::streambuf
+    {
+    public:
+        FormatBuffer(char* begin, char* end) { setp(begin, end); }
+        std::size_t Size() const { return pptr() - pbase(); }
+    };
+
+    void AppendString(const char* data, std::size_t size) noexcept;
+
+    AsyncLogQueue* mQueue;
+    unsigned char* mRecord = nullptr;
+    std::size_t mSize = sizeof(AsyncLogRecordHeader);
+};
+
+template<typename T>
+std::size_t formatLogValue(std::ostream& stream, unsigned char const* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    stream << value;
+    return sizeof(T);
+}
+
+std::size_t formatLogString(std::ostream& stream, unsigned char const* data);
+
+inline unsigned char* AsyncLogQueue::Reserve() noexcept
+{
+    const std::size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mCachedHead == ASYNC_LOG_QUEUE_SIZE)
+    {
+        mCachedHead = mHead.load(std::memory_order_acquire);
+        if (tail - mCachedHead == ASYNC_LOG_QUEUE_SIZE)
+        {
+            return nullptr;
+        }
+    }
+    return mRecords[tail % ASYNC_LOG_QUEUE_SIZE].data();
+}
+
+inline void AsyncLogQueue::Publish() noexcept
+{
+    mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+inline unsigned char const* AsyncLogQueue::Front() const noexcept
+{
+    const std::size_t head = mHead.load(std::memory_order_relaxed);
+    if (head == mTail.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    return mRecords[head % ASYNC_LOG_QUEUE_SIZE].data();
+}
+
+inline void AsyncLogQueue::Pop() noexcept
+{
+    mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+inline void AsyncLogRecord::Publish() noexcept
+{
+    auto size = static_cast<std::uint16_t>(mSize);
+    std::memcpy(mRecord + offsetof(AsyncLogRecordHeader, mSize), &size, sizeof(size));
+    mQueue->Publish();
+    mRecord = nullptr;
+}
+
+inline void AsyncLogRecord::AppendString(const char* data, std::size_t size) noexcept
+{
+    if (mSize + ASYNC_LOG_STRING_HEADER_SIZE > ASYNC_LOG_RECORD_SIZE)
+    {
+        return;
+    }
+
+    constexpr AsyncLogFormatter formatter = &formatLogString;
+    auto length = static_cast<std::uint16_t>(std::min(size, ASYNC_LOG_RECORD_SIZE - mSize - ASYNC_LOG_STRING_HEADER_SIZE));
+    std::memcpy(mRecord + mSize, &formatter, sizeof(formatter));
+    std::memcpy(mRecord + mSize + sizeof(formatter), &length, sizeof(length));
+    std::memmove(mRecord + mSize + ASYNC_LOG_STRING_HEADER_SIZE, data, length);
+    mSize += ASYNC_LOG_STRING_HEADER_SIZE + length;
+}
+
+template<typename T>
+AsyncLogRecord& AsyncLogRecord::operator<<(const T& value)
+{
+    if constexpr (IsDeferredLogValue<T>::value)
+    {
+        if (mSize + sizeof(AsyncLogFormatter) + sizeof(T) <= ASYNC_LOG_RECORD_SIZE)
+        {
+            constexpr AsyncLogFormatter formatter = &formatLogValue<T>;
+            std::memcpy(mRecord + mSize, &formatter, sizeof(formatter));
+            std::memcpy(mRecord + mSize + sizeof(formatter), &value, sizeof(T));
+            mSize += sizeof(formatter) + sizeof(T);
+        }
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+    {
+        std::string_view text = value;
+        AppendString(text.data(), text.size());
+    }
+    else if (mSize + ASYNC_LOG_STRING_HEADER_SIZE < ASYNC_LOG_RECORD_SIZE)
+    {
+        // Format the value now, straight into the space left in the record
+        auto* text = reinterpret_cast<char*>(mRecord + mSize + ASYNC_LOG_STRING_HEADER_SIZE);
+        FormatBuffer buffer(text, reinterpret_cast<char*>(mRecord + ASYNC_LOG_RECORD_SIZE));
+        std::ostream stream(&buffer);
+        stream << value;
+        AppendString(text, buffer.Size());
+    }
+    return *this;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ASYNCLOGGING_H
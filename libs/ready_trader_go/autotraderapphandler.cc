@@ -15,6 +15,7 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <chrono>
 #include <memory>
 
 #include <boost/property_tree/ptree.hpp>
@@ -42,9 +43,32 @@ void AutoTraderAppHandler::ConfigLoadedHandler(const boost::property_tree::ptree
                                                                  config.mExecPort);
     mInfoSubscriptionFactory = std::make_unique<SubscriptionFactory>(mContext,
                                                                      config.mInfoType,
-                                                                     config.mInfoName);
+                                                                     config.mInfoName,
+                                                                     subscriptionModeFromString(config.mInfoMode),
+                                                                     config.mInfoCpu);
+
+    if (config.mMessageFrequencyInterval <= 0.0 || config.mMessageFrequencyLimit == 0)
+        throw ReadyTraderGoError("configured message frequency limit must be positive");
+    if (config.mActiveOrderCountLimit == 0)
+        throw ReadyTraderGoError("configured active order count limit must be positive");
+    if (config.mActiveVolumeLimit == 0)
+        throw ReadyTraderGoError("configured active volume limit must be positive");
+    if (config.mPositionLimit <= 0)
+        throw ReadyTraderGoError("configured position limit must be positive");
+    if (config.mInfoStaleAfter <= 0.0)
+        throw ReadyTraderGoError("configured information stale-after time must be positive");
 
     mAutoTrader.SetLoginDetails(config.mTeamName, config.mSecret);
+    mAutoTrader.SetMessageFrequencyLimit(
+        std::chrono::duration_cast<FrequencyLimiter::Clock::duration>(
+            std::chrono::duration<double>(config.mMessageFrequencyInterval)),
+        config.mMessageFrequencyLimit);
+    mAutoTrader.SetActiveOrderCountLimit(config.mActiveOrderCountLimit);
+    mAutoTrader.SetActiveVolumeLimit(config.mActiveVolumeLimit);
+    mAutoTrader.SetPositionLimit(config.mPositionLimit);
+    mAutoTrader.SetStaleAfter(std::chrono::duration_cast<SequenceTracker::Clock::duration>(
+        std::chrono::duration<double>(config.mInfoStaleAfter)));
+    mAutoTrader.SetStrategy(config.mStrategy);
 }
 
 void AutoTraderAppHandler::ReadyToRunHandler()
@@ -15,6 +15,12 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <deque>
+
+#include <boost/asio/post.hpp>
+
 #include "baseautotrader.h"
 #include "error.h"
 #include "logging.h"
@@ -24,6 +30,14 @@ RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_BAT, "BASE")
 
 namespace ReadyTraderGo {
 
+template<typename T>
+static std::array<unsigned long, TOP_LEVEL_COUNT> widen(const std::array<T, TOP_LEVEL_COUNT>& values)
+{
+    std::array<unsigned long, TOP_LEVEL_COUNT> result;
+    std::copy(values.begin(), values.end(), result.begin());
+    return result;
+}
+
 void BaseAutoTrader::SetExecutionConnection(std::unique_ptr<IConnection>&& connection)
 {
     mExecutionConnection = std::move(connection);
@@ -36,6 +50,7 @@ void BaseAutoTrader::SetExecutionConnection(std::unique_ptr<IConnection>&& conne
 
     RLOG(LG_BAT, LogLevel::LL_INFO) << "logging in with teamname='" << mTeamName
                                     << "' and secret='" << mSecret << '\'';
+    mFrequencyLimiter.Admit();
     mExecutionConnection->SendMessage(MessageType::LOGIN,
                                       LoginMessage{mTeamName, mSecret});
 
@@ -83,6 +98,79 @@ void BaseAutoTrader::MessageHandler(IConnection* connection,
     }
 }
 
+void BaseAutoTrader::DisconnectHandler()
+{
+    for (auto instrument : {Instrument::FUTURE, Instrument::ETF})
+    {
+        for (auto type : {InformationType::ORDER_BOOK, InformationType::TRADE_TICKS})
+        {
+            const SequenceStats& stats = mSequenceTracker.GetStats(instrument, type);
+            RLOG(LG_BAT, LogLevel::LL_INFO) << instrument
+                                            << ((type == InformationType::ORDER_BOOK) ? " order book" : " trade ticks")
+                                            << " messages: received=" << stats.mMessageCount
+                                            << " gaps=" << stats.mGapCount
+                                            << " missed=" << stats.mMissedMessageCount
+                                            << " out_of_order=" << stats.mOutOfOrderCount;
+        }
+    }
+    mContext.stop();
+}
+
+void BaseAutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId, Price price, Volume volume)
+{
+    HedgeFilledMessageHandler(clientOrderId, static_cast<unsigned long>(price), static_cast<unsigned long>(volume));
+}
+
+void BaseAutoTrader::OrderBookMessageHandler(Instrument instrument,
+                                             unsigned long sequenceNumber,
+                                             const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                             const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                             const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                             const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    OrderBookMessageHandler(instrument, sequenceNumber, widen(askPrices), widen(askVolumes),
+                            widen(bidPrices), widen(bidVolumes));
+}
+
+void BaseAutoTrader::OrderBookMessageHandler(const OrderBookView& view)
+{
+    auto book = makeMessage<OrderBookMessage>(view.GetData(), view.GetSize());
+    OrderBookMessageHandler(book.mInstrument, book.mSequenceNumber, book.mAskPrices,
+                            book.mAskVolumes, book.mBidPrices, book.mBidVolumes);
+}
+
+void BaseAutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId, Price price, Volume volume)
+{
+    OrderFilledMessageHandler(clientOrderId, static_cast<unsigned long>(price), static_cast<unsigned long>(volume));
+}
+
+void BaseAutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
+                                               Volume fillVolume,
+                                               Volume remainingVolume,
+                                               signed long fees)
+{
+    OrderStatusMessageHandler(clientOrderId, static_cast<unsigned long>(fillVolume),
+                              static_cast<unsigned long>(remainingVolume), fees);
+}
+
+void BaseAutoTrader::TradeTicksMessageHandler(Instrument instrument,
+                                              unsigned long sequenceNumber,
+                                              const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                              const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                              const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                              const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    TradeTicksMessageHandler(instrument, sequenceNumber, widen(askPrices), widen(askVolumes),
+                             widen(bidPrices), widen(bidVolumes));
+}
+
+void BaseAutoTrader::TradeTicksMessageHandler(const TradeTicksView& view)
+{
+    auto ticks = makeMessage<TradeTicksMessage>(view.GetData(), view.GetSize());
+    TradeTicksMessageHandler(ticks.mInstrument, ticks.mSequenceNumber, ticks.mAskPrices,
+                             ticks.mAskVolumes, ticks.mBidPrices, ticks.mBidVolumes);
+}
+
 void BaseAutoTrader::MessageHandler(ISubscription* subscription,
                                     unsigned char messageType,
                                     unsigned char const* data,
@@ -92,16 +180,20 @@ void BaseAutoTrader::MessageHandler(ISubscription* subscription,
     {
     case MessageType::ORDER_BOOK_UPDATE:
     {
-        auto book = makeMessage<OrderBookMessage>(data, size);
-        OrderBookMessageHandler(book.mInstrument, book.mSequenceNumber, book.mAskPrices,
-                                book.mAskVolumes, book.mBidPrices, book.mBidVolumes);
+        OrderBookView book{data, size};
+        if (UpdateSequence(book, InformationType::ORDER_BOOK))
+        {
+            OrderBookMessageHandler(book);
+        }
         break;
     }
     case MessageType::TRADE_TICKS:
     {
-        auto ticks = makeMessage<TradeTicksMessage>(data, size);
-        TradeTicksMessageHandler(ticks.mInstrument, ticks.mSequenceNumber, ticks.mAskPrices,
-                                 ticks.mAskVolumes, ticks.mBidPrices, ticks.mBidVolumes);
+        TradeTicksView ticks{data, size};
+        if (UpdateSequence(ticks, InformationType::TRADE_TICKS))
+        {
+            TradeTicksMessageHandler(ticks);
+        }
         break;
     }
     default:
@@ -113,4 +205,152 @@ void BaseAutoTrader::MessageHandler(ISubscription* subscription,
     }
 }
 
+// Find a queued insert for the given order, if there is one.
+static std::deque<ScheduledOrder>::iterator findScheduledInsert(std::deque<ScheduledOrder>& inserts,
+                                                                unsigned long clientOrderId)
+{
+    return std::find_if(inserts.begin(), inserts.end(), [clientOrderId](const ScheduledOrder& order) {
+        return order.mClientOrderId == clientOrderId;
+    });
+}
+
+void BaseAutoTrader::ReleaseScheduledOrders()
+{
+    mIsScheduleTimerSet = false;
+
+    BeginBatch();
+    for (auto& queue : mScheduledOrders)
+    {
+        while (!queue.empty() && mFrequencyLimiter.Admit())
+        {
+            SendScheduledOrder(queue.front());
+            queue.pop_front();
+            --mScheduledOrderCount;
+        }
+    }
+    CommitBatch();
+
+    if (mScheduledOrderCount != 0)
+    {
+        SetScheduleTimer();
+    }
+}
+
+void BaseAutoTrader::ScheduleAmendOrder(unsigned long clientOrderId, Volume volume)
+{
+    auto& inserts = mScheduledOrders[static_cast<std::size_t>(OrderPriority::INSERT)];
+    auto it = findScheduledInsert(inserts, clientOrderId);
+    if (it == inserts.end())
+    {
+        ScheduleOrder({MessageType::AMEND_ORDER, clientOrderId, Side::SELL, 0, volume, Lifespan::FILL_AND_KILL});
+    }
+    else if (volume < it->mVolume)
+    {
+        it->mVolume = volume;
+        if (volume == 0)
+        {
+            inserts.erase(it);
+            ScheduledOrderDropped(clientOrderId);
+        }
+    }
+}
+
+void BaseAutoTrader::ScheduleCancelOrder(unsigned long clientOrderId)
+{
+    auto& inserts = mScheduledOrders[static_cast<std::size_t>(OrderPriority::INSERT)];
+    auto it = findScheduledInsert(inserts, clientOrderId);
+    if (it == inserts.end())
+    {
+        ScheduleOrder({MessageType::CANCEL_ORDER, clientOrderId, Side::SELL, 0, 0, Lifespan::FILL_AND_KILL});
+    }
+    else
+    {
+        inserts.erase(it);
+        ScheduledOrderDropped(clientOrderId);
+    }
+}
+
+void BaseAutoTrader::ScheduledOrderDropped(unsigned long clientOrderId)
+{
+    --mScheduledOrderCount;
+    RLOG(LG_BAT, LogLevel::LL_INFO) << "order " << clientOrderId << " cancelled before it was sent";
+
+    // Report the order as cancelled, but not from inside the call that
+    // cancelled it
+    boost::asio::post(mContext, [this, clientOrderId] {
+        OrderStatusMessageHandler(clientOrderId, Volume(0), Volume(0), 0);
+    });
+}
+
+void BaseAutoTrader::ScheduleOrder(const ScheduledOrder& order)
+{
+    auto priority = orderPriority(order.mMessageType);
+    if (!IsScheduledAhead(priority) && mFrequencyLimiter.Admit())
+    {
+        SendScheduledOrder(order);
+        return;
+    }
+
+    mScheduledOrders[static_cast<std::size_t>(priority)].push_back(order);
+    ++mScheduledOrderCount;
+    SetScheduleTimer();
+}
+
+void BaseAutoTrader::SendScheduledOrder(const ScheduledOrder& order)
+{
+    switch (order.mMessageType)
+    {
+    case MessageType::AMEND_ORDER:
+    {
+        WriteOrderMessage(order.mMessageType, AmendMessage{order.mClientOrderId, order.mVolume});
+        break;
+    }
+    case MessageType::CANCEL_ORDER:
+    {
+        WriteOrderMessage(order.mMessageType, CancelMessage{order.mClientOrderId});
+        break;
+    }
+    case MessageType::HEDGE_ORDER:
+    {
+        WriteOrderMessage(order.mMessageType,
+                          HedgeMessage{order.mClientOrderId, order.mSide, order.mPrice, order.mVolume});
+        break;
+    }
+    default:
+    {
+        WriteOrderMessage(order.mMessageType,
+                          InsertMessage{order.mClientOrderId, order.mSide, order.mPrice, order.mVolume,
+                                        order.mLifespan});
+        break;
+    }
+    }
+}
+
+void BaseAutoTrader::SetScheduleTimer()
+{
+    if (!mIsScheduleTimerSet)
+    {
+        mIsScheduleTimerSet = true;
+        mScheduleTimer.expires_at(mFrequencyLimiter.GetNextAdmitTime());
+        mScheduleTimer.async_wait([this](const boost::system::error_code& error) {
+            if (!error)
+            {
+                ReleaseScheduledOrders();
+            }
+        });
+    }
+}
+
+bool BaseAutoTrader::UpdateSequence(const TopLevelsView& view, InformationType type)
+{
+    const Instrument instrument = view.GetInstrument();
+    if (static_cast<std::size_t>(instrument) >= INSTRUMENT_COUNT)
+    {
+        RLOG(LG_BAT, LogLevel::LL_ERROR) << "received information message for unknown instrument: "
+                                         << static_cast<int>(instrument);
+        throw ReadyTraderGoError("received information message for unknown instrument");
+    }
+    return mSequenceTracker.Update(instrument, type, view.GetSequenceNumber(), SequenceTracker::Clock::now());
+}
+
 }
\ No newline at end of file
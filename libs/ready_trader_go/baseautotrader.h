@@ -20,39 +20,134 @@
 
 #include <array>
 #include <cstddef>
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/property_tree/ptree.hpp>
 
 #include "connectivitytypes.h"
+#include "frequencylimiter.h"
 #include "protocol.h"
+#include "riskengine.h"
+#include "sequencetracker.h"
+#include "traderclock.h"
 #include "types.h"
 
 namespace ReadyTraderGo {
 
+// Order messages waiting for the message frequency limit are sent in this
+// order of priority.
+enum class OrderPriority : unsigned char
+{
+    HEDGE,
+    CANCEL,
+    INSERT
+};
+
+constexpr std::size_t ORDER_PRIORITY_COUNT = 3;
+
+constexpr OrderPriority orderPriority(unsigned char messageType)
+{
+    switch (messageType)
+    {
+    case MessageType::HEDGE_ORDER:
+        return OrderPriority::HEDGE;
+    case MessageType::AMEND_ORDER:
+    case MessageType::CANCEL_ORDER:
+        return OrderPriority::CANCEL;
+    default:
+        return OrderPriority::INSERT;
+    }
+}
+
+// An order message waiting to be sent. Only the fields that apply to its
+// message type are used.
+struct ScheduledOrder
+{
+    unsigned char mMessageType;
+    unsigned long mClientOrderId;
+    Side mSide;
+    Price mPrice;
+    Volume mVolume;
+    Lifespan mLifespan;
+};
+
 class BaseAutoTrader
 {
 public:
-    explicit BaseAutoTrader(boost::asio::io_context& context) : mContext(context) {};
+    explicit BaseAutoTrader(boost::asio::io_context& context) : mContext(context), mScheduleTimer(context) {};
+
+    // Order messages sent between BeginBatch and CommitBatch are held back and
+    // then written to the exchange together, in the order they were sent.
+    // Batches may be nested, in which case only the outermost CommitBatch
+    // sends anything.
+    void BeginBatch() { ++mBatchDepth; }
+    void CommitBatch(SendMode mode = SendMode::ASAP);
 
-    virtual void SendAmendOrder(unsigned long clientOrderId, unsigned long volume);
-    virtual void SendCancelOrder(unsigned long clientOrderId);
-    virtual void SendHedgeOrder(unsigned long clientOrderId,
+    // Each of these returns false, without sending anything, if the message
+    // would breach the exchange's message frequency limit.
+    virtual bool SendAmendOrder(unsigned long clientOrderId, Volume volume);
+    virtual bool SendCancelOrder(unsigned long clientOrderId);
+    virtual bool SendHedgeOrder(unsigned long clientOrderId,
                                 Side side,
-                                unsigned long price,
-                                unsigned long volume);
-    virtual void SendInsertOrder(unsigned long clientOrderId,
+                                Price price,
+                                Volume volume);
+    virtual bool SendInsertOrder(unsigned long clientOrderId,
                                  Side side,
-                                 unsigned long price,
-                                 unsigned long volume,
+                                 Price price,
+                                 Volume volume,
                                  Lifespan lifespan);
 
+    // Like the Send* methods, except that a message the message frequency
+    // limit won't allow yet is queued instead of refused. A timer sends
+    // queued messages as soon as the limit allows: hedges first, then
+    // cancels and amends, then inserts, each in the order they were
+    // scheduled. While messages are queued, Send* calls with the same or a
+    // lower priority are refused so that they can't overtake them.
+    //
+    // Cancelling or amending an insert that is still queued changes the
+    // queued insert instead; if that leaves nothing to insert, the order is
+    // dropped and OrderStatusMessageHandler is called as if it had been
+    // cancelled.
+    virtual void ScheduleAmendOrder(unsigned long clientOrderId, Volume volume);
+    virtual void ScheduleCancelOrder(unsigned long clientOrderId);
+    virtual void ScheduleHedgeOrder(unsigned long clientOrderId,
+                                    Side side,
+                                    Price price,
+                                    Volume volume);
+    virtual void ScheduleInsertOrder(unsigned long clientOrderId,
+                                     Side side,
+                                     Price price,
+                                     Volume volume,
+                                     Lifespan lifespan);
+
+    std::size_t GetActiveOrderCountLimit() const noexcept { return mRiskEngine.GetActiveOrderCountLimit(); }
+    const RiskEngine& GetRiskEngine() const noexcept { return mRiskEngine; }
+    std::size_t GetScheduledOrderCount() const noexcept { return mScheduledOrderCount; }
+    const SequenceTracker& GetSequenceTracker() const noexcept { return mSequenceTracker; }
+
+    // Return true if the instrument's latest order book is older than the
+    // configured limit, or older than the other instrument's.
+    bool IsStale(Instrument instrument) const { return mSequenceTracker.IsStale(instrument); }
+
+    // Called before the connections are made, with the exchange's limit on
+    // the number of active orders, so that order tables can be sized to it.
+    virtual void SetActiveOrderCountLimit(std::size_t limit) { mRiskEngine.SetActiveOrderCountLimit(limit); }
+    virtual void SetActiveVolumeLimit(unsigned long limit) { mRiskEngine.SetActiveVolumeLimit(limit); }
     virtual void SetExecutionConnection(std::unique_ptr<IConnection>&& connection);
     virtual void SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription);
     virtual void SetLoginDetails(std::string teamName, std::string secret);
+    virtual void SetMessageFrequencyLimit(FrequencyLimiter::Clock::duration interval, std::size_t limit);
+    virtual void SetPositionLimit(long limit) { mRiskEngine.SetPositionLimit(limit); }
+    virtual void SetStaleAfter(SequenceTracker::Clock::duration staleAfter) { mSequenceTracker.SetStaleAfter(staleAfter); }
+    // Called before the connections are made with the configuration's
+    // Strategy section (empty if there isn't one), for an auto-trader to read
+    // its own parameters from
+    virtual void SetStrategy(const boost::property_tree::ptree& strategy) {}
 
 protected:
     boost::asio::io_context& mContext;
@@ -62,6 +157,38 @@ protected:
     std::string mTeamName;
     std::string mSecret;
 
+    int mBatchDepth = 0;
+    FrequencyLimiter mFrequencyLimiter{DEFAULT_MESSAGE_FREQUENCY_INTERVAL, DEFAULT_MESSAGE_FREQUENCY_LIMIT};
+
+    // Order book and trade ticks messages that are no later than the last of
+    // the same type for the same instrument are counted here and dropped
+    SequenceTracker mSequenceTracker;
+
+    // Positions and active orders, kept up to date and consulted by the
+    // auto-trader's order wrappers
+    RiskEngine mRiskEngine;
+
+    std::array<std::deque<ScheduledOrder>, ORDER_PRIORITY_COUNT> mScheduledOrders;
+    std::size_t mScheduledOrderCount = 0;
+    TraderTimer mScheduleTimer;
+    bool mIsScheduleTimerSet = false;
+
+    bool IsScheduledAhead(OrderPriority priority) const noexcept;
+    void ReleaseScheduledOrders();
+    void ScheduleOrder(const ScheduledOrder& order);
+    void ScheduledOrderDropped(unsigned long clientOrderId);
+    void SendScheduledOrder(const ScheduledOrder& order);
+    void SetScheduleTimer();
+
+    // Record an information message's sequence number, returning false if it
+    // is late and should be dropped
+    bool UpdateSequence(const TopLevelsView& view, InformationType type);
+
+    template<typename T>
+    bool SendOrderMessage(unsigned char messageType, const T& message);
+    template<typename T>
+    void WriteOrderMessage(unsigned char messageType, const T& message);
+
     virtual void DisconnectHandler();
     virtual void MessageHandler(IConnection*, unsigned char, unsigned char const*, std::size_t);
     virtual void MessageHandler(ISubscription* subscription,
@@ -72,6 +199,39 @@ protected:
     // Message callbacks
     virtual void ErrorMessageHandler(unsigned long clientOrderId,
                                      const std::string& errorMessage) {};
+    virtual void HedgeFilledMessageHandler(unsigned long clientOrderId,
+                                           Price price,
+                                           Volume volume);
+    // Called when the information subscription falls so far behind that the
+    // exchange overwrites messages before they are read. The missed messages
+    // are lost and the subscription resumes from the most recent one.
+    virtual void InformationGapHandler(unsigned long missedMessages) {};
+    virtual void OrderBookMessageHandler(Instrument instrument,
+                                         unsigned long sequenceNumber,
+                                         const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                         const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                         const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                         const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes);
+    virtual void OrderBookMessageHandler(const OrderBookView& book);
+    virtual void OrderFilledMessageHandler(unsigned long clientOrderId,
+                                           Price price,
+                                           Volume volume);
+    virtual void OrderStatusMessageHandler(unsigned long clientOrderId,
+                                           Volume fillVolume,
+                                           Volume remainingVolume,
+                                           signed long fees);
+    virtual void TradeTicksMessageHandler(Instrument instrument,
+                                          unsigned long sequenceNumber,
+                                          const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                          const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                          const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                          const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes);
+    virtual void TradeTicksMessageHandler(const TradeTicksView& ticks);
+
+    // Compatibility callbacks for auto-traders written against the original
+    // unsigned long prices and volumes. The default implementations of the
+    // callbacks above widen their arguments and call these, so an existing
+    // override keeps working (at the cost of the extra copy).
     virtual void HedgeFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long price,
                                            unsigned long volume) {};
@@ -96,15 +256,48 @@ protected:
                                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes) {};
 };
 
-inline void BaseAutoTrader::DisconnectHandler()
+inline void BaseAutoTrader::CommitBatch(SendMode mode)
+{
+    if (mBatchDepth > 0 && --mBatchDepth == 0)
+    {
+        mExecutionConnection->CommitMessage(mode);
+    }
+}
+
+inline bool BaseAutoTrader::IsScheduledAhead(OrderPriority priority) const noexcept
+{
+    for (std::size_t i = 0; i <= static_cast<std::size_t>(priority); ++i)
+    {
+        if (!mScheduledOrders[i].empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void BaseAutoTrader::ScheduleHedgeOrder(unsigned long clientOrderId,
+                                               Side side,
+                                               Price price,
+                                               Volume volume)
+{
+    ScheduleOrder({MessageType::HEDGE_ORDER, clientOrderId, side, price, volume, Lifespan::FILL_AND_KILL});
+}
+
+inline void BaseAutoTrader::ScheduleInsertOrder(unsigned long clientOrderId,
+                                                Side side,
+                                                Price price,
+                                                Volume volume,
+                                                Lifespan lifespan)
 {
-    mContext.stop();
+    ScheduleOrder({MessageType::INSERT_ORDER, clientOrderId, side, price, volume, lifespan});
 }
 
 inline void BaseAutoTrader::SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription)
 {
     mInformationSubscription = std::move(subscription);
     mInformationSubscription->SetName("Info");
+    mInformationSubscription->GapDetected = [this](ISubscription*, unsigned long n) { InformationGapHandler(n); };
     mInformationSubscription->MessageReceived = [this](ISubscription* s,
                                                        unsigned char t,
                                                        unsigned char const* d,
@@ -112,42 +305,62 @@ inline void BaseAutoTrader::SetInformationSubscription(std::shared_ptr<ISubscrip
     mInformationSubscription->AsyncReceive();
 }
 
-inline void BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId, unsigned long volume)
+inline bool BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId, Volume volume)
 {
-    mExecutionConnection->SendMessage(MessageType::AMEND_ORDER,
-                                      AmendMessage{clientOrderId, volume});
+    return SendOrderMessage(MessageType::AMEND_ORDER, AmendMessage{clientOrderId, volume});
 }
 
-inline void BaseAutoTrader::SendCancelOrder(unsigned long clientOrderId)
+inline bool BaseAutoTrader::SendCancelOrder(unsigned long clientOrderId)
 {
-    mExecutionConnection->SendMessage(MessageType::CANCEL_ORDER,
-                                      CancelMessage{clientOrderId});
+    return SendOrderMessage(MessageType::CANCEL_ORDER, CancelMessage{clientOrderId});
 }
 
-inline void BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId,
+inline bool BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId,
                                            Side side,
-                                           unsigned long price,
-                                           unsigned long volume)
+                                           Price price,
+                                           Volume volume)
 {
-    mExecutionConnection->SendMessage(MessageType::HEDGE_ORDER,
-                                      HedgeMessage{clientOrderId,
-                                                   side,
-                                                   price,
-                                                   volume});
+    return SendOrderMessage(MessageType::HEDGE_ORDER, HedgeMessage{clientOrderId,
+                                                            side,
+                                                            price,
+                                                            volume});
 }
 
-inline void BaseAutoTrader::SendInsertOrder(unsigned long clientOrderId,
+inline bool BaseAutoTrader::SendInsertOrder(unsigned long clientOrderId,
                                             Side side,
-                                            unsigned long price,
-                                            unsigned long volume,
+                                            Price price,
+                                            Volume volume,
                                             Lifespan lifespan)
 {
-    mExecutionConnection->SendMessage(MessageType::INSERT_ORDER,
-                                      InsertMessage{clientOrderId,
-                                                    side,
-                                                    price,
-                                                    volume,
-                                                    lifespan});
+    return SendOrderMessage(MessageType::INSERT_ORDER, InsertMessage{clientOrderId,
+                                                              side,
+                                                              price,
+                                                              volume,
+                                                              lifespan});
+}
+
+template<typename T>
+inline bool BaseAutoTrader::SendOrderMessage(unsigned char messageType, const T& message)
+{
+    if ((mScheduledOrderCount != 0 && IsScheduledAhead(orderPriority(messageType)))
+        || !mFrequencyLimiter.Admit())
+    {
+        return false;
+    }
+    WriteOrderMessage(messageType, message);
+    return true;
+}
+
+template<typename T>
+inline void BaseAutoTrader::WriteOrderMessage(unsigned char messageType, const T& message)
+{
+    // The order messages are final, so these calls are bound statically and
+    // the fields are written straight into the connection's send buffer.
+    message.Serialise(mExecutionConnection->PrepareMessage(messageType, message.Size()));
+    if (mBatchDepth == 0)
+    {
+        mExecutionConnection->CommitMessage(SendMode::ASAP);
+    }
 }
 
 inline void BaseAutoTrader::SetLoginDetails(std::string teamName, std::string secret)
@@ -156,6 +369,11 @@ inline void BaseAutoTrader::SetLoginDetails(std::string teamName, std::string se
     mSecret = std::move(secret);
 }
 
+inline void BaseAutoTrader::SetMessageFrequencyLimit(FrequencyLimiter::Clock::duration interval, std::size_t limit)
+{
+    mFrequencyLimiter = FrequencyLimiter(interval, limit);
+}
+
 }
 
 #endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BASEAUTOTRADER_H
@@ -33,6 +33,17 @@ struct Config
 
         mInfoType = tree.get<std::string>("Information.Type");
         mInfoName = tree.get<std::string>("Information.Name");
+        mInfoMode = tree.get<std::string>("Information.Mode", "spin");
+        mInfoCpu = tree.get<int>("Information.Cpu", -1);
+        mInfoStaleAfter = tree.get<double>("Information.StaleAfter", 0.5);
+
+        mMessageFrequencyInterval = tree.get<double>("Limits.MessageFrequencyInterval", 1.0);
+        mMessageFrequencyLimit = tree.get<unsigned long>("Limits.MessageFrequencyLimit", 50);
+        mActiveOrderCountLimit = tree.get<unsigned long>("Limits.ActiveOrderCountLimit", 10);
+        mActiveVolumeLimit = tree.get<unsigned long>("Limits.ActiveVolumeLimit", 200);
+        mPositionLimit = tree.get<long>("Limits.PositionLimit", 100);
+
+        mStrategy = tree.get_child("Strategy", boost::property_tree::ptree());
 
         mTeamName = tree.get<std::string>("TeamName");
         mSecret = tree.get<std::string>("Secret");
@@ -43,6 +54,18 @@ struct Config
 
     std::string mInfoType;
     std::string mInfoName;
+    std::string mInfoMode;
+    int mInfoCpu;
+    double mInfoStaleAfter;
+
+    double mMessageFrequencyInterval;
+    unsigned long mMessageFrequencyLimit;
+    unsigned long mActiveOrderCountLimit;
+    unsigned long mActiveVolumeLimit;
+    long mPositionLimit;
+
+    // The auto-trader's own parameters, which it reads itself
+    boost::property_tree::ptree mStrategy;
 
     std::string mTeamName;
     std::string mSecret;
@@ -15,12 +15,23 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstring>
 #include <iomanip>
 #include <memory>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <boost/asio/connect.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/error.hpp>
@@ -44,15 +55,14 @@ RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_CON, "CON")
 
 namespace ReadyTraderGo {
 
-// Theoretical maximum size of an (IPv4) UDP packet (actual maximum is lower).
-constexpr std::size_t READ_SIZE = 65535;
-
 Connection::Connection(boost::asio::io_context& context, tcp::socket&& socket)
     : mContext(context),
-      mInBuffer(),
-      mOutBuffer(),
+      mInBuffer(RECEIVE_BUFFER_SIZE),
+      mOutBuffer(SEND_BUFFER_SIZE),
+      mHeldBuffer(SEND_BUFFER_SIZE),
       mSocket(std::move(socket))
 {
+    mSocket.non_blocking(true);
     SetName('\'' + std::to_string(mSocket.local_endpoint().port()) + '\'');
 }
 
@@ -67,7 +77,7 @@ Connection::~Connection()
 
 void Connection::AsyncRead()
 {
-    auto buf = mInBuffer.prepare(READ_SIZE);
+    auto buf = boost::asio::buffer(mInBuffer.data() + mInBufferSize, mInBuffer.size() - mInBufferSize);
     mSocket.async_read_some(
         buf,
         [this](auto& error, auto size) { ReadSomeHandler(error, size); });
@@ -99,15 +109,22 @@ void Connection::ReadSomeHandler(const boost::system::error_code& error, std::si
 
     RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " received " << size
                                      << " bytes";
-    mInBuffer.commit(size);
+    mInBufferSize += size;
 
-    auto* const begin = (unsigned char const*) mInBuffer.data().data();
+    auto* const begin = mInBuffer.data();
     auto* upto = begin;
-    auto available = size;
+    auto available = mInBufferSize;
 
     while (available >= MESSAGE_HEADER_SIZE)
     {
-        const std::size_t messageLength = boost::endian::big_to_native(*(uint16_t*)upto);
+        const std::size_t messageLength = boost::endian::load_big_u16(upto);
+        if (messageLength < MESSAGE_HEADER_SIZE)
+        {
+            RLOG(LG_CON, LogLevel::LL_ERROR) << std::quoted(mName, '\'')
+                                             << " received malformed message with length=" << messageLength;
+            OnDisconnect();
+            return;
+        }
         if (available < messageLength)
             break;
 
@@ -121,15 +138,54 @@ void Connection::ReadSomeHandler(const boost::system::error_code& error, std::si
         available -= messageLength;
     }
 
-    mInBuffer.consume(upto - begin);
+    // Move what remains of a partially received message to the front of the
+    // buffer so that it is contiguous once the rest of it arrives.
+    if (available != 0 && upto != begin)
+    {
+        std::memmove(begin, upto, available);
+    }
+    mInBufferSize = available;
     AsyncRead();
 }
 
+void Connection::CommitMessage(SendMode mode)
+{
+    if (!mIsSending && mOutBufferEnd != mOutBufferBegin)
+    {
+        Send(mode);
+    }
+}
+
+unsigned char* Connection::PrepareMessage(unsigned char messageType, std::size_t size)
+{
+    const std::size_t length = MESSAGE_HEADER_SIZE + size;
+    auto& buffer = mIsSending ? mHeldBuffer : mOutBuffer;
+    auto& end = mIsSending ? mHeldBufferEnd : mOutBufferEnd;
+    if (end + length > buffer.size())
+    {
+        // Neither buffer is being written from right now, so it's safe to
+        // grow this one.
+        RLOG(LG_CON, LogLevel::LL_WARNING) << std::quoted(mName, '\'') << " send buffer full with "
+                                           << end << " bytes unsent";
+        buffer.resize(std::max(2 * buffer.size(), end + length));
+    }
+
+    unsigned char* data = buffer.data() + end;
+    boost::endian::store_big_u16(data, static_cast<uint16_t>(length));
+    data[MESSAGE_TYPE_OFFSET] = messageType;
+    end += length;
+    return data + MESSAGE_HEADER_SIZE;
+}
+
 void Connection::Send()
 {
+    // The socket is non-blocking, so write whatever the kernel will take
+    // straight away and leave the rest to an asynchronous write.
+    boost::system::error_code error;
+    auto buf = boost::asio::buffer(mOutBuffer.data() + mOutBufferBegin, mOutBufferEnd - mOutBufferBegin);
+    const std::size_t size = mSocket.write_some(buf, error);
     mIsSending = true;
-    mSocket.async_write_some(mOutBuffer.data(),
-                             [this](auto& err, auto sz) { WriteSomeHandler(err, sz); });
+    WriteSomeHandler(error, size);
 }
 
 void Connection::Send(SendMode mode)
@@ -142,7 +198,7 @@ void Connection::Send(SendMode mode)
     {
         boost::asio::post(mContext, [this] {
             mIsSendPosted = false;
-            if (!mIsSending)
+            if (!mIsSending && mOutBufferEnd != mOutBufferBegin)
             {
                 Send();
             }
@@ -151,21 +207,6 @@ void Connection::Send(SendMode mode)
     }
 }
 
-void Connection::SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode)
-{
-    const std::size_t size = MESSAGE_HEADER_SIZE + serialisable.Size();
-    auto buf = mOutBuffer.prepare(size);
-    auto* data = static_cast<unsigned char*>(buf.data());
-    *(uint16_t*)data = boost::endian::native_to_big((uint16_t)size);
-    data[MESSAGE_TYPE_OFFSET] = messageType;
-    serialisable.Serialise(data + MESSAGE_HEADER_SIZE);
-    mOutBuffer.commit(size);
-    if (!mIsSending)
-    {
-        Send(mode);
-    }
-}
-
 void Connection::WriteSomeHandler(const boost::system::error_code& error, std::size_t size)
 {
     if (error)
@@ -183,22 +224,63 @@ void Connection::WriteSomeHandler(const boost::system::error_code& error, std::s
     {
         RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " sent "
                                          << size << " bytes";
-        mOutBuffer.consume(size);
+        mOutBufferBegin += size;
     }
 
-    if (mOutBuffer.size() > 0)
+    if (mOutBufferBegin != mOutBufferEnd)
     {
-        mSocket.async_write_some(
-            mOutBuffer.data(), [this](auto& err, auto sz) { WriteSomeHandler(err, sz); });
+        auto buf = boost::asio::buffer(mOutBuffer.data() + mOutBufferBegin, mOutBufferEnd - mOutBufferBegin);
+        mSocket.async_write_some(buf, [this](auto& err, auto sz) { WriteSomeHandler(err, sz); });
+    }
+    else if (mHeldBufferEnd != 0)
+    {
+        // Messages prepared during the write were held back, so send them next.
+        std::swap(mOutBuffer, mHeldBuffer);
+        mOutBufferBegin = 0;
+        mOutBufferEnd = mHeldBufferEnd;
+        mHeldBufferEnd = 0;
+        Send();
     }
     else
     {
+        mOutBufferBegin = mOutBufferEnd = 0;
         mIsSending = false;
     }
 }
 
-Subscription::Subscription(boost::asio::io_context& context, interprocess::file_mapping& file, interprocess::mapped_region& region)
-    : mContext(context), mFile(std::move(file)), mRegion(std::move(region))
+SubscriptionMode subscriptionModeFromString(const std::string& name)
+{
+    if (name == "spin")
+        return SubscriptionMode::SPIN;
+    if (name == "backoff")
+        return SubscriptionMode::BACKOFF;
+    if (name == "thread")
+        return SubscriptionMode::THREAD;
+    throw ReadyTraderGoError("unknown subscription mode: '" + name + "'");
+}
+
+// The transport buffer is written by another process, so frame headers must be
+// re-read from memory on every poll and the rest of a frame read only after
+// its flag has been seen to be set.
+static inline uint32_t readFrameHeader(unsigned char const* frame)
+{
+    const uint32_t header = *(volatile uint32_t const*)frame;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return boost::endian::little_to_native(header);
+}
+
+Subscription::Subscription(boost::asio::io_context& context,
+                           interprocess::file_mapping& file,
+                           interprocess::mapped_region& region,
+                           SubscriptionMode mode,
+                           int cpu)
+    : mContext(context),
+      mFile(std::move(file)),
+      mRegion(std::move(region)),
+      mMode(mode),
+      mCpu(cpu),
+      mTimer(context),
+      mWorkGuard(boost::asio::make_work_guard(context))
 {
     SetName(std::string(mFile.get_name()));
 }
@@ -206,15 +288,26 @@ Subscription::Subscription(boost::asio::io_context& context, interprocess::file_
 Subscription::~Subscription()
 {
     RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'') << " closing";
+    mStopping = true;
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+    mWorkGuard.reset();
 }
 
 void Subscription::AsyncReceive()
 {
     std::weak_ptr<ISubscription> weak_this = shared_from_this();
-    mContext.post([this, weak_this](){ AsyncReceive(0, weak_this); });
+    if (mMode == SubscriptionMode::THREAD)
+    {
+        mThread = std::thread([this, weak_this]() { PollThread(weak_this); });
+        return;
+    }
+    boost::asio::post(mContext, [this, weak_this]() { AsyncReceive(weak_this); });
 }
 
-void Subscription::AsyncReceive(unsigned long pos, std::weak_ptr<ISubscription> weak_this)
+void Subscription::AsyncReceive(std::weak_ptr<ISubscription> weak_this)
 {
     if (weak_this.expired())
     {
@@ -222,17 +315,189 @@ void Subscription::AsyncReceive(unsigned long pos, std::weak_ptr<ISubscription>
         return;
     }
 
-    unsigned char* addr = ((unsigned char*)mRegion.get_address()) + pos;
+    unsigned long missedFrames;
+    const std::size_t payloadSize = NextFrame(mFrame.data(), missedFrames);
+    if (missedFrames != 0)
+    {
+        OnGap(missedFrames);
+    }
 
-    if (addr[0] != 0)
+    if (payloadSize != 0)
     {
-        const uint32_t* payload_size_ptr = (uint32_t*)(addr + FRAME_PAYLOAD_SIZE_OFFSET);
-        const std::size_t payloadSize = boost::endian::big_to_native(*payload_size_ptr);
-        ReceiveFromHandler(addr + FRAME_HEADER_SIZE, payloadSize);
-        pos = (pos + FRAME_SIZE) & (SUBSCRIPTION_TRANSPORT_BUFFER_SIZE - 1);
+        ReceiveFromHandler(mFrame.data(), payloadSize);
+        mIdleCount = 0;
+        mBackOff = SUBSCRIPTION_MIN_BACKOFF;
     }
+    else if (mMode == SubscriptionMode::BACKOFF && ++mIdleCount >= SUBSCRIPTION_SPIN_COUNT)
+    {
+        BackOff(std::move(weak_this));
+        return;
+    }
+
+    boost::asio::post(mContext, [this, weak_this]() { AsyncReceive(weak_this); });
+}
+
+void Subscription::BackOff(std::weak_ptr<ISubscription> weak_this)
+{
+    mTimer.expires_after(mBackOff);
+    mTimer.async_wait([this, weak_this](const boost::system::error_code& error) {
+        if (!error)
+        {
+            AsyncReceive(weak_this);
+        }
+    });
+    mBackOff = std::min(mBackOff * 2, SUBSCRIPTION_MAX_BACKOFF);
+}
+
+std::size_t Subscription::NextFrame(unsigned char* payload, unsigned long& missedFrames)
+{
+    missedFrames = 0;
 
-    mContext.post([this, pos, weak_this](){ AsyncReceive(pos, weak_this); });
+    auto* addr = ((unsigned char const*)mRegion.get_address()) + mPosition;
+    uint32_t header = readFrameHeader(addr);
+    if ((header & FRAME_FLAG_MASK) == 0)
+    {
+        return 0;
+    }
+
+    const uint32_t generation = header >> FRAME_GENERATION_SHIFT;
+    if (generation != mGeneration && mFrameGenerations == FrameGenerations::UNKNOWN)
+    {
+        // Once we have wrapped around the buffer, a publisher still writing
+        // generation zero doesn't write generations at all (the stock
+        // pubsub.py doesn't), so frames are just read in turn from then on.
+        mFrameGenerations = (generation != 0) ? FrameGenerations::WRITTEN : FrameGenerations::NOT_WRITTEN;
+        if (mFrameGenerations == FrameGenerations::NOT_WRITTEN)
+        {
+            RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'')
+                                            << " publisher does not write frame generations";
+        }
+    }
+
+    if (generation != mGeneration && mFrameGenerations == FrameGenerations::WRITTEN)
+    {
+        // The publisher has lapped us, so this frame is not the one we
+        // expected and older frames are already lost. If this is the first
+        // frame, we simply joined late and nothing we could have seen is lost.
+        const unsigned long skippedFrames = Resynchronise();
+        if (mIsSynchronised)
+        {
+            missedFrames = skippedFrames;
+            RLOG(LG_CON, LogLevel::LL_WARNING) << std::quoted(mName, '\'') << " overrun by publisher, skipped "
+                                               << missedFrames << " frames";
+        }
+        addr = ((unsigned char const*)mRegion.get_address()) + mPosition;
+        header = readFrameHeader(addr);
+        if ((header & FRAME_FLAG_MASK) == 0 || (header >> FRAME_GENERATION_SHIFT) != mGeneration)
+        {
+            return 0;
+        }
+    }
+
+    std::size_t payloadSize = boost::endian::big_to_native(*(uint32_t const*)(addr + FRAME_PAYLOAD_SIZE_OFFSET));
+    payloadSize = std::min(payloadSize, MAXIMUM_PAYLOAD_SIZE);
+    std::memcpy(payload, addr + FRAME_HEADER_SIZE, payloadSize);
+
+    // If the header changed while the payload was being copied, the publisher
+    // has started to overwrite this frame and the copy may be torn. The next
+    // poll will see the new generation and resynchronise.
+    if (readFrameHeader(addr) != header)
+    {
+        return 0;
+    }
+
+    mPosition = (mPosition + FRAME_SIZE) & (SUBSCRIPTION_TRANSPORT_BUFFER_SIZE - 1);
+    if (mPosition == 0)
+    {
+        mGeneration = (mGeneration + 1) & FRAME_GENERATION_MASK;
+    }
+    mIsSynchronised = true;
+    return payloadSize;
+}
+
+unsigned long Subscription::Resynchronise()
+{
+    auto* base = (unsigned char const*)mRegion.get_address();
+
+    // The frame the publisher will write next is the only one with its flag
+    // clear, so the most recently published frame is the one before it.
+    for (std::size_t next = 0; next < FRAME_COUNT; ++next)
+    {
+        if ((readFrameHeader(base + next * FRAME_SIZE) & FRAME_FLAG_MASK) != 0)
+        {
+            continue;
+        }
+
+        const std::size_t latest = (next + FRAME_COUNT - 1) % FRAME_COUNT;
+        const uint32_t header = readFrameHeader(base + latest * FRAME_SIZE);
+        if ((header & FRAME_FLAG_MASK) == 0)
+        {
+            return 0;
+        }
+
+        const uint32_t generation = header >> FRAME_GENERATION_SHIFT;
+        const unsigned long expected = mGeneration * FRAME_COUNT + mPosition / FRAME_SIZE;
+        const unsigned long actual = generation * FRAME_COUNT + latest;
+        mPosition = latest * FRAME_SIZE;
+        mGeneration = generation;
+        return (actual - expected) & (FRAME_SEQUENCE_MASK);
+    }
+
+    return 0;
+}
+
+void Subscription::PollThread(std::weak_ptr<ISubscription> weak_this)
+{
+#ifdef __linux__
+    if (mCpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(mCpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+        {
+            RLOG(LG_CON, LogLevel::LL_WARNING) << std::quoted(mName, '\'')
+                                               << " failed to pin subscription thread to cpu " << mCpu;
+        }
+    }
+#endif
+
+    unsigned idleCount = 0;
+    while (!mStopping.load(std::memory_order_relaxed))
+    {
+        // The frame is copied before it is handed over because the publisher
+        // may overwrite it before the io_context gets around to handling it.
+        std::array<unsigned char, MAXIMUM_PAYLOAD_SIZE> frame;
+        unsigned long missedFrames;
+        const std::size_t payloadSize = NextFrame(frame.data(), missedFrames);
+
+        if (missedFrames != 0)
+        {
+            boost::asio::post(mContext, [this, weak_this, missedFrames]() {
+                if (!weak_this.expired())
+                {
+                    OnGap(missedFrames);
+                }
+            });
+        }
+
+        if (payloadSize == 0)
+        {
+            if (++idleCount >= SUBSCRIPTION_SPIN_COUNT)
+            {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        idleCount = 0;
+
+        boost::asio::post(mContext, [this, weak_this, frame, payloadSize]() {
+            if (!weak_this.expired())
+            {
+                ReceiveFromHandler(frame.data(), payloadSize);
+            }
+        });
+    }
 }
 
 void Subscription::ReceiveFromHandler(unsigned char const* data, std::size_t size)
@@ -310,8 +575,10 @@ std::unique_ptr<IConnection> ConnectionFactory::Create()
 
 SubscriptionFactory::SubscriptionFactory(boost::asio::io_context& context,
                                          const std::string& type,
-                                         const std::string& name)
-    : mContext(context), mType(type), mName(name)
+                                         const std::string& name,
+                                         SubscriptionMode mode,
+                                         int cpu)
+    : mContext(context), mType(type), mName(name), mMode(mode), mCpu(cpu)
 {
 }
 
@@ -319,7 +586,7 @@ std::shared_ptr<ISubscription> SubscriptionFactory::Create()
 {
     interprocess::file_mapping file{mName.c_str(), interprocess::read_only};
     interprocess::mapped_region region{file, interprocess::read_only};
-    return std::make_shared<Subscription>(mContext, file, region);
+    return std::make_shared<Subscription>(mContext, file, region, mMode, mCpu);
 }
 
 }
\ No newline at end of file
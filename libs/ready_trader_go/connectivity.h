@@ -18,14 +18,20 @@
 #ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONNECTIVITY_H
 #define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONNECTIVITY_H
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
-#include <boost/asio/streambuf.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/system/error_code.hpp>
@@ -43,14 +49,56 @@ namespace ReadyTraderGo {
 constexpr std::size_t MESSAGE_HEADER_SIZE = 3;
 constexpr std::size_t MESSAGE_TYPE_OFFSET = 2;
 
+// A message is at most 65535 bytes long, so once the complete messages in the
+// receive buffer have been handled, at least half of it is free for the next
+// read, even if a partial message remains.
+constexpr std::size_t MAXIMUM_MESSAGE_SIZE = 65535;
+constexpr std::size_t RECEIVE_BUFFER_SIZE = 2 * (MAXIMUM_MESSAGE_SIZE + 1);
+
+// Outbound messages are written in place into a send buffer. While a write is
+// in progress, the bytes it is sending can't be moved, so new messages are
+// held back in a second buffer which takes over once the write completes.
+// Orders are small and the exchange limits how many may be sent each second,
+// so a buffer only has to grow if the exchange stops reading altogether.
+constexpr std::size_t SEND_BUFFER_SIZE = 65536;
+
 // Each subscription transport frame begins with a two-part header:
-//    1. spinlock - a four-byte little-endian flag (either 0 or 1); and
+//    1. spinlock - a four-byte little-endian word whose low byte is a flag
+//       (either 0 or 1) and whose upper three bytes are the generation, the
+//       number of times (modulo 2^24) the publisher had wrapped around the
+//       transport buffer when it wrote the frame (the stock publisher leaves
+//       the generation at zero); and
 //    2. payload size - a four-byte, big endian, unsigned intteger.
 constexpr std::size_t FRAME_PAYLOAD_SIZE_OFFSET = 4;
 constexpr std::size_t FRAME_HEADER_SIZE = 8;
 constexpr std::size_t FRAME_SIZE = 128;
-constexpr std::size_t SUBSCRIPTION_TRANSPORT_BUFFER_SIZE = 8182;
-
+constexpr std::size_t MAXIMUM_PAYLOAD_SIZE = FRAME_SIZE - FRAME_HEADER_SIZE;
+constexpr std::size_t SUBSCRIPTION_TRANSPORT_BUFFER_SIZE = 8192;
+constexpr std::size_t FRAME_COUNT = SUBSCRIPTION_TRANSPORT_BUFFER_SIZE / FRAME_SIZE;
+
+constexpr uint32_t FRAME_FLAG_MASK = 0xFF;
+constexpr unsigned FRAME_GENERATION_SHIFT = 8;
+constexpr uint32_t FRAME_GENERATION_MASK = 0xFFFFFF;
+constexpr unsigned long FRAME_SEQUENCE_MASK = (FRAME_GENERATION_MASK + 1ul) * FRAME_COUNT - 1;
+
+// A subscription waits for new frames in one of three ways:
+//    1. spin - re-post a poll to the io_context after every check (lowest
+//       latency, but keeps a core busy and queues other handlers behind it);
+//    2. backoff - spin for a while, then wait on a timer whose delay doubles
+//       (up to a limit) each time no frame has arrived; or
+//    3. thread - poll from a dedicated, optionally pinned, thread which posts
+//       each frame to the io_context.
+enum class SubscriptionMode { SPIN, BACKOFF, THREAD };
+
+// Number of consecutive empty polls before a backoff subscription starts
+// waiting on a timer (or a subscription thread starts yielding its CPU).
+constexpr unsigned SUBSCRIPTION_SPIN_COUNT = 1000;
+constexpr std::chrono::microseconds SUBSCRIPTION_MIN_BACKOFF{10};
+constexpr std::chrono::microseconds SUBSCRIPTION_MAX_BACKOFF{500};
+
+// Convert a configured subscription mode name ("spin", "backoff" or
+// "thread") to a SubscriptionMode.
+SubscriptionMode subscriptionModeFromString(const std::string& name);
 
 class Connection : public IConnection
 {
@@ -58,7 +106,8 @@ public:
     Connection(boost::asio::io_context& context, tcp::socket&& socket);
     ~Connection() override;
     void AsyncRead() override;
-    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override;
+    void CommitMessage(SendMode mode) override;
+    unsigned char* PrepareMessage(unsigned char messageType, std::size_t size) override;
 
 private:
     void Send();
@@ -68,8 +117,13 @@ private:
     void WriteSomeHandler(const boost::system::error_code& error, std::size_t size);
 
     boost::asio::io_context& mContext;
-    boost::asio::streambuf mInBuffer;
-    boost::asio::streambuf mOutBuffer;
+    std::vector<unsigned char> mInBuffer;
+    std::size_t mInBufferSize = 0;
+    std::vector<unsigned char> mOutBuffer;
+    std::size_t mOutBufferBegin = 0;
+    std::size_t mOutBufferEnd = 0;
+    std::vector<unsigned char> mHeldBuffer;
+    std::size_t mHeldBufferEnd = 0;
     bool mIsSending = false;
     bool mIsSendPosted = false;
     tcp::socket mSocket;
@@ -80,17 +134,41 @@ class Subscription : public ISubscription
 public:
     Subscription(boost::asio::io_context& context,
                  interprocess::file_mapping& file,
-                 interprocess::mapped_region& region);
+                 interprocess::mapped_region& region,
+                 SubscriptionMode mode = SubscriptionMode::SPIN,
+                 int cpu = -1);
     ~Subscription() override;
     void AsyncReceive() override;
 
 private:
-    void AsyncReceive(unsigned long, std::weak_ptr<ISubscription>);
+    void AsyncReceive(std::weak_ptr<ISubscription>);
+    void BackOff(std::weak_ptr<ISubscription>);
+    std::size_t NextFrame(unsigned char* payload, unsigned long& missedFrames);
+    void PollThread(std::weak_ptr<ISubscription>);
     void ReceiveFromHandler(unsigned char const*, std::size_t size);
+    unsigned long Resynchronise();
+
+    // Whether the publisher writes frame generations. Until a frame with a
+    // non-zero generation turns up, a publisher that doesn't can't be told
+    // apart from one that is still on its first lap.
+    enum class FrameGenerations { UNKNOWN, WRITTEN, NOT_WRITTEN };
 
     boost::asio::io_context& mContext;
     interprocess::file_mapping mFile;
     interprocess::mapped_region mRegion;
+    SubscriptionMode mMode;
+    int mCpu;
+    unsigned long mPosition = 0;
+    uint32_t mGeneration = 0;
+    FrameGenerations mFrameGenerations = FrameGenerations::UNKNOWN;
+    bool mIsSynchronised = false;
+    std::array<unsigned char, MAXIMUM_PAYLOAD_SIZE> mFrame;
+    unsigned mIdleCount = 0;
+    std::chrono::microseconds mBackOff = SUBSCRIPTION_MIN_BACKOFF;
+    boost::asio::steady_timer mTimer;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> mWorkGuard;
+    std::atomic<bool> mStopping{false};
+    std::thread mThread;
 };
 
 class ConnectionFactory : public IConnectionFactory
@@ -114,7 +192,9 @@ class SubscriptionFactory : public ISubscriptionFactory
 public:
     SubscriptionFactory(boost::asio::io_context& context,
                         const std::string& type,
-                        const std::string& name);
+                        const std::string& name,
+                        SubscriptionMode mode = SubscriptionMode::SPIN,
+                        int cpu = -1);
 
     std::shared_ptr<ISubscription> Create() override;
 
@@ -122,6 +202,8 @@ private:
     boost::asio::io_context& mContext;
     std::string mType;
     std::string mName;
+    SubscriptionMode mMode;
+    int mCpu;
 };
 
 }
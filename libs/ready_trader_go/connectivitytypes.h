@@ -42,9 +42,25 @@ struct IConnection
 {
     virtual ~IConnection() = default;
     virtual void AsyncRead() = 0;
+
+    // Reserve space for a message with a payload of the given size, write its
+    // header and return a pointer to where the payload should be written.
+    // The payload must be filled in before the next call to PrepareMessage or
+    // CommitMessage, which sends every message prepared since the previous one.
+    virtual unsigned char* PrepareMessage(unsigned char messageType, std::size_t size) = 0;
+    virtual void CommitMessage(SendMode mode) = 0;
+    void CommitMessage()
+    {
+        CommitMessage(SendMode::ASAP);
+    }
+
     virtual void SendMessage(unsigned char messageType,
                              const ISerialisable& serialisable,
-                             SendMode mode) = 0;
+                             SendMode mode)
+    {
+        serialisable.Serialise(PrepareMessage(messageType, serialisable.Size()));
+        CommitMessage(mode);
+    }
     void SendMessage(unsigned char messageType, const ISerialisable& serialisable)
     {
         SendMessage(messageType, serialisable, SendMode::ASAP);
@@ -84,9 +100,18 @@ struct ISubscription: public std::enable_shared_from_this<ISubscription>
     const std::string& GetName() const { return mName; }
     void SetName(std::string name) { mName = std::move(name); }
 
+    std::function<void(ISubscription*, unsigned long)> GapDetected;
     std::function<void(ISubscription*, unsigned char, unsigned char const*, std::size_t)> MessageReceived;
 
 protected:
+    void OnGap(unsigned long missedFrames)
+    {
+        if (GapDetected)
+        {
+            GapDetected(this, missedFrames);
+        }
+    }
+
     void OnMessageReceipt(unsigned char messageType, unsigned char const* data, std::size_t size)
     {
         if (MessageReceived)
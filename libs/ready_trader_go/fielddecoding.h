@@ -0,0 +1,97 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FIELDDECODING_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FIELDDECODING_H
+
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <boost/endian/conversion.hpp>
+
+#include "protocol.h"
+
+namespace ReadyTraderGo {
+
+// The name of the decoder readLongs was compiled to use.
+#if defined(__AVX2__)
+constexpr char const* READ_LONGS_DECODER = "AVX2";
+#elif defined(__SSSE3__)
+constexpr char const* READ_LONGS_DECODER = "SSSE3";
+#else
+constexpr char const* READ_LONGS_DECODER = "scalar";
+#endif
+
+// Decode 'count' packed big-endian 32-bit fields into 'out' one at a time and
+// return a pointer just past them.
+template<typename T>
+inline unsigned char const* readLongsScalar(unsigned char const* data, T* out, std::size_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8),
+                  "fields must be decoded into 32- or 64-bit values");
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out[i] = boost::endian::load_big_u32(data + i * MessageFieldSize::LONG);
+    }
+    return data + count * MessageFieldSize::LONG;
+}
+
+// Decode 'count' packed big-endian 32-bit fields into 'out' and return a
+// pointer just past them. Where the target supports it (e.g. when built with
+// RTG_NATIVE_ARCH), four fields at a time are byte-swapped with a single
+// shuffle and, if need be, widened to the output type.
+template<typename T>
+inline unsigned char const* readLongs(unsigned char const* data, T* out, std::size_t count)
+{
+    static_assert(std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8),
+                  "fields must be decoded into 32- or 64-bit values");
+    std::size_t i = 0;
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+    const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i fields = _mm_shuffle_epi8(
+            _mm_loadu_si128((__m128i const*)(data + i * MessageFieldSize::LONG)), swap);
+        if constexpr (sizeof(T) == 4)
+        {
+            _mm_storeu_si128((__m128i*)(out + i), fields);
+        }
+        else
+        {
+#if defined(__AVX2__)
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu32_epi64(fields));
+#else
+            const __m128i zero = _mm_setzero_si128();
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi32(fields, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 2), _mm_unpackhi_epi32(fields, zero));
+#endif
+        }
+    }
+#endif
+
+    readLongsScalar(data + i * MessageFieldSize::LONG, out + i, count - i);
+    return data + count * MessageFieldSize::LONG;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FIELDDECODING_H
@@ -0,0 +1,94 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FREQUENCYLIMITER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FREQUENCYLIMITER_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "error.h"
+#include "traderclock.h"
+
+namespace ReadyTraderGo {
+
+// The exchange's standard message frequency limit
+constexpr std::chrono::seconds DEFAULT_MESSAGE_FREQUENCY_INTERVAL{1};
+constexpr std::size_t DEFAULT_MESSAGE_FREQUENCY_LIMIT = 50;
+
+// Limits the number of events in any interval of a given length, in the same
+// way as the exchange's FrequencyLimiter: an event counts against the limit
+// until exactly one interval after it happened.
+//
+// The times of the last 'limit' events are kept in a ring. The oldest of
+// them is the next to be overwritten, so checking whether another event is
+// allowed, and recording it, take constant time.
+class FrequencyLimiter
+{
+public:
+    using Clock = TraderClock;
+
+    FrequencyLimiter(Clock::duration interval, std::size_t limit);
+
+    // Return true, and record the event, if an event at the given time would
+    // not breach the limit.
+    bool Admit(Clock::time_point now) noexcept;
+    bool Admit() noexcept { return Admit(Clock::now()); }
+
+    // Return true if an event at the given time would not breach the limit.
+    bool CanAdmit(Clock::time_point now) const noexcept { return mTimes[mOldest] + mInterval <= now; }
+
+    // Return the earliest time at which another event will be admitted.
+    Clock::time_point GetNextAdmitTime() const noexcept { return mTimes[mOldest] + mInterval; }
+
+    Clock::duration GetInterval() const noexcept { return mInterval; }
+    std::size_t GetLimit() const noexcept { return mTimes.size(); }
+
+private:
+    Clock::duration mInterval;
+    std::vector<Clock::time_point> mTimes;
+    std::size_t mOldest = 0;
+};
+
+inline FrequencyLimiter::FrequencyLimiter(Clock::duration interval, std::size_t limit)
+    : mInterval(interval), mTimes(limit, Clock::time_point::min())
+{
+    if (limit == 0)
+    {
+        throw ReadyTraderGoError("message frequency limit must be at least one");
+    }
+}
+
+inline bool FrequencyLimiter::Admit(Clock::time_point now) noexcept
+{
+    if (!CanAdmit(now))
+    {
+        return false;
+    }
+
+    mTimes[mOldest] = now;
+    if (++mOldest == mTimes.size())
+    {
+        mOldest = 0;
+    }
+    return true;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_FREQUENCYLIMITER_H
@@ -0,0 +1,161 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <boost/asio/post.hpp>
+
+#include "error.h"
+#include "hedgeaggregator.h"
+
+namespace ReadyTraderGo {
+
+HedgeAggregator::HedgeAggregator(boost::asio::io_context& context, Clock::duration window)
+    : mContext(context), mTimer(context), mWindow(window)
+{
+    if (window < Clock::duration::zero())
+    {
+        throw ReadyTraderGoError("hedge window must not be negative");
+    }
+}
+
+void HedgeAggregator::Add(long delta, double referencePrice)
+{
+    const long volume = std::abs(delta);
+    if (mNetPosition == 0 || (mNetPosition > 0) == (delta > 0))
+    {
+        mReferenceValue += referencePrice * static_cast<double>(volume);
+        mNetPosition += delta;
+        return;
+    }
+
+    // An opposite fill offsets the net lots at their average reference price
+    const long net = std::abs(mNetPosition);
+    const double average = mReferenceValue / static_cast<double>(net);
+    if (volume <= net)
+    {
+        mStats.mNettedVolume += 2 * volume;
+        mReferenceValue -= average * static_cast<double>(volume);
+    }
+    else
+    {
+        mStats.mNettedVolume += 2 * net;
+        mReferenceValue = referencePrice * static_cast<double>(volume - net);
+    }
+    mNetPosition += delta;
+    if (mNetPosition == 0)
+    {
+        mReferenceValue = 0.0;
+    }
+}
+
+void HedgeAggregator::AddFill(Side side, Volume volume, Price referencePrice)
+{
+    if (volume == 0)
+    {
+        return;
+    }
+    ++mStats.mFillCount;
+    mStats.mFillVolume += volume;
+    Add((side == Side::BUY) ? static_cast<long>(volume) : -static_cast<long>(volume),
+        static_cast<double>(referencePrice));
+    ScheduleFlush();
+}
+
+void HedgeAggregator::Flush()
+{
+    if (mNetPosition == 0 || !SendHedge)
+    {
+        return;
+    }
+
+    const Side side = (mNetPosition > 0) ? Side::SELL : Side::BUY;
+    const Volume volume = static_cast<unsigned long>(std::abs(mNetPosition));
+    const unsigned long clientOrderId = SendHedge(side, volume);
+    if (clientOrderId == 0)
+    {
+        return;
+    }
+
+    ++mStats.mHedgeCount;
+    mPendingHedges.push_back({clientOrderId, side, volume, mReferenceValue / static_cast<double>(volume)});
+    mNetPosition = 0;
+    mReferenceValue = 0.0;
+}
+
+bool HedgeAggregator::HedgeFilled(unsigned long clientOrderId, Price price, Volume volume)
+{
+    auto it = std::find_if(mPendingHedges.begin(), mPendingHedges.end(), [clientOrderId](const PendingHedge& h) {
+        return h.mClientOrderId == clientOrderId;
+    });
+    if (it == mPendingHedges.end())
+    {
+        return false;
+    }
+
+    const PendingHedge hedge = *it;
+    *it = mPendingHedges.back();
+    mPendingHedges.pop_back();
+
+    if (volume != 0)
+    {
+        const double cost = (hedge.mSide == Side::BUY) ? static_cast<double>(price) - hedge.mReferencePrice
+                                                       : hedge.mReferencePrice - static_cast<double>(price);
+        mStats.mSlippage += std::lround(cost * static_cast<double>(volume));
+        mStats.mHedgedVolume += volume;
+    }
+
+    // Whatever wasn't filled still needs hedging
+    if (volume < hedge.mVolume)
+    {
+        const long unfilled = static_cast<long>(hedge.mVolume) - static_cast<long>(volume);
+        Add((hedge.mSide == Side::BUY) ? -unfilled : unfilled, hedge.mReferencePrice);
+        ScheduleFlush();
+    }
+    return true;
+}
+
+void HedgeAggregator::ScheduleFlush()
+{
+    if (mIsFlushScheduled || mWindow == MANUAL_HEDGE_WINDOW)
+    {
+        return;
+    }
+
+    mIsFlushScheduled = true;
+    if (mWindow == Clock::duration::zero())
+    {
+        boost::asio::post(mContext, [this] {
+            mIsFlushScheduled = false;
+            Flush();
+        });
+        return;
+    }
+
+    mTimer.expires_after(mWindow);
+    mTimer.async_wait([this](const boost::system::error_code& error) {
+        if (!error)
+        {
+            mIsFlushScheduled = false;
+            Flush();
+        }
+    });
+}
+
+}
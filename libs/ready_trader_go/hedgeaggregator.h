@@ -0,0 +1,120 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGEAGGREGATOR_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGEAGGREGATOR_H
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+
+#include "traderclock.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// Hedges are only sent when HedgeAggregator::Flush is called
+constexpr TraderClock::duration MANUAL_HEDGE_WINDOW = TraderClock::duration::max();
+
+struct HedgeStats
+{
+    unsigned long mFillCount = 0;     // fills added
+    unsigned long mFillVolume = 0;
+    unsigned long mNettedVolume = 0;  // fill volume offset by opposite fills
+    unsigned long mHedgeCount = 0;    // hedge orders sent
+    unsigned long mHedgedVolume = 0;  // hedge volume filled
+    long mSlippage = 0;               // cost of the hedges against the reference prices, in cents
+
+    // The hedge messages saved by netting, compared to one hedge per fill
+    long GetMessagesSaved() const noexcept { return static_cast<long>(mFillCount) - static_cast<long>(mHedgeCount); }
+    double GetSlippagePerLot() const noexcept
+    {
+        return (mHedgedVolume == 0) ? 0.0 : static_cast<double>(mSlippage) / static_cast<double>(mHedgedVolume);
+    }
+};
+
+// Nets ETF fills against each other and sends a single future hedge for what
+// is left, instead of one hedge per fill.
+//
+// Fills are collected until the end of the current turn of the event loop
+// (a window of zero), for a fixed window after the first of them, or until
+// Flush is called (MANUAL_HEDGE_WINDOW). A hedge that isn't filled in full
+// puts the rest back to be hedged with the next flush; with an automatic
+// window, that flush is scheduled straight away.
+//
+// Each fill comes with a reference price, typically the future's mid price
+// when the fill arrived. The cost of a hedge is measured against the average
+// reference price of the fills it covers, which shows what the wait (and the
+// hedge's own market impact) costs.
+class HedgeAggregator
+{
+public:
+    using Clock = TraderClock;
+
+    explicit HedgeAggregator(boost::asio::io_context& context, Clock::duration window = Clock::duration::zero());
+
+    HedgeAggregator(const HedgeAggregator&) = delete;
+    HedgeAggregator& operator=(const HedgeAggregator&) = delete;
+
+    // Add an ETF fill that needs hedging
+    void AddFill(Side side, Volume volume, Price referencePrice);
+
+    // Send a hedge for the net position now, if there is one
+    void Flush();
+
+    // Apply a hedge filled message. Returns false if the hedge isn't one of
+    // this aggregator's.
+    bool HedgeFilled(unsigned long clientOrderId, Price price, Volume volume);
+
+    // Called to send a hedge. Returns the hedge's client order id, or zero if
+    // it wasn't sent (in which case the volume stays to be hedged).
+    std::function<unsigned long(Side, Volume)> SendHedge;
+
+    // The ETF lots waiting to be hedged, positive for a long position. Hedges
+    // already sent aren't included.
+    long GetNetPosition() const noexcept { return mNetPosition; }
+    const HedgeStats& GetStats() const noexcept { return mStats; }
+    Clock::duration GetWindow() const noexcept { return mWindow; }
+
+private:
+    struct PendingHedge
+    {
+        unsigned long mClientOrderId;
+        Side mSide;
+        Volume mVolume;
+        double mReferencePrice;
+    };
+
+    void Add(long delta, double referencePrice);
+    void ScheduleFlush();
+
+    boost::asio::io_context& mContext;
+    TraderTimer mTimer;
+    Clock::duration mWindow;
+    bool mIsFlushScheduled = false;
+
+    long mNetPosition = 0;
+    double mReferenceValue = 0.0;  // the sum of the reference prices of the net lots
+    std::vector<PendingHedge> mPendingHedges;
+    HedgeStats mStats;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGEAGGREGATOR_H
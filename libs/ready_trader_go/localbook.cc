@@ -0,0 +1,348 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#include "error.h"
+#include "localbook.h"
+
+namespace ReadyTraderGo {
+
+static void readLevels(const TopLevelsView& view,
+                       std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                       std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                       std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                       std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        askPrices[i] = view.GetAskPrice(i);
+        askVolumes[i] = view.GetAskVolume(i);
+        bidPrices[i] = view.GetBidPrice(i);
+        bidVolumes[i] = view.GetBidVolume(i);
+    }
+}
+
+static Volume reduceVolume(Volume volume, unsigned long reduction)
+{
+    return volume > reduction ? volume - reduction : 0;
+}
+
+LocalBook::LocalBook(unsigned long tickSize, std::size_t window)
+    : mTickSize(static_cast<std::uint32_t>(tickSize)), mWindow(window)
+{
+    if (tickSize == 0 || tickSize > MAXIMUM_ASK || window == 0)
+    {
+        throw ReadyTraderGoError("local book tick size and window must be positive");
+    }
+    mAsks.mLevels.resize(window);
+    mBids.mLevels.resize(window);
+}
+
+void LocalBook::AddOrder(unsigned long clientOrderId, Side side, Price price, Volume volume)
+{
+    mOrders.push_back({clientOrderId, side, price, ToTick(price), volume, GetVolume(side, price)});
+}
+
+bool LocalBook::ApplyOrderBook(unsigned long sequenceNumber,
+                               const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                               const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                               const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                               const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes,
+                               Clock::time_point now)
+{
+    if (mUpdate != 0 && sequenceNumber <= mSequenceNumber)
+    {
+        return false;
+    }
+
+    mSequenceNumber = sequenceNumber;
+    ++mUpdate;
+    UpdateSide(Side::SELL, askPrices, askVolumes, now);
+    UpdateSide(Side::BUY, bidPrices, bidVolumes, now);
+    UpdateVolumesAhead();
+    return true;
+}
+
+bool LocalBook::ApplyOrderBook(const OrderBookView& book, Clock::time_point now)
+{
+    std::array<Price, TOP_LEVEL_COUNT> askPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> askVolumes;
+    std::array<Price, TOP_LEVEL_COUNT> bidPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> bidVolumes;
+    readLevels(book, askPrices, askVolumes, bidPrices, bidVolumes);
+    return ApplyOrderBook(book.GetSequenceNumber(), askPrices, askVolumes, bidPrices, bidVolumes, now);
+}
+
+void LocalBook::ApplyTradeTicks(const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    for (Side side : {Side::SELL, Side::BUY})
+    {
+        auto& prices = (side == Side::SELL) ? askPrices : bidPrices;
+        auto& volumes = (side == Side::SELL) ? askVolumes : bidVolumes;
+        for (std::size_t i = 0; i < TOP_LEVEL_COUNT && prices[i] != 0; ++i)
+        {
+            if (Level* level = FindLevel(side, ToTick(prices[i])))
+            {
+                level->mVolume = reduceVolume(level->mVolume, volumes[i]);
+            }
+            for (auto& order : mOrders)
+            {
+                if (order.mSide == side && order.mPrice == prices[i])
+                {
+                    order.mVolumeAhead = reduceVolume(order.mVolumeAhead, volumes[i]);
+                }
+            }
+        }
+    }
+}
+
+void LocalBook::ApplyTradeTicks(const TradeTicksView& ticks)
+{
+    std::array<Price, TOP_LEVEL_COUNT> askPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> askVolumes;
+    std::array<Price, TOP_LEVEL_COUNT> bidPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> bidVolumes;
+    readLevels(ticks, askPrices, askVolumes, bidPrices, bidVolumes);
+    ApplyTradeTicks(askPrices, askVolumes, bidPrices, bidVolumes);
+}
+
+LocalBook::Level* LocalBook::FindLevel(Side side, long tick) noexcept
+{
+    const long index = tick - mOrigin;
+    if (mOrigin < 0 || index < 0 || index >= static_cast<long>(mWindow))
+    {
+        return nullptr;
+    }
+    return &GetSide(side).mLevels[index];
+}
+
+const LocalBook::Level* LocalBook::FindLevel(Side side, long tick) const noexcept
+{
+    return const_cast<LocalBook*>(this)->FindLevel(side, tick);
+}
+
+double LocalBook::GetImbalance(std::size_t levels) const
+{
+    double askVolume = 0.0;
+    double bidVolume = 0.0;
+    for (std::size_t i = 0; i < std::min(levels, TOP_LEVEL_COUNT); ++i)
+    {
+        askVolume += mAsks.mTopVolumes[i];
+        bidVolume += mBids.mTopVolumes[i];
+    }
+    const double total = askVolume + bidVolume;
+    return (total == 0.0) ? 0.0 : (bidVolume - askVolume) / total;
+}
+
+LocalBook::Clock::duration LocalBook::GetLevelAge(Side side, Price price, Clock::time_point now) const
+{
+    const Level* level = FindLevel(side, ToTick(price));
+    if (level == nullptr || level->mUpdate != mUpdate || level->mVolume == 0)
+    {
+        return Clock::duration::zero();
+    }
+    return now - level->mSince;
+}
+
+Volume LocalBook::GetVolume(Side side, Price price) const
+{
+    const long tick = ToTick(price);
+    const Level* level = FindLevel(side, tick);
+    if (level == nullptr)
+    {
+        return 0;
+    }
+    if (IsVisible(side, tick))
+    {
+        // Anything the latest snapshot reaches but doesn't mention is empty
+        return (level->mUpdate == mUpdate) ? level->mVolume : Volume(0);
+    }
+    return level->mVolume;
+}
+
+Volume LocalBook::GetVolumeAhead(unsigned long clientOrderId) const
+{
+    for (const auto& order : mOrders)
+    {
+        if (order.mClientOrderId == clientOrderId)
+        {
+            return order.mVolumeAhead;
+        }
+    }
+    return 0;
+}
+
+bool LocalBook::IsVisible(Side side, long tick) const noexcept
+{
+    const BookSide& bookSide = GetSide(side);
+    return bookSide.mTopCount < TOP_LEVEL_COUNT || !isBeyond(side, tick, bookSide.mTopTicks[TOP_LEVEL_COUNT - 1]);
+}
+
+void LocalBook::MoveWindow(long tick)
+{
+    const long window = static_cast<long>(mWindow);
+    if (mOrigin >= 0 && tick >= mOrigin && tick < mOrigin + window)
+    {
+        return;
+    }
+
+    // Centre the window on the new price, keeping whatever levels overlap
+    const long origin = std::max(0L, tick - window / 2);
+    const long shift = (mOrigin < 0) ? window : origin - mOrigin;
+    for (auto* levels : {&mAsks.mLevels, &mBids.mLevels})
+    {
+        if (shift >= window || shift <= -window)
+        {
+            std::fill(levels->begin(), levels->end(), Level());
+        }
+        else if (shift > 0)
+        {
+            std::move(levels->begin() + shift, levels->end(), levels->begin());
+            std::fill(levels->end() - shift, levels->end(), Level());
+        }
+        else
+        {
+            std::move_backward(levels->begin(), levels->end() + shift, levels->end());
+            std::fill(levels->begin(), levels->begin() - shift, Level());
+        }
+    }
+    mOrigin = origin;
+}
+
+void LocalBook::RemoveOrder(unsigned long clientOrderId)
+{
+    auto it = std::find_if(mOrders.begin(), mOrders.end(), [clientOrderId](const OwnOrder& order) {
+        return order.mClientOrderId == clientOrderId;
+    });
+    if (it != mOrders.end())
+    {
+        *it = mOrders.back();
+        mOrders.pop_back();
+    }
+}
+
+void LocalBook::SetOrderRemaining(unsigned long clientOrderId, Volume remainingVolume)
+{
+    if (remainingVolume == 0)
+    {
+        RemoveOrder(clientOrderId);
+        return;
+    }
+    for (auto& order : mOrders)
+    {
+        if (order.mClientOrderId == clientOrderId)
+        {
+            order.mRemainingVolume = remainingVolume;
+            return;
+        }
+    }
+}
+
+void LocalBook::UpdateSide(Side side,
+                           const std::array<Price, TOP_LEVEL_COUNT>& prices,
+                           const std::array<Volume, TOP_LEVEL_COUNT>& volumes,
+                           Clock::time_point now)
+{
+    BookSide& bookSide = GetSide(side);
+    const std::array<long, TOP_LEVEL_COUNT> oldTicks = bookSide.mTopTicks;
+    const std::size_t oldCount = bookSide.mTopCount;
+
+    std::array<long, TOP_LEVEL_COUNT> ticks{};
+    std::size_t count = 0;
+    while (count < TOP_LEVEL_COUNT && prices[count] != 0)
+    {
+        ticks[count] = ToTick(prices[count]);
+        MoveWindow(ticks[count]);
+        ++count;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Level* level = FindLevel(side, ticks[i]);
+        if (level == nullptr)
+        {
+            continue;
+        }
+        if (level->mUpdate == 0 || level->mUpdate + 1 != mUpdate || level->mVolume == 0)
+        {
+            level->mSince = now;
+        }
+        level->mVolume = volumes[i];
+        level->mUpdate = mUpdate;
+
+        // The levels between this price and the next are empty
+        if (i + 1 < count)
+        {
+            const long step = (side == Side::SELL) ? 1 : -1;
+            for (long tick = ticks[i] + step; tick != ticks[i + 1] && isBeyond(side, ticks[i + 1], tick); tick += step)
+            {
+                if (Level* gap = FindLevel(side, tick))
+                {
+                    gap->mVolume = 0;
+                }
+            }
+        }
+    }
+
+    bookSide.mTopPrices = prices;
+    bookSide.mTopVolumes = volumes;
+    bookSide.mTopTicks = ticks;
+    bookSide.mTopCount = count;
+
+    // A level that has left the snapshot, but is still within its reach, has
+    // emptied. Write that down, so it isn't mistaken for a stale level if the
+    // snapshot later stops reaching it.
+    for (std::size_t i = 0; i < oldCount; ++i)
+    {
+        Level* level = FindLevel(side, oldTicks[i]);
+        if (level != nullptr && level->mUpdate != mUpdate && IsVisible(side, oldTicks[i]))
+        {
+            level->mVolume = 0;
+        }
+    }
+}
+
+void LocalBook::UpdateVolumesAhead()
+{
+    for (auto& order : mOrders)
+    {
+        if (!IsVisible(order.mSide, order.mTick))
+        {
+            continue;
+        }
+
+        unsigned long ours = 0;
+        for (const auto& other : mOrders)
+        {
+            if (other.mSide == order.mSide && other.mPrice == order.mPrice)
+            {
+                ours += other.mRemainingVolume;
+            }
+        }
+
+        // Orders that arrive after ours join the queue behind it, so only
+        // the volume others have on the level can be ahead of it
+        const Volume others = reduceVolume(GetVolume(order.mSide, order.mPrice), ours);
+        order.mVolumeAhead = std::min<unsigned long>(order.mVolumeAhead, others);
+    }
+}
+
+}
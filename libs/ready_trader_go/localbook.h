@@ -0,0 +1,163 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LOCALBOOK_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LOCALBOOK_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "protocol.h"
+#include "traderclock.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// The exchange's standard tick size, in cents
+constexpr unsigned long DEFAULT_TICK_SIZE = 100;
+
+// The number of ticks either side of the market the book remembers
+constexpr std::size_t DEFAULT_LOCAL_BOOK_WINDOW = 1024;
+
+// A persistent order book for one instrument, built up from successive
+// order book snapshots and trade ticks.
+//
+// Levels are held in an array indexed by price (in ticks), covering a window
+// that is moved when the market leaves it. A snapshot only writes the levels
+// from its best to its fifth-best price, which are usually a few ticks
+// apart; a level beyond the fifth keeps the volume it had when it was last
+// seen. Each update therefore costs time proportional to the depth of the
+// message rather than the size of the book.
+//
+// The book also estimates, for each of our own orders, how much volume is
+// queued ahead of it at its price. The estimate starts at the volume on the
+// level when the order is added, and only ever falls: by the volume traded at
+// the price, and to the volume others have left on the level.
+class LocalBook
+{
+public:
+    using Clock = TraderClock;
+
+    explicit LocalBook(unsigned long tickSize = DEFAULT_TICK_SIZE, std::size_t window = DEFAULT_LOCAL_BOOK_WINDOW);
+
+    // Apply an order book snapshot. Returns false, and ignores the snapshot,
+    // if its sequence number isn't later than the last one applied.
+    bool ApplyOrderBook(unsigned long sequenceNumber,
+                        const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                        const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                        const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                        const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes,
+                        Clock::time_point now = Clock::now());
+    bool ApplyOrderBook(const OrderBookView& book, Clock::time_point now = Clock::now());
+
+    // Apply trade ticks, where the ask (bid) prices are those at which resting
+    // asks (bids) traded.
+    void ApplyTradeTicks(const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                         const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                         const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                         const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes);
+    void ApplyTradeTicks(const TradeTicksView& ticks);
+
+    // The best prices are zero when a side is empty.
+    Price GetBestAsk() const noexcept { return mAsks.mTopPrices[0]; }
+    Price GetBestBid() const noexcept { return mBids.mTopPrices[0]; }
+    unsigned long GetSequenceNumber() const noexcept { return mSequenceNumber; }
+
+    Volume GetVolume(Side side, Price price) const;
+
+    // How long a level in the latest snapshot has been in every snapshot;
+    // zero for a level that isn't in the latest snapshot.
+    Clock::duration GetLevelAge(Side side, Price price, Clock::time_point now = Clock::now()) const;
+
+    // (bid volume - ask volume) / (bid volume + ask volume) over the given
+    // number of best levels, or zero if both sides are empty.
+    double GetImbalance(std::size_t levels = 1) const;
+
+    // Track the queue position of one of our orders, from when it is inserted
+    // until nothing of it remains.
+    void AddOrder(unsigned long clientOrderId, Side side, Price price, Volume volume);
+    void SetOrderRemaining(unsigned long clientOrderId, Volume remainingVolume);
+    void RemoveOrder(unsigned long clientOrderId);
+
+    // The estimated volume ahead of one of our orders, or zero for an order
+    // that isn't tracked.
+    Volume GetVolumeAhead(unsigned long clientOrderId) const;
+
+private:
+    struct Level
+    {
+        Volume mVolume = 0;
+        std::uint32_t mUpdate = 0;  // the last update the level was seen in
+        Clock::time_point mSince;   // when it was first seen, in a run of updates
+    };
+
+    struct BookSide
+    {
+        std::vector<Level> mLevels;
+        std::array<Price, TOP_LEVEL_COUNT> mTopPrices{};
+        std::array<Volume, TOP_LEVEL_COUNT> mTopVolumes{};
+        std::array<long, TOP_LEVEL_COUNT> mTopTicks{};
+        std::size_t mTopCount = 0;
+    };
+
+    struct OwnOrder
+    {
+        unsigned long mClientOrderId;
+        Side mSide;
+        Price mPrice;
+        long mTick;
+        Volume mRemainingVolume;
+        Volume mVolumeAhead;
+    };
+
+    static bool isBeyond(Side side, long tick, long limit) noexcept
+    {
+        return side == Side::SELL ? tick > limit : tick < limit;
+    }
+
+    // Prices are four bytes, and a 32-bit division is much the cheaper
+    long ToTick(Price price) const noexcept { return static_cast<std::uint32_t>(price) / mTickSize; }
+
+    Level* FindLevel(Side side, long tick) noexcept;
+    const Level* FindLevel(Side side, long tick) const noexcept;
+    bool IsVisible(Side side, long tick) const noexcept;
+    void MoveWindow(long tick);
+    void UpdateSide(Side side,
+                    const std::array<Price, TOP_LEVEL_COUNT>& prices,
+                    const std::array<Volume, TOP_LEVEL_COUNT>& volumes,
+                    Clock::time_point now);
+    void UpdateVolumesAhead();
+
+    BookSide& GetSide(Side side) noexcept { return side == Side::SELL ? mAsks : mBids; }
+    const BookSide& GetSide(Side side) const noexcept { return side == Side::SELL ? mAsks : mBids; }
+
+    std::uint32_t mTickSize;
+    std::size_t mWindow;
+    long mOrigin = -1;  // the price, in ticks, of the first level in the window
+    std::uint32_t mUpdate = 0;
+    unsigned long mSequenceNumber = 0;
+    BookSide mAsks;
+    BookSide mBids;
+    std::vector<OwnOrder> mOrders;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LOCALBOOK_H
@@ -44,6 +44,25 @@ constexpr const char* LOG_LEVEL_NAMES[] = {
     "FATAL"
 };
 
+// RLOG statements below this level are compiled out altogether, so their
+// arguments are never evaluated. It can be set with the RTG_MIN_LOG_LEVEL
+// CMake option; by default DEBUG statements are only compiled into builds
+// without NDEBUG, since the log file filters them out of the others anyway.
+#ifndef RTG_MIN_LOG_LEVEL
+#ifdef NDEBUG
+#define RTG_MIN_LOG_LEVEL LL_INFO
+#else
+#define RTG_MIN_LOG_LEVEL LL_DEBUG
+#endif
+#endif
+
+constexpr LogLevel MINIMUM_LOG_LEVEL = LogLevel::RTG_MIN_LOG_LEVEL;
+
+constexpr bool isLogLevelEnabled(LogLevel level)
+{
+    return level >= MINIMUM_LOG_LEVEL;
+}
+
 template<typename C, typename T>
 std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, LogLevel lvl)
 {
@@ -52,12 +71,39 @@ std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, LogLevel lv
     return strm;
 }
 
+}
+
+// Runs the statement that follows only if the level is compiled in. The
+// condition is a constant, so the statement is removed when it is not.
+#define RTG_IF_LOG_LEVEL_ENABLED(logLevel)\
+    for (bool rtgLogLevelEnabled = ReadyTraderGo::isLogLevelEnabled(logLevel); rtgLogLevelEnabled;\
+         rtgLogLevelEnabled = false)
+
+#ifdef RTG_ASYNC_LOGGING
+
+// Log records are captured in binary form on the calling thread and
+// formatted on a logging thread (see asynclogging.h)
+#include "asynclogging.h"
+
+#define RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(loggerName, channelName)\
+    struct loggerName { static constexpr const char* CHANNEL = (channelName); };
+
+#define RLOG(loggerName, logLevel)\
+    RTG_IF_LOG_LEVEL_ENABLED(logLevel)\
+    for (ReadyTraderGo::AsyncLogRecord rtgLogRecord{(logLevel), loggerName::CHANNEL}; rtgLogRecord;\
+         rtgLogRecord.Publish())\
+        rtgLogRecord
+
+#else
+
 #define RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(loggerName, channelName)\
     BOOST_LOG_INLINE_GLOBAL_LOGGER_CTOR_ARGS(loggerName,\
         boost::log::sources::severity_channel_logger<ReadyTraderGo::LogLevel>,\
         (boost::log::keywords::channel = (channelName)));
 
-#define RLOG(loggerName, logLevel) BOOST_LOG_SEV(loggerName::get(), (logLevel))
-}
+#define RLOG(loggerName, logLevel)\
+    RTG_IF_LOG_LEVEL_ENABLED(logLevel) BOOST_LOG_SEV(loggerName::get(), (logLevel))
+
+#endif
 
 #endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LOGGING_H
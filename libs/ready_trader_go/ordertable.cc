@@ -0,0 +1,246 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "error.h"
+#include "ordertable.h"
+
+namespace ReadyTraderGo {
+
+// Keep each index at most a quarter full, so probe sequences stay short
+constexpr std::size_t ORDER_TABLE_INDEX_LOAD = 4;
+constexpr std::size_t ORDER_TABLE_MINIMUM_INDEX_SIZE = 16;
+
+static std::size_t indexSize(std::size_t capacity)
+{
+    std::size_t size = ORDER_TABLE_MINIMUM_INDEX_SIZE;
+    while (size < capacity * ORDER_TABLE_INDEX_LOAD)
+    {
+        size *= 2;
+    }
+    return size;
+}
+
+template<typename V>
+OrderTable::Index<V>::Index(std::size_t capacity)
+    : mEntries(indexSize(capacity), Entry{0, V{}, false}), mMask(mEntries.size() - 1)
+{
+}
+
+template<typename V>
+V& OrderTable::Index<V>::FindOrInsert(std::uint64_t key)
+{
+    std::size_t i = Home(key);
+    for (; mEntries[i].mIsUsed; i = (i + 1) & mMask)
+    {
+        if (mEntries[i].mKey == key)
+        {
+            return mEntries[i].mValue;
+        }
+    }
+    mEntries[i] = Entry{key, V{}, true};
+    return mEntries[i].mValue;
+}
+
+template<typename V>
+void OrderTable::Index<V>::Erase(std::uint64_t key)
+{
+    std::size_t hole = Home(key);
+    while (mEntries[hole].mIsUsed && mEntries[hole].mKey != key)
+    {
+        hole = (hole + 1) & mMask;
+    }
+    if (!mEntries[hole].mIsUsed)
+    {
+        return;
+    }
+
+    // Move back any later entry in the same run that may not be left
+    // beyond the hole, or it would no longer be found
+    for (std::size_t i = (hole + 1) & mMask; mEntries[i].mIsUsed; i = (i + 1) & mMask)
+    {
+        const std::size_t home = Home(mEntries[i].mKey);
+        if (((i - home) & mMask) >= ((i - hole) & mMask))
+        {
+            mEntries[hole] = mEntries[i];
+            hole = i;
+        }
+    }
+    mEntries[hole].mIsUsed = false;
+}
+
+template<typename V>
+void OrderTable::Index<V>::Clear()
+{
+    for (auto& entry : mEntries)
+    {
+        entry.mIsUsed = false;
+    }
+}
+
+OrderTable::OrderTable(std::size_t capacity)
+    : mCapacity(capacity), mOrders(), mById(capacity), mByPrice(capacity)
+{
+    if (capacity == 0)
+    {
+        throw ReadyTraderGoError("order table capacity must be at least one");
+    }
+    mOrders.reserve(capacity);
+}
+
+bool OrderTable::Amend(unsigned long clientOrderId, Volume volume)
+{
+    auto* slot = mById.Find(clientOrderId);
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    LiveOrder& order = mOrders[*slot];
+    const unsigned long filled = order.mVolume - order.mRemainingVolume;
+    if (volume >= order.mVolume)
+    {
+        return true;
+    }
+
+    const Volume oldRemainingVolume = order.mRemainingVolume;
+    if (volume <= filled)
+    {
+        order.mVolume = filled;
+        order.mRemainingVolume = 0;
+        order.mState = OrderState::CANCELLING;
+    }
+    else
+    {
+        order.mVolume = volume;
+        order.mRemainingVolume = volume - filled;
+    }
+    UpdateLevel(order, oldRemainingVolume);
+    return true;
+}
+
+bool OrderTable::ApplyStatus(unsigned long clientOrderId, Volume fillVolume, Volume remainingVolume)
+{
+    auto* slot = mById.Find(clientOrderId);
+    if (slot == nullptr)
+    {
+        return false;
+    }
+
+    if (remainingVolume == 0)
+    {
+        RemoveAt(*slot);
+        return true;
+    }
+
+    LiveOrder& order = mOrders[*slot];
+    const Volume oldRemainingVolume = order.mRemainingVolume;
+    order.mRemainingVolume = remainingVolume;
+    order.mConfirmedVolume = remainingVolume;
+    order.mVolume = fillVolume + remainingVolume;
+    if (order.mState == OrderState::INSERTING)
+    {
+        order.mState = OrderState::LIVE;
+    }
+    UpdateLevel(order, oldRemainingVolume);
+    return true;
+}
+
+void OrderTable::Clear()
+{
+    mOrders.clear();
+    mById.Clear();
+    mByPrice.Clear();
+    mSideCounts = {};
+    mRemainingVolume = 0;
+}
+
+LiveOrder* OrderTable::Insert(unsigned long clientOrderId, Side side, Price price, Volume volume, Lifespan lifespan)
+{
+    if (IsFull() || mById.Find(clientOrderId) != nullptr)
+    {
+        return nullptr;
+    }
+
+    mById.FindOrInsert(clientOrderId) = static_cast<std::uint32_t>(mOrders.size());
+    mOrders.push_back({clientOrderId, side, lifespan, OrderState::INSERTING, price, volume, volume, volume});
+    ++mSideCounts[static_cast<std::size_t>(side)];
+
+    Level& level = mByPrice.FindOrInsert(levelKey(side, price));
+    ++level.mCount;
+    level.mVolume = level.mVolume + volume;
+    mRemainingVolume = mRemainingVolume + volume;
+    return &mOrders.back();
+}
+
+bool OrderTable::MarkCancelling(unsigned long clientOrderId)
+{
+    auto* order = Find(clientOrderId);
+    if (order == nullptr)
+    {
+        return false;
+    }
+    order->mState = OrderState::CANCELLING;
+    return true;
+}
+
+bool OrderTable::Remove(unsigned long clientOrderId)
+{
+    auto* slot = mById.Find(clientOrderId);
+    if (slot == nullptr)
+    {
+        return false;
+    }
+    RemoveAt(*slot);
+    return true;
+}
+
+void OrderTable::RemoveAt(std::size_t slot)
+{
+    const LiveOrder& order = mOrders[slot];
+    const std::uint64_t key = levelKey(order.mSide, order.mPrice);
+    Level& level = *mByPrice.Find(key);
+    if (--level.mCount == 0)
+    {
+        mByPrice.Erase(key);
+    }
+    else
+    {
+        level.mVolume = level.mVolume - order.mRemainingVolume;
+    }
+    --mSideCounts[static_cast<std::size_t>(order.mSide)];
+    mRemainingVolume = mRemainingVolume - order.mRemainingVolume;
+    mById.Erase(order.mClientOrderId);
+
+    if (slot != mOrders.size() - 1)
+    {
+        mOrders[slot] = mOrders.back();
+        *mById.Find(mOrders[slot].mClientOrderId) = static_cast<std::uint32_t>(slot);
+    }
+    mOrders.pop_back();
+}
+
+void OrderTable::UpdateLevel(const LiveOrder& order, Volume oldRemainingVolume)
+{
+    Level& level = *mByPrice.Find(levelKey(order.mSide, order.mPrice));
+    level.mVolume = level.mVolume - oldRemainingVolume + order.mRemainingVolume;
+    mRemainingVolume = mRemainingVolume - oldRemainingVolume + order.mRemainingVolume;
+}
+
+template class OrderTable::Index<std::uint32_t>;
+template class OrderTable::Index<OrderTable::Level>;
+
+}
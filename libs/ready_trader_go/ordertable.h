@@ -0,0 +1,200 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERTABLE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERTABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// The exchange's standard limit on the number of active orders
+constexpr std::size_t DEFAULT_ACTIVE_ORDER_COUNT_LIMIT = 10;
+
+enum class OrderState : unsigned char
+{
+    INSERTING,  // sent, but not yet acknowledged by the exchange
+    LIVE,       // acknowledged, and resting in the order book
+    CANCELLING  // a cancel has been sent
+};
+
+struct LiveOrder
+{
+    unsigned long mClientOrderId;
+    Side mSide;
+    Lifespan mLifespan;
+    OrderState mState;
+    Price mPrice;
+    Volume mVolume;
+    Volume mRemainingVolume;
+    Volume mConfirmedVolume;  // the remaining volume the exchange last reported
+};
+
+// A fixed-capacity table of an auto-trader's active orders.
+//
+// The orders are kept contiguously (removing one moves the last into its
+// place), with two small open-addressed indexes alongside: one from client
+// order id to order, and one from side and price to the number of orders and
+// remaining volume at that price. Finding an order, or whether there is one
+// at a price, takes constant time and touches a couple of cache lines.
+class OrderTable
+{
+public:
+    explicit OrderTable(std::size_t capacity = DEFAULT_ACTIVE_ORDER_COUNT_LIMIT);
+
+    // Add a newly sent order. Returns nullptr if the table is full or already
+    // holds an order with the same id.
+    LiveOrder* Insert(unsigned long clientOrderId, Side side, Price price, Volume volume, Lifespan lifespan);
+
+    // Record that an amend has been sent, reducing the order's total volume
+    // to the given volume (but not below the volume already filled), until
+    // the order status message confirms it. An amend that leaves nothing
+    // marks the order as cancelling, so that it stays in the table until the
+    // exchange says it is gone. The confirmed volume isn't changed.
+    bool Amend(unsigned long clientOrderId, Volume volume);
+
+    // Apply an order status message, removing the order if nothing remains.
+    // Returns false if the order isn't in the table.
+    bool ApplyStatus(unsigned long clientOrderId, Volume fillVolume, Volume remainingVolume);
+
+    // Record that a cancel has been sent for an order.
+    bool MarkCancelling(unsigned long clientOrderId);
+
+    bool Remove(unsigned long clientOrderId);
+    void Clear();
+
+    LiveOrder* Find(unsigned long clientOrderId);
+    const LiveOrder* Find(unsigned long clientOrderId) const;
+
+    bool HasOrderAt(Side side, Price price) const { return GetLevel(side, price).mCount != 0; }
+    Volume GetVolumeAt(Side side, Price price) const { return GetLevel(side, price).mVolume; }
+
+    std::size_t GetCapacity() const noexcept { return mCapacity; }
+    std::size_t GetCount() const noexcept { return mOrders.size(); }
+    std::size_t GetCount(Side side) const noexcept { return mSideCounts[static_cast<std::size_t>(side)]; }
+    Volume GetRemainingVolume() const noexcept { return mRemainingVolume; }
+    bool IsFull() const noexcept { return mOrders.size() == mCapacity; }
+
+    std::vector<LiveOrder>::iterator begin() { return mOrders.begin(); }
+    std::vector<LiveOrder>::iterator end() { return mOrders.end(); }
+    std::vector<LiveOrder>::const_iterator begin() const { return mOrders.begin(); }
+    std::vector<LiveOrder>::const_iterator end() const { return mOrders.end(); }
+
+private:
+    struct Level
+    {
+        std::uint32_t mCount = 0;
+        Volume mVolume = 0;
+    };
+
+    // An open-addressed hash table with linear probing. Removal shifts later
+    // entries back, so there are no tombstones to clean up.
+    template<typename V>
+    class Index
+    {
+    public:
+        explicit Index(std::size_t capacity);
+        V* Find(std::uint64_t key);
+        const V* Find(std::uint64_t key) const;
+        V& FindOrInsert(std::uint64_t key);
+        void Erase(std::uint64_t key);
+        void Clear();
+
+    private:
+        struct Entry
+        {
+            std::uint64_t mKey;
+            V mValue;
+            bool mIsUsed;
+        };
+
+        std::size_t Home(std::uint64_t key) const noexcept;
+
+        std::vector<Entry> mEntries;
+        std::size_t mMask;
+    };
+
+    static std::uint64_t levelKey(Side side, Price price)
+    {
+        return (static_cast<std::uint64_t>(side) << 32) | static_cast<unsigned long>(price);
+    }
+
+    const Level& GetLevel(Side side, Price price) const;
+    void UpdateLevel(const LiveOrder& order, Volume oldRemainingVolume);
+    void RemoveAt(std::size_t slot);
+
+    std::size_t mCapacity;
+    std::vector<LiveOrder> mOrders;
+    Index<std::uint32_t> mById;
+    Index<Level> mByPrice;
+    std::array<std::size_t, 2> mSideCounts{};
+    Volume mRemainingVolume = 0;
+};
+
+inline LiveOrder* OrderTable::Find(unsigned long clientOrderId)
+{
+    auto* slot = mById.Find(clientOrderId);
+    return slot ? &mOrders[*slot] : nullptr;
+}
+
+inline const LiveOrder* OrderTable::Find(unsigned long clientOrderId) const
+{
+    auto* slot = mById.Find(clientOrderId);
+    return slot ? &mOrders[*slot] : nullptr;
+}
+
+inline const OrderTable::Level& OrderTable::GetLevel(Side side, Price price) const
+{
+    static const Level empty;
+    auto* level = mByPrice.Find(levelKey(side, price));
+    return level ? *level : empty;
+}
+
+template<typename V>
+inline std::size_t OrderTable::Index<V>::Home(std::uint64_t key) const noexcept
+{
+    // Fibonacci hashing spreads consecutive ids and prices across the table
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mMask;
+}
+
+template<typename V>
+inline V* OrderTable::Index<V>::Find(std::uint64_t key)
+{
+    for (std::size_t i = Home(key); mEntries[i].mIsUsed; i = (i + 1) & mMask)
+    {
+        if (mEntries[i].mKey == key)
+        {
+            return &mEntries[i].mValue;
+        }
+    }
+    return nullptr;
+}
+
+template<typename V>
+inline const V* OrderTable::Index<V>::Find(std::uint64_t key) const
+{
+    return const_cast<Index*>(this)->Find(key);
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERTABLE_H
@@ -0,0 +1,81 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_POSITIONTABLE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_POSITIONTABLE_H
+
+#include <array>
+#include <cstddef>
+
+#include "riskengine.h"
+
+namespace ReadyTraderGo {
+
+// A value for every position from -Limit to Limit, such as a quote volume or
+// a price skew, held in a flat array offset by the limit.
+//
+// Tables are usually built at compile time from a function of the position:
+//
+//     constexpr auto BID_VOLUMES = PositionTable<int>::Generate([](long position) { return ...; });
+//
+// A lookup is a single indexed load. Positions beyond the limit (which the
+// exchange won't allow for long) read the value at the limit.
+template<typename T, long Limit = DEFAULT_POSITION_LIMIT>
+class PositionTable
+{
+    static_assert(Limit >= 0, "position table limit must not be negative");
+
+public:
+    static constexpr long LIMIT = Limit;
+    static constexpr std::size_t SIZE = 2 * Limit + 1;
+
+    template<typename F>
+    static constexpr PositionTable Generate(F function)
+    {
+        PositionTable table;
+        for (long position = -Limit; position <= Limit; ++position)
+        {
+            table.mValues[index(position)] = function(position);
+        }
+        return table;
+    }
+
+    constexpr T& operator[](long position) noexcept { return mValues[index(position)]; }
+    constexpr const T& operator[](long position) const noexcept { return mValues[index(position)]; }
+
+    constexpr const std::array<T, SIZE>& GetValues() const noexcept { return mValues; }
+
+private:
+    static constexpr std::size_t index(long position) noexcept
+    {
+        return static_cast<std::size_t>((position < -Limit ? -Limit : position > Limit ? Limit : position) + Limit);
+    }
+
+    std::array<T, SIZE> mValues{};
+};
+
+// The largest integer no greater than x, for use in constant expressions
+// (std::floor isn't constexpr).
+constexpr long floorToLong(double x) noexcept
+{
+    const long truncated = static_cast<long>(x);
+    return (static_cast<double>(truncated) > x) ? truncated - 1 : truncated;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_POSITIONTABLE_H
@@ -20,10 +20,23 @@
 
 #include <boost/endian/conversion.hpp>
 
+#include "fielddecoding.h"
 #include "protocol.h"
 
 namespace ReadyTraderGo {
 
+static void readTopLevels(unsigned char const* data,
+                          std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                          std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                          std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                          std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    data = readLongs(data, askPrices.data(), TOP_LEVEL_COUNT);
+    data = readLongs(data, askVolumes.data(), TOP_LEVEL_COUNT);
+    data = readLongs(data, bidPrices.data(), TOP_LEVEL_COUNT);
+    readLongs(data, bidVolumes.data(), TOP_LEVEL_COUNT);
+}
+
 static std::string readFixedLengthString(unsigned char const* data, std::size_t maxSize)
 {
     auto loc = (decltype(data)) std::memchr(data, 0, maxSize);
@@ -50,9 +63,9 @@ void AmendMessage::Deserialise(unsigned char const* data, std::size_t)
 
 void AmendMessage::Serialise(unsigned char* buf) const
 {
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
+    boost::endian::store_big_u32(buf, mClientOrderId);
     buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mNewVolume);
+    boost::endian::store_big_u32(buf, mNewVolume);
 }
 
 void CancelMessage::Deserialise(unsigned char const* data, std::size_t)
@@ -62,7 +75,7 @@ void CancelMessage::Deserialise(unsigned char const* data, std::size_t)
 
 void CancelMessage::Serialise(unsigned char* buf) const
 {
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
+    boost::endian::store_big_u32(buf, mClientOrderId);
 }
 
 void ErrorMessage::Deserialise(unsigned char const* data, std::size_t)
@@ -92,13 +105,13 @@ void HedgeMessage::Deserialise(unsigned char const* data, std::size_t)
 
 void HedgeMessage::Serialise(unsigned char* buf) const
 {
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
+    boost::endian::store_big_u32(buf, mClientOrderId);
     buf += MessageFieldSize::LONG;
     *buf = static_cast<unsigned char>(mSide);
     buf += MessageFieldSize::BYTE;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mPrice);
+    boost::endian::store_big_u32(buf, mPrice);
     buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mVolume);
+    boost::endian::store_big_u32(buf, mVolume);
 }
 
 void HedgeFilledMessage::Deserialise(unsigned char const* data, std::size_t)
@@ -134,13 +147,13 @@ void InsertMessage::Deserialise(unsigned char const* data, std::size_t)
 
 void InsertMessage::Serialise(unsigned char* buf) const
 {
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
+    boost::endian::store_big_u32(buf, mClientOrderId);
     buf += MessageFieldSize::LONG;
     *buf = static_cast<unsigned char>(mSide);
     buf += MessageFieldSize::BYTE;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mPrice);
+    boost::endian::store_big_u32(buf, mPrice);
     buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mVolume);
+    boost::endian::store_big_u32(buf, mVolume);
     buf += MessageFieldSize::LONG;
     *buf = static_cast<unsigned char>(mLifespan);
 }
@@ -163,29 +176,9 @@ void OrderBookMessage::Deserialise(unsigned char const* data, std::size_t)
 {
     mInstrument = Instrument(*data);
     data += MessageFieldSize::BYTE;
-    mSequenceNumber = boost::endian::big_to_native(*(uint32_t*)data);
+    mSequenceNumber = boost::endian::load_big_u32(data);
     data += MessageFieldSize::LONG;
-
-    for (auto& p : mAskPrices)
-    {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& v : mAskVolumes)
-    {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& p : mBidPrices)
-    {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& v : mBidVolumes)
-    {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
+    readTopLevels(data, mAskPrices, mAskVolumes, mBidPrices, mBidVolumes);
 }
 
 void OrderBookMessage::Serialise(unsigned char* buf) const
@@ -261,29 +254,9 @@ void TradeTicksMessage::Deserialise(unsigned char const* data, std::size_t)
 {
     mInstrument = Instrument(*data);
     data += MessageFieldSize::BYTE;
-    mSequenceNumber = boost::endian::big_to_native(*(uint32_t*)data);
+    mSequenceNumber = boost::endian::load_big_u32(data);
     data += MessageFieldSize::LONG;
-
-    for (auto& p : mAskPrices)
-    {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& v : mAskVolumes)
-    {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& p : mBidPrices)
-    {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& v : mBidVolumes)
-    {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
+    readTopLevels(data, mAskPrices, mAskVolumes, mBidPrices, mBidVolumes);
 }
 
 void TradeTicksMessage::Serialise(unsigned char* buf) const
@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include <boost/endian/conversion.hpp>
+
 #include "connectivitytypes.h"
 #include "types.h"
 
@@ -51,10 +53,10 @@ enum MessageFieldSize : std::size_t
     STRING = 50
 };
 
-struct AmendMessage : ISerialisable
+struct AmendMessage final : ISerialisable
 {
     AmendMessage() = default;
-    AmendMessage(unsigned long clientOrderId, unsigned long newVolume)
+    AmendMessage(unsigned long clientOrderId, Volume newVolume)
         : mClientOrderId(clientOrderId), mNewVolume(newVolume) {}
 
     std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 2; }
@@ -63,10 +65,10 @@ struct AmendMessage : ISerialisable
     void Serialise(unsigned char* buf) const override;
 
     unsigned long mClientOrderId = 0;
-    unsigned long mNewVolume = 0;
+    Volume mNewVolume = 0;
 };
 
-struct CancelMessage : ISerialisable
+struct CancelMessage final : ISerialisable
 {
     CancelMessage() = default;
     explicit CancelMessage(unsigned long clientOrderId) : mClientOrderId(clientOrderId) {}
@@ -97,13 +99,13 @@ struct ErrorMessage : ISerialisable
     std::string mMessage;
 };
 
-struct HedgeMessage : ISerialisable
+struct HedgeMessage final : ISerialisable
 {
     HedgeMessage() = default;
     HedgeMessage(unsigned long clientOrderId,
                   Side side,
-                  unsigned long price,
-                  unsigned long volume)
+                  Price price,
+                  Volume volume)
         : mClientOrderId(clientOrderId),
           mSide(side),
           mPrice(price),
@@ -116,16 +118,16 @@ struct HedgeMessage : ISerialisable
 
     unsigned long mClientOrderId = 0;
     Side mSide = Side::SELL;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice = 0;
+    Volume mVolume = 0;
 };
 
 struct HedgeFilledMessage : ISerialisable
 {
     HedgeFilledMessage() = default;
     HedgeFilledMessage(unsigned long clientOrderId,
-                       unsigned long price,
-                       unsigned long volume)
+                       Price price,
+                       Volume volume)
         : mClientOrderId(clientOrderId),
           mPrice(price),
           mVolume(volume) {}
@@ -136,17 +138,17 @@ struct HedgeFilledMessage : ISerialisable
     void Serialise(unsigned char* buf) const override;
 
     unsigned long mClientOrderId = 0;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice = 0;
+    Volume mVolume = 0;
 };
 
-struct InsertMessage : ISerialisable
+struct InsertMessage final : ISerialisable
 {
     InsertMessage() = default;
     InsertMessage(unsigned long clientOrderId,
                   Side side,
-                  unsigned long price,
-                  unsigned long volume,
+                  Price price,
+                  Volume volume,
                   Lifespan lifespan)
         : mClientOrderId(clientOrderId),
           mSide(side),
@@ -161,8 +163,8 @@ struct InsertMessage : ISerialisable
 
     unsigned long mClientOrderId = 0;
     Side mSide = Side::SELL;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice = 0;
+    Volume mVolume = 0;
     Lifespan mLifespan = Lifespan::FILL_AND_KILL;
 };
 
@@ -189,10 +191,10 @@ struct OrderBookMessage : ISerialisable
     OrderBookMessage() = default;
     OrderBookMessage(Instrument instrument,
                      unsigned long sequenceNumber,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+                     const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                     const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                     const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                     const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
         : mInstrument(instrument),
           mSequenceNumber(sequenceNumber),
           mAskPrices(askPrices),
@@ -212,18 +214,18 @@ struct OrderBookMessage : ISerialisable
 
     Instrument mInstrument = Instrument::FUTURE;
     unsigned long mSequenceNumber = 0;
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskVolumes = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidVolumes = {};
+    std::array<Price, TOP_LEVEL_COUNT> mAskPrices = {};
+    std::array<Volume, TOP_LEVEL_COUNT> mAskVolumes = {};
+    std::array<Price, TOP_LEVEL_COUNT> mBidPrices = {};
+    std::array<Volume, TOP_LEVEL_COUNT> mBidVolumes = {};
 };
 
 struct OrderFilledMessage : ISerialisable
 {
     OrderFilledMessage() = default;
     OrderFilledMessage(unsigned long clientOrderId,
-                       unsigned long price,
-                       unsigned long volume)
+                       Price price,
+                       Volume volume)
         : mClientOrderId(clientOrderId),
           mPrice(price),
           mVolume(volume) {}
@@ -234,16 +236,16 @@ struct OrderFilledMessage : ISerialisable
     void Serialise(unsigned char* buf) const override;
 
     unsigned long mClientOrderId = 0;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice = 0;
+    Volume mVolume = 0;
 };
 
 struct OrderStatusMessage : ISerialisable
 {
     OrderStatusMessage() = default;
     OrderStatusMessage(unsigned long clientOrderId,
-                       unsigned long fillVolume,
-                       unsigned long remainingVolume,
+                       Volume fillVolume,
+                       Volume remainingVolume,
                        signed long fees)
         : mClientOrderId(clientOrderId),
           mFillVolume(fillVolume),
@@ -256,8 +258,8 @@ struct OrderStatusMessage : ISerialisable
     void Serialise(unsigned char* buf) const override;
 
     unsigned long mClientOrderId = 0;
-    unsigned long mFillVolume = 0;
-    unsigned long mRemainingVolume = 0;
+    Volume mFillVolume = 0;
+    Volume mRemainingVolume = 0;
     signed long mFees = 0;
 };
 
@@ -266,10 +268,10 @@ struct TradeTicksMessage : ISerialisable
     TradeTicksMessage() = default;
     TradeTicksMessage(Instrument instrument,
                       unsigned long sequenceNumber,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &askPrices,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes)
+                      const std::array<Price, TOP_LEVEL_COUNT> &askPrices,
+                      const std::array<Volume, TOP_LEVEL_COUNT> &askVolumes,
+                      const std::array<Price, TOP_LEVEL_COUNT> &bidPrices,
+                      const std::array<Volume, TOP_LEVEL_COUNT> &bidVolumes)
             : mInstrument(instrument),
               mSequenceNumber(sequenceNumber),
               mAskPrices(askPrices),
@@ -289,10 +291,56 @@ struct TradeTicksMessage : ISerialisable
 
     Instrument mInstrument = Instrument::FUTURE;
     unsigned long mSequenceNumber = 0;
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskVolumes = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidVolumes = {};
+    std::array<Price, TOP_LEVEL_COUNT> mAskPrices = {};
+    std::array<Volume, TOP_LEVEL_COUNT> mAskVolumes = {};
+    std::array<Price, TOP_LEVEL_COUNT> mBidPrices = {};
+    std::array<Volume, TOP_LEVEL_COUNT> mBidVolumes = {};
+};
+
+// A non-owning, read-only view of a serialised order book or trade ticks
+// message. Fields are decoded from the received bytes only when they are
+// asked for, so a handler that looks at the best level pays for one or two
+// loads rather than deserialising every level. A view is only valid for the
+// duration of the handler it is passed to.
+class TopLevelsView
+{
+public:
+    TopLevelsView(unsigned char const* data, std::size_t size) : mData(data), mSize(size) {}
+
+    unsigned char const* GetData() const noexcept { return mData; }
+    std::size_t GetSize() const noexcept { return mSize; }
+
+    Instrument GetInstrument() const noexcept { return Instrument(*mData); }
+    unsigned long GetSequenceNumber() const noexcept { return Load(MessageFieldSize::BYTE); }
+
+    Price GetAskPrice(std::size_t level) const noexcept { return Load(ASK_PRICES_OFFSET, level); }
+    Volume GetAskVolume(std::size_t level) const noexcept { return Load(ASK_VOLUMES_OFFSET, level); }
+    Price GetBidPrice(std::size_t level) const noexcept { return Load(BID_PRICES_OFFSET, level); }
+    Volume GetBidVolume(std::size_t level) const noexcept { return Load(BID_VOLUMES_OFFSET, level); }
+
+private:
+    static constexpr std::size_t ASK_PRICES_OFFSET = MessageFieldSize::BYTE + MessageFieldSize::LONG;
+    static constexpr std::size_t ASK_VOLUMES_OFFSET = ASK_PRICES_OFFSET + MessageFieldSize::LONG * TOP_LEVEL_COUNT;
+    static constexpr std::size_t BID_PRICES_OFFSET = ASK_VOLUMES_OFFSET + MessageFieldSize::LONG * TOP_LEVEL_COUNT;
+    static constexpr std::size_t BID_VOLUMES_OFFSET = BID_PRICES_OFFSET + MessageFieldSize::LONG * TOP_LEVEL_COUNT;
+
+    unsigned long Load(std::size_t offset, std::size_t level = 0) const noexcept
+    {
+        return boost::endian::load_big_u32(mData + offset + level * MessageFieldSize::LONG);
+    }
+
+    unsigned char const* mData;
+    std::size_t mSize;
+};
+
+struct OrderBookView : TopLevelsView
+{
+    using TopLevelsView::TopLevelsView;
+};
+
+struct TradeTicksView : TopLevelsView
+{
+    using TopLevelsView::TopLevelsView;
 };
 
 template<class T>
@@ -0,0 +1,174 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#include "quoteladder.h"
+
+namespace ReadyTraderGo {
+
+std::size_t QuoteLadder::Apply(BaseAutoTrader& autoTrader, unsigned long& nextClientOrderId)
+{
+    std::stable_sort(mActions.begin(), mActions.end(), [](const QuoteAction& a, const QuoteAction& b) {
+        return a.mType < b.mType;
+    });
+
+    std::size_t sent = 0;
+    autoTrader.BeginBatch();
+    for (const auto& action : mActions)
+    {
+        bool isSent = false;
+        switch (action.mType)
+        {
+            case QuoteActionType::CANCEL:
+            {
+                isSent = autoTrader.SendCancelOrder(action.mClientOrderId);
+                if (isSent)
+                {
+                    mOrders.MarkCancelling(action.mClientOrderId);
+                }
+                break;
+            }
+            case QuoteActionType::AMEND:
+            {
+                isSent = autoTrader.SendAmendOrder(action.mClientOrderId, action.mVolume);
+                if (isSent)
+                {
+                    mOrders.Amend(action.mClientOrderId, action.mVolume);
+                    if (mBook)
+                    {
+                        mBook->SetOrderRemaining(action.mClientOrderId,
+                                                 mOrders.Find(action.mClientOrderId)->mRemainingVolume);
+                    }
+                }
+                break;
+            }
+            case QuoteActionType::INSERT:
+            {
+                const Volume volume = mRiskEngine ? mRiskEngine->ClipInsert(action.mSide, action.mVolume)
+                                                  : action.mVolume;
+                if (volume == 0 || mOrders.IsFull())
+                {
+                    // Rejected by the limits; later inserts may still fit
+                    continue;
+                }
+                isSent = autoTrader.SendInsertOrder(nextClientOrderId, action.mSide, action.mPrice, volume,
+                                                    Lifespan::GOOD_FOR_DAY);
+                if (isSent)
+                {
+                    mOrders.Insert(nextClientOrderId++, action.mSide, action.mPrice, volume,
+                                   Lifespan::GOOD_FOR_DAY);
+                    if (mRiskEngine)
+                    {
+                        mRiskEngine->OnInsert(action.mSide, volume);
+                    }
+                    if (mBook)
+                    {
+                        mBook->AddOrder(nextClientOrderId - 1, action.mSide, action.mPrice, volume);
+                    }
+                }
+                break;
+            }
+        }
+        if (!isSent)
+        {
+            break;
+        }
+        ++sent;
+    }
+    autoTrader.CommitBatch();
+
+    mActions.clear();
+    return sent;
+}
+
+void QuoteLadder::Diff(Side side, const std::vector<Quote>& quotes)
+{
+    mCandidates.clear();
+    for (const auto& order : mOrders)
+    {
+        if (order.mSide == side && order.mState != OrderState::CANCELLING
+            && order.mLifespan == Lifespan::GOOD_FOR_DAY)
+        {
+            mCandidates.push_back(&order);
+        }
+    }
+
+    // Group the orders by price, newest first within each price
+    std::sort(mCandidates.begin(), mCandidates.end(), [](const LiveOrder* a, const LiveOrder* b) {
+        return a->mPrice != b->mPrice ? a->mPrice < b->mPrice : a->mClientOrderId > b->mClientOrderId;
+    });
+
+    mIsQuoteMatched.assign(quotes.size(), false);
+    auto first = mCandidates.begin();
+    while (first != mCandidates.end())
+    {
+        const Price price = (*first)->mPrice;
+        auto last = std::find_if(first, mCandidates.end(), [price](const LiveOrder* o) { return o->mPrice != price; });
+
+        unsigned long live = 0;
+        for (auto it = first; it != last; ++it)
+        {
+            live += (*it)->mRemainingVolume;
+        }
+
+        unsigned long wanted = 0;
+        for (std::size_t i = 0; i < quotes.size(); ++i)
+        {
+            if (quotes[i].mPrice == price)
+            {
+                wanted = quotes[i].mVolume;
+                mIsQuoteMatched[i] = true;
+                break;
+            }
+        }
+
+        if (live < wanted)
+        {
+            mActions.push_back({QuoteActionType::INSERT, side, 0, price, wanted - live});
+        }
+
+        unsigned long surplus = live > wanted ? live - wanted : 0;
+        for (auto it = first; it != last && surplus != 0; ++it)
+        {
+            const LiveOrder& order = **it;
+            if (order.mRemainingVolume <= surplus)
+            {
+                mActions.push_back({QuoteActionType::CANCEL, side, order.mClientOrderId, price, 0});
+                surplus -= order.mRemainingVolume;
+            }
+            else
+            {
+                mActions.push_back({QuoteActionType::AMEND, side, order.mClientOrderId, price,
+                                    order.mVolume - surplus});
+                surplus = 0;
+            }
+        }
+
+        first = last;
+    }
+
+    for (std::size_t i = 0; i < quotes.size(); ++i)
+    {
+        if (!mIsQuoteMatched[i] && quotes[i].mVolume != 0)
+        {
+            mActions.push_back({QuoteActionType::INSERT, side, 0, quotes[i].mPrice, quotes[i].mVolume});
+        }
+    }
+}
+
+}
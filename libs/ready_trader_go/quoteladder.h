@@ -0,0 +1,99 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTELADDER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTELADDER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "baseautotrader.h"
+#include "localbook.h"
+#include "ordertable.h"
+#include "riskengine.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+struct Quote
+{
+    Price mPrice;
+    Volume mVolume;
+};
+
+// Cancels come first, as they free up room under the active order limits
+enum class QuoteActionType : unsigned char
+{
+    CANCEL,
+    AMEND,
+    INSERT
+};
+
+struct QuoteAction
+{
+    QuoteActionType mType;
+    Side mSide;
+    unsigned long mClientOrderId;  // zero for an insert
+    Price mPrice;
+    Volume mVolume;                // the amended order's new total volume
+};
+
+// Works out the fewest messages that turn an auto-trader's good-for-day
+// orders on one side into a desired set of quotes.
+//
+// At each price the live remaining volume is compared with the desired
+// volume. Surplus volume is taken from the newest orders first, by amending
+// the last of them down rather than cancelling it, so the oldest orders keep
+// their place in the queue. A shortfall is made up with a new order. Orders
+// at prices that aren't wanted are cancelled. Orders already being
+// cancelled, and fill-and-kill orders, are left alone.
+class QuoteLadder
+{
+public:
+    // If a risk engine is given, inserts are clipped by it (or skipped, if it
+    // rejects them), and reported to it. If a local book is given, the orders
+    // inserted and amended are tracked in it, so that it can estimate their
+    // places in the queue; the order status messages must be passed on to it
+    // too.
+    explicit QuoteLadder(OrderTable& orders, RiskEngine* riskEngine = nullptr, LocalBook* book = nullptr)
+        : mOrders(orders), mRiskEngine(riskEngine), mBook(book) {}
+
+    // Add the actions for one side to the pending actions. Each price should
+    // appear at most once in the quotes.
+    void Diff(Side side, const std::vector<Quote>& quotes);
+
+    // Send the pending actions in one batch, recording them in the order
+    // table. New orders take ids from nextClientOrderId. Stops at the first
+    // message that can't be sent (for instance, because of the message
+    // frequency limit) and returns the number of messages sent.
+    std::size_t Apply(BaseAutoTrader& autoTrader, unsigned long& nextClientOrderId);
+
+    void Clear() { mActions.clear(); }
+    const std::vector<QuoteAction>& GetActions() const noexcept { return mActions; }
+
+private:
+    OrderTable& mOrders;
+    RiskEngine* mRiskEngine;
+    LocalBook* mBook;
+    std::vector<QuoteAction> mActions;
+    std::vector<const LiveOrder*> mCandidates;
+    std::vector<bool> mIsQuoteMatched;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUOTELADDER_H
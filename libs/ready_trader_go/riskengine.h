@@ -0,0 +1,198 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RISKENGINE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RISKENGINE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "ordertable.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// The exchange's standard limits, along with DEFAULT_ACTIVE_ORDER_COUNT_LIMIT
+constexpr unsigned long DEFAULT_ACTIVE_VOLUME_LIMIT = 200;
+constexpr long DEFAULT_POSITION_LIMIT = 100;
+
+// The relative position the exchange lets a competitor hold indefinitely
+constexpr long UNHEDGED_LOTS_LIMIT = 10;
+
+// The part of a relative position (ETF position plus future position) beyond
+// UNHEDGED_LOTS_LIMIT, which is what the exchange times, signed like the
+// relative position
+constexpr long excessUnhedgedLots(long relativePosition) noexcept
+{
+    return (relativePosition > UNHEDGED_LOTS_LIMIT) ? relativePosition - UNHEDGED_LOTS_LIMIT
+         : (relativePosition < -UNHEDGED_LOTS_LIMIT) ? relativePosition + UNHEDGED_LOTS_LIMIT
+         : 0;
+}
+
+// Keeps an auto-trader's positions and active orders, and checks orders
+// against the exchange's limits before they are sent.
+//
+// Every check is worst case: an active order counts against the position
+// limit as if it were about to be filled in full, and an order's volume stays
+// active from the moment it is sent until an order status says it has gone,
+// so in-flight inserts, cancels and amends can't lead to a breach. Hedge
+// orders count against the future position limit in the same way until they
+// are answered.
+//
+// The engine keeps totals only, so the caller supplies the side and volumes
+// of the order each event refers to, usually from its order table (where
+// LiveOrder::mConfirmedVolume is the remaining volume the exchange last
+// reported).
+class RiskEngine
+{
+public:
+    RiskEngine(std::size_t activeOrderCountLimit = DEFAULT_ACTIVE_ORDER_COUNT_LIMIT,
+               unsigned long activeVolumeLimit = DEFAULT_ACTIVE_VOLUME_LIMIT,
+               long positionLimit = DEFAULT_POSITION_LIMIT)
+        : mActiveOrderCountLimit(activeOrderCountLimit),
+          mActiveVolumeLimit(activeVolumeLimit),
+          mPositionLimit(positionLimit) {}
+
+    // Pre-trade checks. Each returns the largest volume, no more than the one
+    // asked for, that an order on the given side can have without risking a
+    // breach, or zero if the order must not be sent at all.
+    Volume ClipHedge(Side side, Volume volume) const noexcept;
+    Volume ClipInsert(Side side, Volume volume) const noexcept;
+
+    // The lots that could be bought (sold) before the ETF position limit,
+    // ignoring active orders, for sizing a set of quotes that will replace
+    // the active orders on that side.
+    long GetPositionRoom(Side side) const noexcept
+    {
+        return (side == Side::BUY) ? mPositionLimit - mEtfPosition : mPositionLimit + mEtfPosition;
+    }
+
+    // Events, to be reported as they happen: OnInsert and OnHedge when the
+    // message is sent, and the others when the corresponding message arrives
+    // from the exchange. OnOrderStatus takes the remaining volume the
+    // exchange reported before this status, or the volume inserted.
+    void OnHedge(Side side, Volume volume) noexcept { mPendingHedgeVolumes[index(side)] += volume; }
+    void OnHedgeFilled(Side side, Volume requestedVolume, Volume filledVolume) noexcept;
+    void OnInsert(Side side, Volume volume) noexcept;
+    void OnOrderFilled(Side side, Volume volume) noexcept { mEtfPosition += signedVolume(side, volume); }
+    void OnOrderStatus(Side side, Volume oldRemainingVolume, Volume remainingVolume) noexcept;
+
+    // Forget the active orders, for instance after a reconnect
+    void ClearOrders() noexcept;
+
+    std::size_t GetActiveOrderCount() const noexcept { return mActiveOrderCount; }
+    unsigned long GetActiveVolume() const noexcept { return mActiveVolumes[0] + mActiveVolumes[1]; }
+    unsigned long GetActiveVolume(Side side) const noexcept { return mActiveVolumes[index(side)]; }
+    long GetEtfPosition() const noexcept { return mEtfPosition; }
+    long GetFuturePosition() const noexcept { return mFuturePosition; }
+    unsigned long GetPendingHedgeVolume(Side side) const noexcept { return mPendingHedgeVolumes[index(side)]; }
+
+    // The sum of the ETF and future positions, which is what the exchange's
+    // unhedged lots rule measures, and the part of it beyond
+    // UNHEDGED_LOTS_LIMIT that the exchange times. This is the only record
+    // of it, and an UnhedgedLots timer is updated from it.
+    long GetUnhedgedLots() const noexcept { return mEtfPosition + mFuturePosition; }
+    long GetExcessUnhedgedLots() const noexcept { return excessUnhedgedLots(GetUnhedgedLots()); }
+
+    std::size_t GetActiveOrderCountLimit() const noexcept { return mActiveOrderCountLimit; }
+    unsigned long GetActiveVolumeLimit() const noexcept { return mActiveVolumeLimit; }
+    long GetPositionLimit() const noexcept { return mPositionLimit; }
+
+    void SetActiveOrderCountLimit(std::size_t limit) noexcept { mActiveOrderCountLimit = limit; }
+    void SetActiveVolumeLimit(unsigned long limit) noexcept { mActiveVolumeLimit = limit; }
+    void SetPositionLimit(long limit) noexcept { mPositionLimit = limit; }
+
+private:
+    static std::size_t index(Side side) noexcept { return static_cast<std::size_t>(side); }
+    static long signedVolume(Side side, Volume volume) noexcept
+    {
+        return (side == Side::BUY) ? static_cast<long>(volume) : -static_cast<long>(volume);
+    }
+
+    static Volume clip(Volume volume, long room) noexcept
+    {
+        return (room <= 0) ? Volume(0) : Volume(std::min<unsigned long>(volume, room));
+    }
+
+    std::size_t mActiveOrderCountLimit;
+    unsigned long mActiveVolumeLimit;
+    long mPositionLimit;
+
+    std::size_t mActiveOrderCount = 0;
+    std::array<unsigned long, 2> mActiveVolumes{};        // indexed by side
+    std::array<unsigned long, 2> mPendingHedgeVolumes{};  // indexed by side
+    long mEtfPosition = 0;
+    long mFuturePosition = 0;
+};
+
+inline void RiskEngine::ClearOrders() noexcept
+{
+    mActiveOrderCount = 0;
+    mActiveVolumes.fill(0);
+    mPendingHedgeVolumes.fill(0);
+}
+
+inline Volume RiskEngine::ClipHedge(Side side, Volume volume) const noexcept
+{
+    const long pending = static_cast<long>(mPendingHedgeVolumes[index(side)]);
+    const long room = (side == Side::BUY) ? mPositionLimit - mFuturePosition - pending
+                                          : mPositionLimit + mFuturePosition - pending;
+    return clip(volume, room);
+}
+
+inline Volume RiskEngine::ClipInsert(Side side, Volume volume) const noexcept
+{
+    if (mActiveOrderCount >= mActiveOrderCountLimit)
+    {
+        return 0;
+    }
+    const long active = static_cast<long>(mActiveVolumes[index(side)]);
+    const long volumeRoom = static_cast<long>(mActiveVolumeLimit) - static_cast<long>(GetActiveVolume());
+    return clip(volume, std::min(volumeRoom, GetPositionRoom(side) - active));
+}
+
+inline void RiskEngine::OnHedgeFilled(Side side, Volume requestedVolume, Volume filledVolume) noexcept
+{
+    unsigned long& pending = mPendingHedgeVolumes[index(side)];
+    pending -= std::min<unsigned long>(pending, requestedVolume);
+    mFuturePosition += signedVolume(side, filledVolume);
+}
+
+inline void RiskEngine::OnInsert(Side side, Volume volume) noexcept
+{
+    ++mActiveOrderCount;
+    mActiveVolumes[index(side)] += volume;
+}
+
+inline void RiskEngine::OnOrderStatus(Side side, Volume oldRemainingVolume, Volume remainingVolume) noexcept
+{
+    if (remainingVolume >= oldRemainingVolume)
+    {
+        return;
+    }
+    unsigned long& active = mActiveVolumes[index(side)];
+    active -= std::min<unsigned long>(active, oldRemainingVolume - remainingVolume);
+    if (remainingVolume == 0 && mActiveOrderCount != 0)
+    {
+        --mActiveOrderCount;
+    }
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_RISKENGINE_H
@@ -0,0 +1,131 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SEQUENCETRACKER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SEQUENCETRACKER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+#include "traderclock.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// Twice the exchange's standard tick interval, so one late order book
+// doesn't make an instrument stale
+constexpr std::chrono::milliseconds DEFAULT_STALE_AFTER{500};
+
+constexpr std::size_t INSTRUMENT_COUNT = 2;
+
+enum class InformationType : unsigned char
+{
+    ORDER_BOOK,
+    TRADE_TICKS
+};
+
+constexpr std::size_t INFORMATION_TYPE_COUNT = 2;
+
+struct SequenceStats
+{
+    unsigned long mLastSequenceNumber = 0;
+    TraderClock::time_point mLastUpdateTime;
+    unsigned long mMessageCount = 0;
+    unsigned long mGapCount = 0;          // the number of times messages were missed
+    unsigned long mMissedMessageCount = 0;
+    unsigned long mOutOfOrderCount = 0;   // late or repeated messages
+};
+
+// Tracks the sequence numbers of each instrument's order book and trade
+// ticks messages separately.
+//
+// The exchange numbers order books by timer tick, and sends the books of
+// every instrument on each tick, so an instrument is stale if its latest
+// order book is too old, or older than another instrument's.
+class SequenceTracker
+{
+public:
+    using Clock = TraderClock;
+
+    // Record a message. Returns false if it is no later than the last message
+    // of the same type for the same instrument.
+    bool Update(Instrument instrument, InformationType type, unsigned long sequenceNumber, Clock::time_point now);
+
+    bool IsStale(Instrument instrument, Clock::time_point now) const noexcept;
+    bool IsStale(Instrument instrument) const { return IsStale(instrument, Clock::now()); }
+
+    const SequenceStats& GetStats(Instrument instrument, InformationType type) const noexcept
+    {
+        return mStats[index(instrument, type)];
+    }
+
+    Clock::duration GetStaleAfter() const noexcept { return mStaleAfter; }
+    void SetStaleAfter(Clock::duration staleAfter) noexcept { mStaleAfter = staleAfter; }
+
+private:
+    static std::size_t index(Instrument instrument, InformationType type) noexcept
+    {
+        return static_cast<std::size_t>(instrument) * INFORMATION_TYPE_COUNT + static_cast<std::size_t>(type);
+    }
+
+    std::array<SequenceStats, INSTRUMENT_COUNT * INFORMATION_TYPE_COUNT> mStats;
+    Clock::duration mStaleAfter = DEFAULT_STALE_AFTER;
+    unsigned long mLatestOrderBook = 0;
+};
+
+inline bool SequenceTracker::IsStale(Instrument instrument, Clock::time_point now) const noexcept
+{
+    const SequenceStats& stats = mStats[index(instrument, InformationType::ORDER_BOOK)];
+    return stats.mMessageCount == 0
+           || stats.mLastSequenceNumber < mLatestOrderBook
+           || now - stats.mLastUpdateTime > mStaleAfter;
+}
+
+inline bool SequenceTracker::Update(Instrument instrument,
+                                    InformationType type,
+                                    unsigned long sequenceNumber,
+                                    Clock::time_point now)
+{
+    SequenceStats& stats = mStats[index(instrument, type)];
+    if (stats.mMessageCount != 0)
+    {
+        if (sequenceNumber <= stats.mLastSequenceNumber)
+        {
+            ++stats.mOutOfOrderCount;
+            return false;
+        }
+        if (sequenceNumber != stats.mLastSequenceNumber + 1)
+        {
+            ++stats.mGapCount;
+            stats.mMissedMessageCount += sequenceNumber - stats.mLastSequenceNumber - 1;
+        }
+    }
+
+    stats.mLastSequenceNumber = sequenceNumber;
+    stats.mLastUpdateTime = now;
+    ++stats.mMessageCount;
+    if (type == InformationType::ORDER_BOOK && sequenceNumber > mLatestOrderBook)
+    {
+        mLatestOrderBook = sequenceNumber;
+    }
+    return true;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SEQUENCETRACKER_H
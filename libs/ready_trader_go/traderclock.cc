@@ -0,0 +1,164 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+
+#include "error.h"
+#include "traderclock.h"
+
+namespace ReadyTraderGo {
+
+static thread_local SimulatedClock* installedClock = nullptr;
+
+TraderClock::time_point TraderClock::now() noexcept
+{
+    if (installedClock)
+    {
+        return installedClock->Now();
+    }
+    return time_point(std::chrono::steady_clock::now().time_since_epoch());
+}
+
+TraderTimer::TraderTimer(boost::asio::io_context& context)
+    : mContext(context), mSimulation(SimulatedClock::GetInstalled())
+{
+    if (!mSimulation)
+    {
+        mTimer.emplace(context);
+    }
+}
+
+TraderTimer::~TraderTimer()
+{
+    if (mSimulation)
+    {
+        cancel();
+    }
+}
+
+std::size_t TraderTimer::cancel()
+{
+    if (!mSimulation)
+    {
+        return mTimer->cancel();
+    }
+    if (mHandlers.empty())
+    {
+        return 0;
+    }
+    mSimulation->Remove(*this);
+    return Complete(boost::asio::error::operation_aborted);
+}
+
+std::size_t TraderTimer::Complete(const boost::system::error_code& error)
+{
+    std::vector<Handler> handlers;
+    handlers.swap(mHandlers);
+    for (Handler& handler : handlers)
+    {
+        boost::asio::post(mContext, [handler = std::move(handler), error]() { handler(error); });
+    }
+    return handlers.size();
+}
+
+TraderTimer::time_point TraderTimer::expiry() const
+{
+    if (!mSimulation)
+    {
+        return time_point(mTimer->expiry().time_since_epoch());
+    }
+    return mExpiry;
+}
+
+std::size_t TraderTimer::expires_at(time_point expiryTime)
+{
+    if (!mSimulation)
+    {
+        return mTimer->expires_at(std::chrono::steady_clock::time_point(expiryTime.time_since_epoch()));
+    }
+    const std::size_t cancelled = cancel();
+    mExpiry = expiryTime;
+    return cancelled;
+}
+
+SimulatedClock::SimulatedClock() : mPrevious(installedClock)
+{
+    installedClock = this;
+}
+
+SimulatedClock::~SimulatedClock()
+{
+    installedClock = mPrevious;
+}
+
+SimulatedClock* SimulatedClock::GetInstalled() noexcept
+{
+    return installedClock;
+}
+
+void SimulatedClock::Add(TraderTimer& timer)
+{
+    timer.mSequenceNumber = mNextSequenceNumber++;
+    mWaiting.emplace(timer.mExpiry, timer.mSequenceNumber, &timer);
+}
+
+void SimulatedClock::Remove(TraderTimer& timer)
+{
+    mWaiting.erase({timer.mExpiry, timer.mSequenceNumber, &timer});
+}
+
+std::size_t SimulatedClock::Run(boost::asio::io_context& context)
+{
+    if (installedClock != this)
+    {
+        throw ReadyTraderGoError("a simulated clock must be run on the thread it is installed on");
+    }
+
+    // Without the guard, the context would stop itself whenever it ran out
+    // of handlers between timers
+    auto work = boost::asio::make_work_guard(context);
+    std::size_t count = 0;
+    while (!context.stopped())
+    {
+        // Timers that are due complete before any more handlers run, as they
+        // would the next time a running context checked its timers
+        while (!mWaiting.empty() && std::get<0>(*mWaiting.begin()) <= mNow)
+        {
+            TraderTimer* timer = std::get<2>(*mWaiting.begin());
+            mWaiting.erase(mWaiting.begin());
+            timer->Complete(boost::system::error_code());
+        }
+
+        const std::size_t handled = context.poll();
+        count += handled;
+        if (handled == 0)
+        {
+            if (mWaiting.empty())
+            {
+                break;
+            }
+            mNow = std::max(mNow, std::get<0>(*mWaiting.begin()));
+        }
+    }
+    return count;
+}
+
+}
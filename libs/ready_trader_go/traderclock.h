@@ -0,0 +1,162 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRADERCLOCK_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRADERCLOCK_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace ReadyTraderGo {
+
+class SimulatedClock;
+
+// The clock every time limit and timer in an auto-trader is measured by. It
+// is the steady clock, unless a SimulatedClock is installed on the calling
+// thread, in which case it is the simulated time.
+struct TraderClock
+{
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<TraderClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept;
+};
+
+// A timer on the TraderClock, with the same interface as
+// boost::asio::steady_timer (as much of it as auto-traders use).
+//
+// A timer made while a SimulatedClock is installed belongs to that
+// simulation: it expires when the simulated time reaches its expiry, and the
+// simulation must outlive it. Otherwise it is an ordinary steady timer.
+class TraderTimer
+{
+public:
+    using clock_type = TraderClock;
+    using duration = TraderClock::duration;
+    using time_point = TraderClock::time_point;
+
+    explicit TraderTimer(boost::asio::io_context& context);
+    ~TraderTimer();
+
+    TraderTimer(const TraderTimer&) = delete;
+    TraderTimer& operator=(const TraderTimer&) = delete;
+
+    // Cancel any waits, which complete with operation_aborted, and return
+    // how many there were
+    std::size_t cancel();
+
+    time_point expiry() const;
+    std::size_t expires_after(duration expiryTime) { return expires_at(TraderClock::now() + expiryTime); }
+    std::size_t expires_at(time_point expiryTime);
+
+    template<typename WaitHandler>
+    void async_wait(WaitHandler&& handler);
+
+private:
+    friend class SimulatedClock;
+
+    using Handler = std::function<void(const boost::system::error_code&)>;
+
+    std::size_t Complete(const boost::system::error_code& error);
+
+    boost::asio::io_context& mContext;
+    SimulatedClock* mSimulation;
+    std::optional<boost::asio::steady_timer> mTimer;
+
+    // Only used in a simulation
+    time_point mExpiry;
+    unsigned long mSequenceNumber = 0;
+    std::vector<Handler> mHandlers;
+};
+
+// Simulated time, for running an auto-trader against a backtest faster than
+// real time and with the same result every time.
+//
+// A SimulatedClock is installed on the thread that makes it, for as long as
+// it exists, and TraderClock::now() returns its time on that thread. Time
+// only moves when Run finds nothing left to do at the current time, at which
+// point it jumps to the expiry of the next TraderTimer. Handlers therefore
+// take no simulated time at all.
+class SimulatedClock
+{
+public:
+    // The time a simulation starts at. Any time would do, as long as it's
+    // always the same one.
+    static constexpr TraderClock::time_point START{std::chrono::hours(24)};
+
+    SimulatedClock();
+    ~SimulatedClock();
+
+    SimulatedClock(const SimulatedClock&) = delete;
+    SimulatedClock& operator=(const SimulatedClock&) = delete;
+
+    // The simulation installed on the calling thread, if there is one
+    static SimulatedClock* GetInstalled() noexcept;
+
+    TraderClock::time_point Now() const noexcept { return mNow; }
+
+    // Run the context's handlers, and its timers in order of expiry, until
+    // there are none left or the context is stopped. Every timer in the
+    // simulation must be on this context. Returns the number of handlers
+    // run.
+    std::size_t Run(boost::asio::io_context& context);
+
+private:
+    friend class TraderTimer;
+
+    void Add(TraderTimer& timer);
+    void Remove(TraderTimer& timer);
+
+    SimulatedClock* mPrevious;
+    TraderClock::time_point mNow = START;
+    unsigned long mNextSequenceNumber = 0;
+    // Timers with waits, by expiry and then in the order they started
+    // waiting
+    std::set<std::tuple<TraderClock::time_point, unsigned long, TraderTimer*>> mWaiting;
+};
+
+template<typename WaitHandler>
+void TraderTimer::async_wait(WaitHandler&& handler)
+{
+    if (!mSimulation)
+    {
+        mTimer->async_wait(std::forward<WaitHandler>(handler));
+        return;
+    }
+    if (mHandlers.empty())
+    {
+        mSimulation->Add(*this);
+    }
+    mHandlers.emplace_back(std::forward<WaitHandler>(handler));
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRADERCLOCK_H
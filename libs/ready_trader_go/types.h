@@ -19,8 +19,10 @@
 #define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TYPES_H
 
 #include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <stdexcept>
+#include <type_traits>
 
 namespace ReadyTraderGo {
 
@@ -28,10 +30,43 @@ constexpr unsigned long MAXIMUM_ASK = 2147483647;
 constexpr unsigned long MINIMUM_BID = 1;
 constexpr std::size_t TOP_LEVEL_COUNT = 5;
 
+// Prices and volumes are four bytes on the wire and are stored in four bytes
+// too, so that the top levels of a book (20 fields) take 80 rather than 160
+// bytes. Each kind of value has its own type, so a price can't be passed
+// where a volume is expected, but both convert implicitly from and to
+// unsigned long so arithmetic happens at the same width as before.
+template<typename Tag>
+class TypedLong
+{
+public:
+    constexpr TypedLong() noexcept = default;
+    constexpr TypedLong(unsigned long value) noexcept : mValue(static_cast<uint32_t>(value)) {}
+
+    constexpr operator unsigned long() const noexcept { return mValue; }
+
+private:
+    uint32_t mValue = 0;
+};
+
+using Price = TypedLong<struct PriceTag>;
+using Volume = TypedLong<struct VolumeTag>;
+
+static_assert(sizeof(Price) == 4 && std::is_trivially_copyable<Price>::value,
+              "Price must be a four-byte, trivially copyable type");
+static_assert(sizeof(Volume) == 4 && std::is_trivially_copyable<Volume>::value,
+              "Volume must be a four-byte, trivially copyable type");
+
 enum class Instrument : unsigned char { FUTURE, ETF };
 enum class Lifespan : unsigned char { FILL_AND_KILL, GOOD_FOR_DAY };
 enum class Side : unsigned char { SELL, BUY };
 
+template<typename C, typename T, typename Tag>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, TypedLong<Tag> value)
+{
+    strm << static_cast<unsigned long>(value);
+    return strm;
+}
+
 template<typename C, typename T>
 std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, Instrument inst)
 {
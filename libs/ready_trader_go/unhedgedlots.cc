@@ -0,0 +1,97 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "error.h"
+#include "unhedgedlots.h"
+
+namespace ReadyTraderGo {
+
+UnhedgedLots::UnhedgedLots(boost::asio::io_context& context, Clock::duration warning, Clock::duration timeLimit)
+    : mTimer(context), mWarning(warning), mTimeLimit(timeLimit)
+{
+    if (warning < Clock::duration::zero() || timeLimit <= Clock::duration::zero())
+    {
+        throw ReadyTraderGoError("unhedged lots warning must not be negative and time limit must be positive");
+    }
+}
+
+void UnhedgedLots::Update(long relativePosition, Clock::time_point now)
+{
+    // The same transitions as the exchange's: crossing back within the limit
+    // stops the timer, and crossing beyond it (from either direction)
+    // starts it afresh
+    const long excess = excessUnhedgedLots(relativePosition);
+    const long direction = (excess > 0) - (excess < 0);
+    if (direction != mDirection)
+    {
+        Stop();
+        if (direction != 0)
+        {
+            Start(direction, now);
+        }
+    }
+}
+
+void UnhedgedLots::SetTimer()
+{
+    mTimer.expires_at(mDeadline - mWarning);
+    mTimer.async_wait([this](const boost::system::error_code& error) {
+        // A wait that completed just before the timer was stopped or moved
+        // may still arrive, so check the time as well as the error
+        if (!error && IsExpiring() && Expiring)
+        {
+            Expiring();
+        }
+    });
+}
+
+void UnhedgedLots::SetWarning(Clock::duration warning)
+{
+    if (warning < Clock::duration::zero())
+    {
+        throw ReadyTraderGoError("unhedged lots warning must not be negative");
+    }
+    mWarning = warning;
+    if (IsTiming())
+    {
+        SetTimer();
+    }
+}
+
+void UnhedgedLots::SetTimeLimit(Clock::duration timeLimit)
+{
+    if (timeLimit <= Clock::duration::zero())
+    {
+        throw ReadyTraderGoError("unhedged lots time limit must be positive");
+    }
+    mTimeLimit = timeLimit;
+}
+
+void UnhedgedLots::Start(long direction, Clock::time_point now)
+{
+    mDirection = direction;
+    mDeadline = now + mTimeLimit;
+    SetTimer();
+}
+
+void UnhedgedLots::Stop()
+{
+    mDirection = 0;
+    mTimer.cancel();
+}
+
+}
@@ -0,0 +1,100 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_UNHEDGEDLOTS_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_UNHEDGEDLOTS_H
+
+#include <chrono>
+#include <functional>
+
+#include <boost/asio/io_context.hpp>
+
+#include "riskengine.h"
+#include "traderclock.h"
+
+namespace ReadyTraderGo {
+
+// How long the exchange lets a competitor hold more than UNHEDGED_LOTS_LIMIT
+// unhedged lots
+constexpr std::chrono::seconds UNHEDGED_LOTS_TIME_LIMIT{60};
+
+// How long before the deadline the warning is given, which leaves time for a
+// hedge to wait for the message frequency limit and reach the exchange
+constexpr std::chrono::seconds DEFAULT_UNHEDGED_LOTS_WARNING{5};
+
+// Mirrors the exchange's unhedged lots rule. The exchange starts a timer when
+// the relative position (ETF position plus future position) moves beyond
+// UNHEDGED_LOTS_LIMIT lots either way, stops it when the position comes back,
+// and disconnects the competitor if it expires.
+//
+// This class runs the same timer on the auto-trader's side and calls
+// Expiring a configurable time before the deadline, so that the auto-trader
+// can leave fills unhedged while they net off against each other, and send a
+// single hedge for whatever is left when it has to. It keeps no position of
+// its own: whoever does (an auto-trader's RiskEngine, say) passes the relative
+// position to Update whenever it changes.
+class UnhedgedLots
+{
+public:
+    using Clock = TraderClock;
+
+    explicit UnhedgedLots(boost::asio::io_context& context,
+                          Clock::duration warning = DEFAULT_UNHEDGED_LOTS_WARNING,
+                          Clock::duration timeLimit = UNHEDGED_LOTS_TIME_LIMIT);
+
+    UnhedgedLots(const UnhedgedLots&) = delete;
+    UnhedgedLots& operator=(const UnhedgedLots&) = delete;
+
+    // Apply a new relative position, after an order fill or a hedge fill
+    void Update(long relativePosition, Clock::time_point now = Clock::now());
+
+    // Called when the warning time is reached
+    std::function<void()> Expiring;
+
+    // When the exchange's timer is running, the time it will expire
+    bool IsTiming() const noexcept { return mDirection != 0; }
+    Clock::time_point GetDeadline() const noexcept { return mDeadline; }
+
+    // Return true if the timer is running and the warning time has passed,
+    // in which case a hedge shouldn't wait
+    bool IsExpiring(Clock::time_point now = Clock::now()) const noexcept
+    {
+        return IsTiming() && now >= mDeadline - mWarning;
+    }
+
+    Clock::duration GetWarning() const noexcept { return mWarning; }
+    void SetWarning(Clock::duration warning);
+
+    // A new time limit applies from the next time the timer starts
+    Clock::duration GetTimeLimit() const noexcept { return mTimeLimit; }
+    void SetTimeLimit(Clock::duration timeLimit);
+
+private:
+    void Start(long direction, Clock::time_point now);
+    void Stop();
+    void SetTimer();
+
+    TraderTimer mTimer;
+    Clock::duration mWarning;
+    Clock::duration mTimeLimit;
+    long mDirection = 0;  // the sign of the excess being timed, or zero
+    Clock::time_point mDeadline;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_UNHEDGEDLOTS_H
@@ -24,6 +24,7 @@ from typing import Coroutine, Optional, Tuple, Union
 
 BUFFER_SIZE = 8192
 FRAME_HEADER_SIZE = 8
+FRAME_GENERATION_MASK = 0xFFFFFF
 FRAME_SIZE = 128
 MAXIMUM_PAYLOAD_LENGTH = FRAME_SIZE - FRAME_HEADER_SIZE
 
@@ -35,12 +36,13 @@ class Publisher(asyncio.WriteTransport):
     memory blocks. There must be an interval between writes to permit
     subscribers to read the data before it is overwritten.
     """
-    __slots__ = ("__pack_into", "_buffer", "_closed", "_pos")
+    __slots__ = ("__pack_into", "_buffer", "_closed", "_generation", "_pos")
 
     def __init__(self, buffer: Union[mmap.mmap, memoryview], protocol: asyncio.BaseProtocol):
         super().__init__()
         self._buffer: Optional[Union[mmap.mmap, memoryview]] = buffer
         self._closed: bool = False
+        self._generation: int = 0
         self._pos: int = 0
         asyncio.get_event_loop().call_soon(protocol.connection_made, self)
 
@@ -71,12 +73,18 @@ class Publisher(asyncio.WriteTransport):
             return
 
         # Each frame contains a spinlock (4 bytes), payload length (4 bytes)
-        # and payload (up to 120 bytes).
+        # and payload (up to 120 bytes). The first byte of the spinlock is the
+        # flag and the other three hold the generation (the number of times
+        # the publisher has wrapped around the buffer) so that subscribers can
+        # tell when they have been overrun.
         pos = self._pos
         self.__pack_into(self._buffer, pos + 4, len(data))
         start: int = pos + FRAME_HEADER_SIZE
         self._buffer[start:start + len(data)] = bytes(data)
+        self._buffer[pos + 1:pos + 4] = self._generation.to_bytes(3, "little")
         self._pos = (pos + FRAME_SIZE) & (BUFFER_SIZE - 1)
+        if self._pos == 0:
+            self._generation = (self._generation + 1) & FRAME_GENERATION_MASK
         self._buffer[self._pos] = 0
         self._buffer[pos] = 1
 
@@ -0,0 +1,403 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <backtest/backtest.h>
+#include <backtest/marketevents.h>
+#include <backtest/workstealingpool.h>
+#include <ready_trader_go/config.h>
+#include <ready_trader_go/error.h>
+
+#include "trader-3.h"
+
+using namespace ReadyTraderGo;
+
+static void usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [OPTION...] [MARKET_DATA_FILE...]\n"
+              << "\n"
+              << "Backtest the auto-trader over each market data file (by default, every\n"
+              << "data/market_data* file) for every combination of the parameter values\n"
+              << "given, and print one row of results per combination. Each parameter is\n"
+              << "given as a comma-separated list, and defaults to its value in the\n"
+              << "auto-trader's configuration. A combination given more than once must\n"
+              << "give the same results every time, or the sweep fails.\n"
+              << "\n"
+              << "  --exchange FILE         exchange configuration (default exchange.json)\n"
+              << "  --trader FILE           auto-trader configuration (default trader-3.json)\n"
+              << "  --jobs N                backtests to run at once (default one per hardware thread)\n"
+              << "  --start SECONDS         time to start trading, after the market has opened (default 0)\n"
+              << "  --end SECONDS           time after which market events are ignored (default none)\n"
+              << "  --lot-size LIST         volume of each quote\n"
+              << "  --arbitrage-limit LIST  ETF position beyond which arbitrage isn't taken\n"
+              << "  --quote-offset LIST     ticks from the future's best prices to the nearest quotes\n"
+              << "  --depth-cutoff LIST     lots of other orders behind which nothing is quoted\n";
+}
+
+static boost::property_tree::ptree readConfig(const std::string& filename)
+{
+    boost::property_tree::ptree tree;
+    try
+    {
+        boost::property_tree::read_json(filename, tree);
+    }
+    catch (const boost::property_tree::json_parser_error& err)
+    {
+        throw ReadyTraderGoError("failed while reading configuration file: '" + filename + "': " + err.message());
+    }
+    return tree;
+}
+
+template<typename T>
+static std::vector<T> parseList(const std::string& option, const std::string& text)
+{
+    std::vector<T> values;
+    std::istringstream stream{text};
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        std::istringstream itemStream{item};
+        T value;
+        if (!(itemStream >> value) || !itemStream.eof())
+        {
+            throw ReadyTraderGoError("invalid value '" + item + "' for " + option);
+        }
+        values.push_back(value);
+    }
+    if (values.empty())
+    {
+        throw ReadyTraderGoError("no values given for " + option);
+    }
+    return values;
+}
+
+// The market data files in the data directory, CSV or binary
+static std::vector<std::string> findMarketDataFiles()
+{
+    std::vector<std::string> filenames;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("data", error))
+    {
+        const std::string name = entry.path().filename().string();
+        const std::string extension = entry.path().extension().string();
+        if (entry.is_regular_file() && name.rfind("market_data", 0) == 0
+            && (extension == ".csv" || extension == ".bin"))
+        {
+            filenames.push_back(entry.path().string());
+        }
+    }
+    std::sort(filenames.begin(), filenames.end());
+    return filenames;
+}
+
+// A parameter combination's results over every market data file
+struct SweepRow
+{
+    StrategyParameters mParameters;
+    unsigned long mDayCount = 0;
+    unsigned long mBreachCount = 0;
+    long mTotalProfitOrLoss = 0;
+    long mMinProfitOrLoss = 0;
+    long mMaxDrawdown = 0;
+    long mTotalFees = 0;
+    unsigned long mMessageCount = 0;
+    std::string mBreaches;  // file and reason of each breach
+};
+
+static bool isSameParameters(const StrategyParameters& a, const StrategyParameters& b)
+{
+    return a.mLotSize == b.mLotSize && a.mArbitrageLimit == b.mArbitrageLimit && a.mQuoteOffset == b.mQuoteOffset
+           && a.mUnhedgedLotsWarning == b.mUnhedgedLotsWarning && a.mDepthCutoff == b.mDepthCutoff;
+}
+
+// Everything about a backtest's outcome except how long it took
+static bool isSameResult(const BacktestResult& a, const BacktestResult& b)
+{
+    return a.mStatus == b.mStatus && a.mBreachReason == b.mBreachReason && a.mEndTime == b.mEndTime
+           && a.mProfitOrLoss == b.mProfitOrLoss && a.mMaxDrawdown == b.mMaxDrawdown
+           && a.mTotalFees == b.mTotalFees && a.mAccountBalance == b.mAccountBalance
+           && a.mEtfPosition == b.mEtfPosition && a.mFuturePosition == b.mFuturePosition
+           && a.mBuyVolume == b.mBuyVolume && a.mSellVolume == b.mSellVolume
+           && a.mMarketEventCount == b.mMarketEventCount && a.mMessageCount == b.mMessageCount
+           && a.mErrorCount == b.mErrorCount;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string exchangeFilename = "exchange.json";
+    std::string traderFilename = "trader-3.json";
+    std::size_t jobs = 0;
+    double startTime = 0.0;
+    double endTime = 0.0;
+    std::vector<std::string> marketDataFilenames;
+    std::vector<long> lotSizes;
+    std::vector<long> arbitrageLimits;
+    std::vector<unsigned long> quoteOffsets;
+    std::vector<long> depthCutoffs;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const bool hasValue = i + 1 < argc;
+            if (std::strcmp(argv[i], "--exchange") == 0 && hasValue)
+            {
+                exchangeFilename = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--trader") == 0 && hasValue)
+            {
+                traderFilename = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--start") == 0 && hasValue)
+            {
+                startTime = std::strtod(argv[++i], nullptr);
+            }
+            else if (std::strcmp(argv[i], "--end") == 0 && hasValue)
+            {
+                endTime = std::strtod(argv[++i], nullptr);
+            }
+            else if (std::strcmp(argv[i], "--jobs") == 0 && hasValue)
+            {
+                jobs = std::strtoul(argv[++i], nullptr, 10);
+            }
+            else if (std::strcmp(argv[i], "--lot-size") == 0 && hasValue)
+            {
+                lotSizes = parseList<long>(argv[i], argv[i + 1]);
+                ++i;
+            }
+            else if (std::strcmp(argv[i], "--arbitrage-limit") == 0 && hasValue)
+            {
+                arbitrageLimits = parseList<long>(argv[i], argv[i + 1]);
+                ++i;
+            }
+            else if (std::strcmp(argv[i], "--quote-offset") == 0 && hasValue)
+            {
+                quoteOffsets = parseList<unsigned long>(argv[i], argv[i + 1]);
+                ++i;
+            }
+            else if (std::strcmp(argv[i], "--depth-cutoff") == 0 && hasValue)
+            {
+                depthCutoffs = parseList<long>(argv[i], argv[i + 1]);
+                ++i;
+            }
+            else if (argv[i][0] == '-')
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            else
+            {
+                marketDataFilenames.emplace_back(argv[i]);
+            }
+        }
+
+        // The auto-traders' log messages would outnumber everything else
+        boost::log::core::get()->set_logging_enabled(false);
+
+        BacktestConfig backtestConfig;
+        backtestConfig.readFromPropertyTree(readConfig(exchangeFilename));
+        backtestConfig.mStartTime = startTime;
+        backtestConfig.mEndTime = endTime;
+        Config traderConfig;
+        traderConfig.readFromPropertyTree(readConfig(traderFilename));
+        StrategyParameters configured;
+        configured.readFromPropertyTree(traderConfig.mStrategy);
+        if (lotSizes.empty())
+        {
+            lotSizes.push_back(configured.mLotSize);
+        }
+        if (arbitrageLimits.empty())
+        {
+            arbitrageLimits.push_back(configured.mArbitrageLimit);
+        }
+        if (quoteOffsets.empty())
+        {
+            quoteOffsets.push_back(configured.mQuoteOffset);
+        }
+        if (depthCutoffs.empty())
+        {
+            depthCutoffs.push_back(configured.mDepthCutoff);
+        }
+
+        if (marketDataFilenames.empty())
+        {
+            marketDataFilenames = findMarketDataFiles();
+        }
+        if (marketDataFilenames.empty())
+        {
+            throw ReadyTraderGoError("no market data files given or found in the data directory");
+        }
+
+        // Each day is read once and shared by every backtest of it
+        std::vector<MarketEvents> days;
+        for (const std::string& filename : marketDataFilenames)
+        {
+            days.push_back(readMarketEvents(filename));
+        }
+
+        std::vector<StrategyParameters> grid;
+        for (long lotSize : lotSizes)
+        {
+            for (long arbitrageLimit : arbitrageLimits)
+            {
+                for (unsigned long quoteOffset : quoteOffsets)
+                {
+                    for (long depthCutoff : depthCutoffs)
+                    {
+                        StrategyParameters& parameters = grid.emplace_back(configured);
+                        parameters.mLotSize = lotSize;
+                        parameters.mArbitrageLimit = arbitrageLimit;
+                        parameters.mQuoteOffset = quoteOffset;
+                        parameters.mDepthCutoff = depthCutoff;
+                    }
+                }
+            }
+        }
+
+        // Every backtest has its own context, exchange and auto-trader, and
+        // writes only its own result
+        std::vector<BacktestResult> results(grid.size() * days.size());
+        std::mutex progressMutex;
+        std::size_t finishedCount = 0;
+        {
+            WorkStealingPool pool{jobs};
+            std::cerr << "running " << results.size() << " backtests (" << grid.size() << " parameter sets x "
+                      << days.size() << " days) on " << pool.GetThreadCount() << " threads" << std::endl;
+
+            for (std::size_t g = 0; g < grid.size(); ++g)
+            {
+                for (std::size_t d = 0; d < days.size(); ++d)
+                {
+                    pool.Submit([&, g, d] {
+                        SimulatedClock clock;
+                        boost::asio::io_context context;
+                        AutoTrader trader{context};
+                        configureAutoTrader(trader, traderConfig);
+                        trader.SetParameters(grid[g]);
+                        Backtest backtest{context, backtestConfig, days[d]};
+                        backtest.Start(trader);
+                        clock.Run(context);
+                        results[g * days.size() + d] = backtest.GetResult();
+
+                        std::lock_guard<std::mutex> lock(progressMutex);
+                        std::cerr << '[' << ++finishedCount << '/' << results.size() << "] "
+                                  << marketDataFilenames[d] << " lot size " << grid[g].mLotSize
+                                  << ", arbitrage limit " << grid[g].mArbitrageLimit << ", quote offset "
+                                  << grid[g].mQuoteOffset << ", depth cutoff " << grid[g].mDepthCutoff << ": "
+                                  << backtest.GetResult().mStatus << ' '
+                                  << backtest.GetResult().mProfitOrLoss << std::endl;
+                    });
+                }
+            }
+            pool.Wait();
+        }
+
+        // Backtests run on a simulated clock, so a parameter combination
+        // given more than once must get exactly the same results each time
+        for (std::size_t g = 0; g < grid.size(); ++g)
+        {
+            for (std::size_t h = g + 1; h < grid.size(); ++h)
+            {
+                if (!isSameParameters(grid[g], grid[h]))
+                {
+                    continue;
+                }
+                for (std::size_t d = 0; d < days.size(); ++d)
+                {
+                    if (!isSameResult(results[g * days.size() + d], results[h * days.size() + d]))
+                    {
+                        throw ReadyTraderGoError("repeated backtests of " + marketDataFilenames[d]
+                                                 + " with lot size " + std::to_string(grid[g].mLotSize)
+                                                 + ", arbitrage limit " + std::to_string(grid[g].mArbitrageLimit)
+                                                 + ", quote offset " + std::to_string(grid[g].mQuoteOffset)
+                                                 + ", depth cutoff " + std::to_string(grid[g].mDepthCutoff)
+                                                 + " gave different results");
+                    }
+                }
+            }
+        }
+
+        std::vector<SweepRow> rows;
+        for (std::size_t g = 0; g < grid.size(); ++g)
+        {
+            SweepRow& row = rows.emplace_back();
+            row.mParameters = grid[g];
+            for (std::size_t d = 0; d < days.size(); ++d)
+            {
+                const BacktestResult& result = results[g * days.size() + d];
+                row.mMinProfitOrLoss = (d == 0) ? result.mProfitOrLoss
+                                                : std::min(row.mMinProfitOrLoss, result.mProfitOrLoss);
+                ++row.mDayCount;
+                row.mTotalProfitOrLoss += result.mProfitOrLoss;
+                row.mMaxDrawdown = std::max(row.mMaxDrawdown, result.mMaxDrawdown);
+                row.mTotalFees += result.mTotalFees;
+                row.mMessageCount += result.mMessageCount;
+                if (result.mStatus != "OK")
+                {
+                    ++row.mBreachCount;
+                    row.mBreaches += (row.mBreaches.empty() ? "" : "; ") + marketDataFilenames[d] + ": "
+                                     + result.mBreachReason;
+                }
+            }
+        }
+
+        // Best first, and any combination that breached a limit after all
+        // those that didn't
+        std::stable_sort(rows.begin(), rows.end(), [](const SweepRow& a, const SweepRow& b) {
+            if ((a.mBreachCount == 0) != (b.mBreachCount == 0))
+            {
+                return a.mBreachCount == 0;
+            }
+            return a.mTotalProfitOrLoss > b.mTotalProfitOrLoss;
+        });
+
+        std::cout << "LotSize,ArbitrageLimit,QuoteOffset,DepthCutoff,Days,Breaches,TotalProfitOrLoss,MeanProfitOrLoss,"
+                     "MinProfitOrLoss,MaxDrawdown,TotalFees,Messages,BreachReasons\n";
+        for (const SweepRow& row : rows)
+        {
+            std::cout << row.mParameters.mLotSize << ',' << row.mParameters.mArbitrageLimit << ','
+                      << row.mParameters.mQuoteOffset << ',' << row.mParameters.mDepthCutoff << ',' << row.mDayCount
+                      << ',' << row.mBreachCount << ',' << row.mTotalProfitOrLoss << ','
+                      << row.mTotalProfitOrLoss / static_cast<long>(row.mDayCount) << ',' << row.mMinProfitOrLoss
+                      << ',' << row.mMaxDrawdown << ',' << row.mTotalFees << ',' << row.mMessageCount << ','
+                      << row.mBreaches << '\n';
+        }
+        std::cout << std::flush;
+    }
+    catch (const ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
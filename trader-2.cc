@@ -20,6 +20,7 @@
 #include <boost/asio/io_context.hpp>
 
 #include <ready_trader_go/logging.h>
+#include <ready_trader_go/positiontable.h>
 
 #include "trader-2.h"
 
@@ -32,16 +33,41 @@ constexpr int POSITION_LIMIT = 100;
 constexpr int TICK_SIZE_IN_CENTS = 100;
 constexpr int MIN_BID_NEARST_TICK = (MINIMUM_BID + TICK_SIZE_IN_CENTS) / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
 constexpr int MAX_ASK_NEAREST_TICK = MAXIMUM_ASK / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
+constexpr double RISK_FACTOR = 4.0;
 
-AutoTrader::AutoTrader(boost::asio::io_context& context) : BaseAutoTrader(context)
+// Quote volumes by position, worked out at compile time: the longer the
+// position, the smaller the bid and the bigger the ask
+constexpr auto BID_VOLUMES = PositionTable<int, POSITION_LIMIT>::Generate([](long position) {
+    long bid_vol = floorToLong((100 - position - RISK_FACTOR) / 2.0) - floorToLong(RISK_FACTOR / 2.0);
+    return (int)((bid_vol < 0) ? 0 : bid_vol);
+});
+constexpr auto ASK_VOLUMES = PositionTable<int, POSITION_LIMIT>::Generate([](long position) {
+    long ask_vol = floorToLong((100 + position - RISK_FACTOR) / 2.0) - floorToLong(RISK_FACTOR / 2.0);
+    return (int)((ask_vol < 0) ? 0 : ask_vol);
+});
+
+AutoTrader::AutoTrader(boost::asio::io_context& context) : BaseAutoTrader(context), mHedger(context)
 {
-    std::tie(bid_vol_map, ask_vol_map) = QuoteMaps(risk_factor);
+    mHedger.SendHedge = [this](Side side, Volume volume) -> unsigned long {
+        unsigned long price = (side == Side::BUY) ? MAX_ASK_NEAREST_TICK : MIN_BID_NEARST_TICK;
+        unsigned long hedgeId = mNextMessageId++;
+        // Scheduled rather than sent, so that a hedge the message frequency
+        // limit won't allow yet still goes out as soon as it does
+        ScheduleHedgeOrder(hedgeId, side, price, volume);
+        RLOG(LG_AT, LogLevel::LL_INFO) << "hedging " << volume << " lots at $" << price << " cents";
+        return hedgeId;
+    };
 }
 
 void AutoTrader::DisconnectHandler()
 {
     BaseAutoTrader::DisconnectHandler();
     RLOG(LG_AT, LogLevel::LL_INFO) << "execution connection lost";
+
+    const HedgeStats& stats = mHedger.GetStats();
+    RLOG(LG_AT, LogLevel::LL_INFO) << "hedged " << stats.mFillCount << " fills with " << stats.mHedgeCount
+                                   << " hedges, saving " << stats.GetMessagesSaved() << " messages; slippage "
+                                   << stats.mSlippage << " cents (" << stats.GetSlippagePerLot() << " per lot)";
 }
 
 void AutoTrader::ErrorMessageHandler(unsigned long clientOrderId,
@@ -60,6 +86,7 @@ void AutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId,
 {
     RLOG(LG_AT, LogLevel::LL_INFO) << "hedge order " << clientOrderId << " filled for " << volume
                                    << " lots at $" << price << " average price in cents";
+    mHedger.HedgeFilled(clientOrderId, price, volume);
 }
 
 void AutoTrader::OrderBookMessageHandler(Instrument instrument,
@@ -77,7 +104,6 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
 
     if (instrument == Instrument::FUTURE)
     {
-        std::cout<<"Future instrument\n"; 
         unsigned long theo_price = 0;
         
         if (bidVolumes[0] >= 500){
@@ -88,6 +114,7 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
             theo_price = (bidPrices[0]*bidVolumes[0] + bidPrices[1]*bidVolumes[1] + bidPrices[2]*bidVolumes[2] + askPrices[0]*askVolumes[0] + askPrices[1]*askVolumes[1] + askPrices[2]*askVolumes[2]) / (bidVolumes[0] + askVolumes[0] +  bidVolumes[1] + askVolumes[1] + bidVolumes[2] + askVolumes[2]);
         }
         
+        mFuturePrice = theo_price;
         unsigned long newBidPrice = (bidPrices[0] != 0) ? theo_price - 100 : 0;
         newBidPrice = newBidPrice/100 * 100;
         unsigned long newAskPrice = (askPrices[0] != 0) ? theo_price + 100 : 0;
@@ -96,38 +123,40 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
         // If the new quoted price differs from the existing quoted price, cancel the old order.
         if (mAskId != 0 && newAskPrice != 0 && (newAskPrice < mAskPrice-100 || newAskPrice > mAskPrice+100)){
             SendCancelOrder(mAskId);
-            std::cout<<"send FT [cancel ask order], newAskPrice is "<<newAskPrice<<" our ask price is "<<mAskPrice<<std::endl;
+            RLOG(LG_AT, LogLevel::LL_INFO) << "cancelling ask at $" << mAskPrice << " cents; new ask price is $"
+                                           << newAskPrice << " cents";
             mAskId = 0;
         }
         if (mBidId != 0 && newBidPrice != 0 && (newBidPrice < mBidPrice-100 || newBidPrice > mBidPrice+100)){
             SendCancelOrder(mBidId);
-            std::cout<<"send FT [cancel bid order], newBidPrice is "<<newBidPrice<<" our ask price is "<<mBidPrice<<std::endl;
+            RLOG(LG_AT, LogLevel::LL_INFO) << "cancelling bid at $" << mBidPrice << " cents; new bid price is $"
+                                           << newBidPrice << " cents";
             mBidId = 0;
         }
 
-        mAskVolume = ask_vol_map[mPosition];
-        mBidVolume = bid_vol_map[mPosition];
+        mAskVolume = ASK_VOLUMES[mPosition];
+        mBidVolume = BID_VOLUMES[mPosition];
         // Determine bid volume according to current position.
         if (mAskId == 0 && newAskPrice != 0 && mPosition > -POSITION_LIMIT && mAskVolume != 0){
             mAskId = mNextMessageId++;
             mAskPrice = newAskPrice;
-            std::cout<<"[FT Ask] mPosition is "<<mPosition<<" mAskVolume is "<<mAskVolume<<std::endl;
-            std::cout<<"send FT insert [SELL] order, our ask price is "<<mAskPrice<<std::endl;
+            RLOG(LG_AT, LogLevel::LL_INFO) << "asking " << mAskVolume << " lots at $" << mAskPrice
+                                           << " cents with position " << mPosition;
             SendInsertOrder(mAskId, Side::SELL, newAskPrice, mAskVolume, Lifespan::GOOD_FOR_DAY); // dynamic mAskVolume will consider market impact or minimize risk
             mAsks.emplace(mAskId);
         }
         if (mBidId == 0 && newBidPrice != 0 && mPosition < POSITION_LIMIT && mBidVolume != 0){
             mBidId = mNextMessageId++;
             mBidPrice = newBidPrice;
-            std::cout<<"[FT BID] mPosition is "<<mPosition<<" mAskVolume is "<<mBidPrice<<std::endl;
-            std::cout<<"send FT insert [BUY] order, our bid price is "<<mBidPrice<<std::endl;
+            RLOG(LG_AT, LogLevel::LL_INFO) << "bidding " << mBidVolume << " lots at $" << mBidPrice
+                                           << " cents with position " << mPosition;
             SendInsertOrder(mBidId, Side::BUY, newBidPrice, mBidVolume, Lifespan::GOOD_FOR_DAY);
             mBids.emplace(mBidId);
         }
     }
     /*
     else if (instrument == Instrument::ETF){
-        std::cout<<"ETF instrument\n"; 
+        RLOG(LG_AT, LogLevel::LL_INFO) << "ETF instrument";
         if (bidVolumes[0] != 0){
             unsigned long theo_price = 0;
             if (bidVolumes[0] >= 50){
@@ -142,33 +171,33 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
             newBidPrice = newBidPrice/100 * 100;
             unsigned long newAskPrice = (askPrices[0] != 0) ? theo_price + 10 : 0;
             newAskPrice = newAskPrice/100 * 100;
-            std::cout<<"ETF newAskPrice is "<<newAskPrice<<" our ask price is "<<std::endl;
+            RLOG(LG_AT, LogLevel::LL_INFO) << "ETF newAskPrice is " << newAskPrice << " our ask price is ";
 
             // If the new quoted price differs from the existing quoted price, cancel the old order.
             if (mAskId != 0 && newAskPrice != 0 && newAskPrice != mAskPrice){
                 SendCancelOrder(mAskId);
-                std::cout<<"send ETF cancel order, newAskPrice is "<<newAskPrice<<" our ask price is "<<mAskPrice<<std::endl;
+                RLOG(LG_AT, LogLevel::LL_INFO) << "send ETF cancel order, newAskPrice is " << newAskPrice << " our ask price is " << mAskPrice;
                 mAskId = 0;
             }
             if (mBidId != 0 && newBidPrice != 0 && newBidPrice != mBidPrice){
                 SendCancelOrder(mBidId);
-                std::cout<<"send ETF cancel order newBidPrice is "<<newBidPrice<<" our ask price is "<<mBidPrice<<std::endl;
+                RLOG(LG_AT, LogLevel::LL_INFO) << "send ETF cancel order newBidPrice is " << newBidPrice << " our ask price is " << mBidPrice;
                 mBidId = 0;
             }
-            mAskVolume = ask_vol_map[mPosition];
-            mBidVolume = bid_vol_map[mPosition];
+            mAskVolume = ASK_VOLUMES[mPosition];
+            mBidVolume = BID_VOLUMES[mPosition];
             // Determine bid volume according to current position.
             if (mAskId == 0 && newAskPrice != 0 && mPosition > -POSITION_LIMIT && mAskVolume != 0){
                 mAskId = mNextMessageId++;
                 mAskPrice = newAskPrice;
-                std::cout<<"send ETF insert order, newAskPrice is "<<newAskPrice<<" our ask price is "<<mAskPrice<<std::endl;
+                RLOG(LG_AT, LogLevel::LL_INFO) << "send ETF insert order, newAskPrice is " << newAskPrice << " our ask price is " << mAskPrice;
                 SendInsertOrder(mAskId, Side::SELL, askPrices[0]-2, mAskVolume, Lifespan::GOOD_FOR_DAY); // dynamic mAskVolume will consider market impact or minimize risk
                 mAsks.emplace(mAskId);
             }
             if (mBidId == 0 && newBidPrice != 0 && mPosition < POSITION_LIMIT && mBidVolume != 0){
                 mBidId = mNextMessageId++;
                 mBidPrice = newBidPrice;
-                std::cout<<"send ETF insert order newBidPrice is "<<newBidPrice<<" our ask price is "<<mBidPrice<<std::endl;
+                RLOG(LG_AT, LogLevel::LL_INFO) << "send ETF insert order newBidPrice is " << newBidPrice << " our ask price is " << mBidPrice;
                 SendInsertOrder(mBidId, Side::BUY, bidPrices[0]+5, mBidVolume, Lifespan::GOOD_FOR_DAY);
                 mBids.emplace(mBidId);
             }
@@ -183,17 +212,16 @@ void AutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId,
 {
     RLOG(LG_AT, LogLevel::LL_INFO) << "order " << clientOrderId << " filled for " << volume
                                    << " lots at $" << price << " cents";
+    // fills in the same event loop turn are hedged together, once they net off
     if (mAsks.count(clientOrderId) == 1)
     {
         mPosition -= (long)volume;
-        SendHedgeOrder(mNextMessageId++, Side::BUY, MAX_ASK_NEAREST_TICK, volume);
-        std::cout<<"send [buy hedge order], ask price is "<<MAX_ASK_NEAREST_TICK<<std::endl;
+        mHedger.AddFill(Side::SELL, volume, mFuturePrice);
     }
     else if (mBids.count(clientOrderId) == 1)
     {
         mPosition += (long)volume;
-        SendHedgeOrder(mNextMessageId++, Side::SELL, MIN_BID_NEARST_TICK, volume);
-        std::cout<<"send [sell hedge order], sell price is "<<MIN_BID_NEARST_TICK<<std::endl;
+        mHedger.AddFill(Side::BUY, volume, mFuturePrice);
     }
 }
 
@@ -231,26 +259,3 @@ void AutoTrader::TradeTicksMessageHandler(Instrument instrument,
                                    << "; bid prices: " << bidPrices[0]
                                    << "; bid volumes: " << bidVolumes[0];
 }
-
-std::pair<std::map<int, int>, std::map<int, int>> AutoTrader::QuoteMaps(float riskFactor){
-    std::map<int, int> bid_vol_map;
-    std::map<int, int> ask_vol_map;
-
-    for (int position = -100; position <= 100; ++position) {
-        int bid_vol = std::floor(((100 - position - riskFactor) / 2.0)) - std::floor(riskFactor / 2.0);
-        bid_vol = (bid_vol < 0) ? 0 : bid_vol;
-
-        int ask_vol = 0;
-        if (position < 0) {
-            ask_vol = std::floor(((100 - std::abs(position) - riskFactor) / 2.0)) - std::floor(riskFactor / 2.0);
-        } else {
-            ask_vol = std::floor(((100 + std::abs(position) - riskFactor) / 2.0)) - std::floor(riskFactor / 2.0);
-        }
-        ask_vol = (ask_vol < 0) ? 0 : ask_vol;
-
-        bid_vol_map[position] = bid_vol;
-        ask_vol_map[position] = ask_vol;
-    }
-
-    return std::make_pair(bid_vol_map, ask_vol_map);
-}
@@ -22,13 +22,12 @@
 #include <memory>
 #include <string>
 #include <unordered_set>
-#include <map>
 #include <cmath>
 #include <ctime>
-#include <iostream>
 #include <boost/asio/io_context.hpp>
 
 #include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/hedgeaggregator.h>
 #include <ready_trader_go/types.h>
 
 class AutoTrader : public ReadyTraderGo::BaseAutoTrader
@@ -100,9 +99,6 @@ public:
     // Called periodically when there is trading activity on the market
     // called when position change
     void PositionChangeMessageHandler(int futurePosition, int etfPosition);
-    
-    // Return bid and ask quote maps
-    std::pair<std::map<int, int>, std::map<int, int>> QuoteMaps(float riskFactor);
 
 private:
     unsigned long mNextMessageId = 1;
@@ -113,10 +109,10 @@ private:
     unsigned long mBidPrice = 0;
     unsigned long mBidVolume = 0;
     signed long mPosition = 0;
+    unsigned long mFuturePrice = 0; // theo price of the latest future order book
 
-    float risk_factor = 4.0;
-    std::map<int, int> bid_vol_map;
-    std::map<int, int> ask_vol_map;
+    // nets the fills of each event loop turn into one hedge
+    ReadyTraderGo::HedgeAggregator mHedger;
 
     // for Exchange rules
     unsigned int action_cnt = 0;
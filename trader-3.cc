@@ -16,8 +16,12 @@
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <chrono>
+
 #include <boost/asio/io_context.hpp>
 
+#include <ready_trader_go/error.h>
 #include <ready_trader_go/logging.h>
 
 #include "trader-3.h"
@@ -26,120 +30,131 @@ using namespace ReadyTraderGo;
 
 RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_AT, "AUTO")
 
-constexpr int LOT_SIZE = 20;
-constexpr int POSITION_LIMIT = 100;
-constexpr int ARBITRAGE_LIMIT = 20;
 constexpr int TICK_SIZE_IN_CENTS = 100;
 constexpr int MIN_BID_NEARST_TICK = (MINIMUM_BID + TICK_SIZE_IN_CENTS) / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
 constexpr int MAX_ASK_NEAREST_TICK = MAXIMUM_ASK / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
 
-AutoTrader::AutoTrader(boost::asio::io_context& context) : BaseAutoTrader(context)
+AutoTrader::AutoTrader(boost::asio::io_context& context)
+    : BaseAutoTrader(context), mUnhedgedLots(context), mHedger(context, MANUAL_HEDGE_WINDOW)
 {
+    mUnhedgedLots.Expiring = [this]() {
+        RLOG(LG_AT, LogLevel::LL_INFO) << "unhedged lots timer expiring at relative position "
+                                       << mRiskEngine.GetUnhedgedLots();
+        mHedger.Flush();
+    };
+    mHedger.SendHedge = [this](Side side, Volume volume) {
+        return sendHedgeOrder(side == Side::BUY ? MAX_ASK_NEAREST_TICK : MIN_BID_NEARST_TICK, volume, side);
+    };
 }
 
 void AutoTrader::DisconnectHandler()
 {
     BaseAutoTrader::DisconnectHandler();
     RLOG(LG_AT, LogLevel::LL_INFO) << "execution connection lost";
+
+    const HedgeStats& stats = mHedger.GetStats();
+    RLOG(LG_AT, LogLevel::LL_INFO) << "hedged " << stats.mFillCount << " fills (" << stats.mFillVolume
+                                   << " lots, " << stats.mNettedVolume << " netted) with " << stats.mHedgeCount
+                                   << " hedges, saving " << stats.GetMessagesSaved() << " messages; slippage "
+                                   << stats.mSlippage << " cents (" << stats.GetSlippagePerLot() << " per lot)";
 }
 
 void AutoTrader::ErrorMessageHandler(unsigned long clientOrderId,
                                      const std::string& errorMessage)
 {
     RLOG(LG_AT, LogLevel::LL_INFO) << "error with order " << clientOrderId << ": " << errorMessage;
-    if (clientOrderId != 0 && (mAsks.count(clientOrderId) || mBids.count(clientOrderId)))
+    if (clientOrderId != 0 && mOrders.Find(clientOrderId))
     {
         OrderStatusMessageHandler(clientOrderId, 0, 0, 0);
     }
-}
-
-bool AutoTrader::checkMessageLimit() {
-    double current_time = std::time(nullptr);
-    while (orderTimestamps.size() > 0 && orderTimestamps.front() < current_time - 1.01) {
-        orderTimestamps.pop_front();
-    }
-    if (orderTimestamps.size() >= 50) {
-        return false;
+    else if (hedgeBid.count(clientOrderId) || hedgeAsk.count(clientOrderId))
+    {
+        HedgeFilledMessageHandler(clientOrderId, Price(0), Volume(0));
     }
-    orderTimestamps.push_back(current_time);
-    return true;
 }
 
 bool AutoTrader::sendBidOrder(unsigned long price, long volume, Lifespan lifespanType) {
-    if (!checkMessageLimit()) {
+    unsigned long bidId = mNextMessageId;
+    Volume clipped = mRiskEngine.ClipInsert(Side::BUY, volume);
+    if (clipped == 0 || mOrders.IsFull() || !SendInsertOrder(bidId, Side::BUY, price, clipped, lifespanType)) {
         return false;
     }
-    
-    unsigned long bidId = mNextMessageId++;
-    SendInsertOrder(bidId, Side::BUY, price, volume, lifespanType);
-    mBids[bidId] = price;
+    mNextMessageId++;
+    mOrders.Insert(bidId, Side::BUY, price, clipped, lifespanType);
+    mRiskEngine.OnInsert(Side::BUY, clipped);
     return true;
 }
 
 bool AutoTrader::sendAskOrder(unsigned long price, long volume, Lifespan lifespanType) {
-    if (!checkMessageLimit()) {
+    unsigned long askId = mNextMessageId;
+    Volume clipped = mRiskEngine.ClipInsert(Side::SELL, volume);
+    if (clipped == 0 || mOrders.IsFull() || !SendInsertOrder(askId, Side::SELL, price, clipped, lifespanType)) {
         return false;
     }
-    
-    unsigned long askId = mNextMessageId++;
-    SendInsertOrder(askId, Side::SELL, price, volume, lifespanType);
-    mAsks[askId] = price;
+    mNextMessageId++;
+    mOrders.Insert(askId, Side::SELL, price, clipped, lifespanType);
+    mRiskEngine.OnInsert(Side::SELL, clipped);
     return true;
 }
 
-bool AutoTrader::sendHedgeOrder(unsigned long price, unsigned long volume, Side side) {
-    while (!checkMessageLimit()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+unsigned long AutoTrader::sendHedgeOrder(unsigned long price, unsigned long volume, Side side) {
+    Volume clipped = mRiskEngine.ClipHedge(side, volume);
+    if (clipped != volume) {
+        RLOG(LG_AT, LogLevel::LL_WARNING) << "hedge of " << volume << " lots clipped to " << clipped
+                                          << " by the future position limit";
+    }
+    if (clipped == 0) {
+        return 0;
     }
 
     unsigned long order_id = mNextMessageId++;
     if (side == Side::BUY) {
-        hedgeBid.insert(order_id);
+        hedgeBid.emplace(order_id, clipped);
     } else {
-        hedgeAsk.insert(order_id);
+        hedgeAsk.emplace(order_id, clipped);
     }
 
-    SendHedgeOrder(order_id, side, price, volume); // call super SendHedgeOrder function
-    return true;
+    // queued ahead of everything else until the message limit allows it
+    ScheduleHedgeOrder(order_id, side, price, clipped);
+    mRiskEngine.OnHedge(side, clipped);
+    return order_id;
 }
 
 bool AutoTrader::sendCancelOrder(unsigned long orderId){
-    if (!checkMessageLimit()) {
+    auto* order = mOrders.Find(orderId);
+    if (order == nullptr || order->mState == OrderState::CANCELLING) {
         return false;
     }
-
-    SendCancelOrder(orderId); // call super SendCancelOrder function
+    if (!SendCancelOrder(orderId)) { // call super SendCancelOrder function
+        return false;
+    }
+    order->mState = OrderState::CANCELLING;
     return true;
 }
 
 void AutoTrader::trimOrder(){
-    for (auto const& [bid_id, bid] : mBids){
-        if (bid > futureAsk){
-            sendCancelOrder(bid_id);
-        }
-    }
-
-    for (auto const& [ask_id, ask] : mAsks){
-        if (ask < futureBid){
-            sendCancelOrder(ask_id);
+    for (auto const& order : mOrders){
+        if ((order.mSide == Side::BUY && order.mPrice > futureAsk)
+            || (order.mSide == Side::SELL && order.mPrice < futureBid)){
+            sendCancelOrder(order.mClientOrderId);
         }
     }
 }
 
-void AutoTrader::handleArbitrage(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes){
+void AutoTrader::handleArbitrage(const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes){
     if (askPrices[0] < futureBid){
         // arbitrage, buy etf and sell future
-        long buy_volume = std::min((long)askVolumes[0], (long)ARBITRAGE_LIMIT - mPosition);
+        long buy_volume = std::min((long)askVolumes[0], mParameters.mArbitrageLimit - mRiskEngine.GetEtfPosition());
         unsigned long buy_price = askPrices[0];
         if (buy_volume > 0){
             sendBidOrder(buy_price, buy_volume, Lifespan::FILL_AND_KILL);
         }
     }else if (bidPrices[0] > futureAsk){
         // arbitrage, buy future and sell etf
-        long sell_volume = std::min((long)bidVolumes[0], (long)ARBITRAGE_LIMIT + mPosition);
+        long sell_volume = std::min((long)bidVolumes[0], mParameters.mArbitrageLimit + mRiskEngine.GetEtfPosition());
         unsigned long sell_price = bidPrices[0];
         if (sell_volume > 0){
             sendAskOrder(sell_price, sell_volume, Lifespan::FILL_AND_KILL);
@@ -147,128 +162,114 @@ void AutoTrader::handleArbitrage(const std::array<unsigned long, TOP_LEVEL_COUNT
     }
 }
 
-void AutoTrader::clearBook(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                            const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                            const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                            const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes){
-    unsigned long cutoff_ask = askPrices.back();
-    unsigned long cutoff_bid = bidPrices.back();
-    unsigned long bid_vol = 0;
-    unsigned long ask_vol = 0;
-
-    for (int i = 0; i < askVolumes.size(); i++) {
-        ask_vol += askVolumes[i];
-        if (ask_vol >= 3 * LOT_SIZE) {
-            cutoff_ask = askPrices[i];
-            break;
-        }
-    }
-
-    for (int i = 0; i < bidVolumes.size(); i++) {
-        bid_vol += bidVolumes[i];
-        if (bid_vol >= 3 * LOT_SIZE) {
-            cutoff_bid = bidPrices[i];
-            break;
-        }
-    }
-
-    for (auto it = mBids.begin(); it != mBids.end(); it++) {
-        if (it->second <= cutoff_bid) {
-            sendCancelOrder(it->first);
-        }
+unsigned long AutoTrader::depthCutoff(Side side,
+                                      const std::array<Price, TOP_LEVEL_COUNT>& prices,
+                                      const std::array<Volume, TOP_LEVEL_COUNT>& volumes) const {
+    if (mParameters.mDepthCutoff == 0) {
+        return 0;
     }
-
-    for (auto it = mAsks.begin(); it != mAsks.end(); it++) {
-        if (it->second >= cutoff_ask) {
-            sendCancelOrder(it->first);
+    // our own orders don't count, or a quote could cut itself off
+    long depth = 0;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT && prices[i] != 0; i++) {
+        depth += (long)volumes[i] - (long)mOrders.GetVolumeAt(side, prices[i]);
+        if (depth >= mParameters.mDepthCutoff * mParameters.mLotSize) {
+            return prices[i];
         }
     }
+    return 0;
 }
 
-void AutoTrader::handleMarketMaking(const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes){
-    clearBook(askPrices, bidPrices, askVolumes, bidVolumes);
-    int max_buy_order = (int)(((long)POSITION_LIMIT - mPosition) / LOT_SIZE) - mBids.size();
-    int max_sell_order = (int)((mPosition + (long)POSITION_LIMIT) / LOT_SIZE) - mAsks.size();
-
-    unsigned long max_bid = futureBid - 2 * TICK_SIZE_IN_CENTS;
-    unsigned long min_ask = futureAsk + 2 * TICK_SIZE_IN_CENTS;
+void AutoTrader::handleMarketMaking(const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes){
+    // the ladder replaces the live orders, so only the position counts here;
+    // the risk engine clips whatever in-flight volume doesn't fit
+    long max_buy_order = mRiskEngine.GetPositionRoom(Side::BUY) / mParameters.mLotSize;
+    long max_sell_order = mRiskEngine.GetPositionRoom(Side::SELL) / mParameters.mLotSize;
+
+    unsigned long max_bid = futureBid - mParameters.mQuoteOffset * TICK_SIZE_IN_CENTS;
+    unsigned long min_ask = futureAsk + mParameters.mQuoteOffset * TICK_SIZE_IN_CENTS;
     unsigned long etf_bid = bidPrices[0];
     unsigned long etf_ask = askPrices[0];
 
-    for (unsigned long i = min_ask; i < etf_ask; i += TICK_SIZE_IN_CENTS) {
-        bool found = false;
-        for (const auto& pair : mAsks) {
-            if (pair.second == i) {
-                found = true;
-                break;
-            }
-        }
-        
-        if (!found && max_sell_order > 0) {
-            sendAskOrder(i, LOT_SIZE, Lifespan::GOOD_FOR_DAY);
-            max_sell_order -= 1;
-        }
+    // keep behind the depth cutoff: asks below it, bids above it
+    if (unsigned long cutoff = depthCutoff(Side::SELL, askPrices, askVolumes); cutoff != 0) {
+        etf_ask = std::min(etf_ask, cutoff);
+    }
+    if (unsigned long cutoff = depthCutoff(Side::BUY, bidPrices, bidVolumes); cutoff != 0) {
+        etf_bid = std::max(etf_bid, cutoff + TICK_SIZE_IN_CENTS);
     }
 
-    for (unsigned long i = etf_bid; i < max_bid; i += TICK_SIZE_IN_CENTS) {
-        bool found = false;
-        for (const auto& pair : mBids) {
-            if (pair.second == i) {
-                found = true;
-                break;
-            }
-        }
+    // the ladder cancels, trims or tops up the live orders to match these
+    mAskQuotes.clear();
+    for (unsigned long i = min_ask; i < etf_ask && (long)mAskQuotes.size() < max_sell_order; i += TICK_SIZE_IN_CENTS) {
+        mAskQuotes.push_back({i, mParameters.mLotSize});
+    }
 
-        if (!found && max_buy_order > 0) {
-            sendBidOrder(i, LOT_SIZE, Lifespan::GOOD_FOR_DAY);
-            max_buy_order -= 1;
-        }
+    mBidQuotes.clear();
+    for (unsigned long i = etf_bid; i < max_bid && (long)mBidQuotes.size() < max_buy_order; i += TICK_SIZE_IN_CENTS) {
+        mBidQuotes.push_back({i, mParameters.mLotSize});
     }
+
+    mLadder.Diff(Side::SELL, mAskQuotes);
+    mLadder.Diff(Side::BUY, mBidQuotes);
+    mLadder.Apply(*this, mNextMessageId);
 }
 
 void AutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId,
-                                           unsigned long price,
-                                           unsigned long volume)
+                                           Price price,
+                                           Volume volume)
 {
     RLOG(LG_AT, LogLevel::LL_INFO) << "hedge order " << clientOrderId << " filled for " << volume
                                    << " lots at $" << price << " average price in cents";
     
-    if (hedgeBid.count(clientOrderId)){
-        hedgeBid.erase(clientOrderId);
-        delta += volume;
-    }else if (hedgeAsk.count(clientOrderId)){
-        hedgeAsk.erase(clientOrderId);
-        delta -= volume;
+    if (auto it = hedgeBid.find(clientOrderId); it != hedgeBid.end()){
+        mRiskEngine.OnHedgeFilled(Side::BUY, it->second, volume);
+        mUnhedgedLots.Update(mRiskEngine.GetUnhedgedLots());
+        hedgeBid.erase(it);
+    }else if (auto it = hedgeAsk.find(clientOrderId); it != hedgeAsk.end()){
+        mRiskEngine.OnHedgeFilled(Side::SELL, it->second, volume);
+        mUnhedgedLots.Update(mRiskEngine.GetUnhedgedLots());
+        hedgeAsk.erase(it);
+    }
+    mHedger.HedgeFilled(clientOrderId, price, volume);
+
+    // a hedge that fell short can't wait for the next warning
+    if (mUnhedgedLots.IsExpiring()) {
+        mHedger.Flush();
     }
 }
 
 void AutoTrader::OrderBookMessageHandler(Instrument instrument,
                                          unsigned long sequenceNumber,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+                                         const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                         const std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                         const std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                         const std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
 {
     // RLOG(LG_AT, LogLevel::LL_INFO) << "order book received for " << instrument << " instrument"
     //                                << ": ask prices: " << askPrices[0]
     //                                << "; ask volumes: " << askVolumes[0]
     //                                << "; bid prices: " << bidPrices[0]
     //                                << "; bid volumes: " << bidVolumes[0];
-    // discard old seq data
-    msgSeq = std::max(msgSeq, sequenceNumber);
-    if (sequenceNumber != msgSeq) {
-        return;
-    }
-
     // error data, return directly
     if (bidPrices[0] == 0 || askPrices[0] == 0) {
         return;
     }
 
-    if (instrument == Instrument::ETF){
+    mBooks[static_cast<int>(instrument)].ApplyOrderBook(sequenceNumber, askPrices, askVolumes, bidPrices, bidVolumes);
+
+    // cancels and inserts triggered by this update go out in one write
+    BeginBatch();
+    if (instrument == Instrument::ETF && IsStale(Instrument::FUTURE)){
+        // don't trade off an out of date future price, pull the quotes instead
+        mAskQuotes.clear();
+        mBidQuotes.clear();
+        mLadder.Diff(Side::SELL, mAskQuotes);
+        mLadder.Diff(Side::BUY, mBidQuotes);
+        mLadder.Apply(*this, mNextMessageId);
+    }else if (instrument == Instrument::ETF){
         if (askPrices[0] < futureBid || bidPrices[0] > futureAsk){
             handleArbitrage(askPrices, askVolumes, bidPrices, bidVolumes);
         }else if (askPrices[0] > futureAsk && bidPrices[0] < futureBid){
@@ -278,65 +279,94 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
     }
     
     if (instrument == Instrument::FUTURE){
-        futureBid = bidPrices[0];
-        futureAsk = askPrices[0];
+        futureBid = mBooks[static_cast<int>(Instrument::FUTURE)].GetBestBid();
+        futureAsk = mBooks[static_cast<int>(Instrument::FUTURE)].GetBestAsk();
         trimOrder();
     }
+    CommitBatch();
 }
 
 void AutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId,
-                                           unsigned long price,
-                                           unsigned long volume)
+                                           Price price,
+                                           Volume volume)
 {
+    // a quote's estimated place in the queue should be at the front by now
     RLOG(LG_AT, LogLevel::LL_INFO) << "order " << clientOrderId << " filled for " << volume
-                                   << " lots at $" << price << " cents";
+                                   << " lots at $" << price << " cents, with an estimated "
+                                   << mBooks[static_cast<int>(Instrument::ETF)].GetVolumeAhead(clientOrderId)
+                                   << " lots ahead of it";
     
-    if (mBids.count(clientOrderId))
+    auto const* order = mOrders.Find(clientOrderId);
+    if (order == nullptr)
     {
-        mPosition += (long)volume;
-        delta += (long)volume;
-        // SendHedgeOrder(mNextMessageId++, Side::SELL, MIN_BID_NEARST_TICK, volume);
-        sendHedgeOrder(MIN_BID_NEARST_TICK, volume, Side::SELL);
-    }else if (mAsks.count(clientOrderId))
-    {
-        mPosition -= (long)volume;
-        delta -= (long)volume;
-        // SendHedgeOrder(mNextMessageId++, Side::BUY, MAX_ASK_NEAREST_TICK, volume);
-        sendHedgeOrder(MAX_ASK_NEAREST_TICK, volume, Side::BUY);
+        return;
+    }
+
+    // fills on opposite sides net off, so hedging waits for the unhedged
+    // lots timer rather than following every fill
+    mRiskEngine.OnOrderFilled(order->mSide, volume);
+    mUnhedgedLots.Update(mRiskEngine.GetUnhedgedLots());
+    mHedger.AddFill(order->mSide, volume, (futureBid + futureAsk) / 2);
+    if (mUnhedgedLots.IsExpiring()) {
+        mHedger.Flush();
     }
 }
 
 void AutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
-                                           unsigned long fillVolume,
-                                           unsigned long remainingVolume,
+                                           Volume fillVolume,
+                                           Volume remainingVolume,
                                            signed long fees)
 {
-    if (remainingVolume == 0)
+    auto const* order = mOrders.Find(clientOrderId);
+    if (order == nullptr)
     {
-        // if (clientOrderId == mAskId)
-        // {
-        //     mAskId = 0;
-        // }
-        // else if (clientOrderId == mBidId)
-        // {
-        //     mBidId = 0;
-        // }
-
-        mAsks.erase(clientOrderId);
-        mBids.erase(clientOrderId);
+        return;
     }
+
+    Side side = order->mSide;
+    Volume confirmedVolume = order->mConfirmedVolume;
+    // removes the order once nothing remains
+    mOrders.ApplyStatus(clientOrderId, fillVolume, remainingVolume);
+    mBooks[static_cast<int>(Instrument::ETF)].SetOrderRemaining(clientOrderId, remainingVolume);
+    mRiskEngine.OnOrderStatus(side, confirmedVolume, remainingVolume);
+}
+
+void AutoTrader::SetActiveOrderCountLimit(std::size_t limit)
+{
+    BaseAutoTrader::SetActiveOrderCountLimit(limit);
+    mOrders = OrderTable(limit);
+}
+
+void AutoTrader::SetParameters(const StrategyParameters& parameters)
+{
+    if (parameters.mLotSize <= 0 || parameters.mArbitrageLimit < 0 || parameters.mDepthCutoff < 0)
+    {
+        throw ReadyTraderGoError("lot size must be positive, and arbitrage limit and depth cutoff must not be "
+                                 "negative");
+    }
+    if (parameters.mUnhedgedLotsWarning < 0.0
+        || parameters.mUnhedgedLotsWarning >= std::chrono::duration<double>(UNHEDGED_LOTS_TIME_LIMIT).count())
+    {
+        throw ReadyTraderGoError("unhedged lots warning must be from zero to less than the time limit");
+    }
+    mParameters = parameters;
+    mUnhedgedLots.SetWarning(std::chrono::duration_cast<UnhedgedLots::Clock::duration>(
+        std::chrono::duration<double>(mParameters.mUnhedgedLotsWarning)));
+}
+
+void AutoTrader::SetStrategy(const boost::property_tree::ptree& strategy)
+{
+    StrategyParameters parameters;
+    parameters.readFromPropertyTree(strategy);
+    SetParameters(parameters);
 }
 
-void AutoTrader::TradeTicksMessageHandler(Instrument instrument,
-                                          unsigned long sequenceNumber,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+void AutoTrader::TradeTicksMessageHandler(const TradeTicksView& ticks)
 {
-    RLOG(LG_AT, LogLevel::LL_INFO) << "trade ticks received for " << instrument << " instrument"
-                                   << ": ask prices: " << askPrices[0]
-                                   << "; ask volumes: " << askVolumes[0]
-                                   << "; bid prices: " << bidPrices[0]
-                                   << "; bid volumes: " << bidVolumes[0];
+    RLOG(LG_AT, LogLevel::LL_INFO) << "trade ticks received for " << ticks.GetInstrument() << " instrument"
+                                   << ": ask prices: " << ticks.GetAskPrice(0)
+                                   << "; ask volumes: " << ticks.GetAskVolume(0)
+                                   << "; bid prices: " << ticks.GetBidPrice(0)
+                                   << "; bid volumes: " << ticks.GetBidVolume(0);
+    mBooks[static_cast<int>(ticks.GetInstrument())].ApplyTradeTicks(ticks);
 }
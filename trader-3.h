@@ -21,22 +21,48 @@
 #include <array>
 #include <memory>
 #include <string>
-#include <unordered_set>
-#include <deque>
 #include <unordered_map>
-#include <chrono>
-#include <thread>
+#include <vector>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/property_tree/ptree.hpp>
 
 #include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/hedgeaggregator.h>
+#include <ready_trader_go/localbook.h>
+#include <ready_trader_go/ordertable.h>
+#include <ready_trader_go/quoteladder.h>
 #include <ready_trader_go/types.h>
+#include <ready_trader_go/unhedgedlots.h>
+
+// The strategy's tunable parameters, read from the Strategy section of the
+// configuration. Any parameter not given keeps its default.
+struct StrategyParameters
+{
+    void readFromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        mLotSize = tree.get<long>("LotSize", mLotSize);
+        mArbitrageLimit = tree.get<long>("ArbitrageLimit", mArbitrageLimit);
+        mQuoteOffset = tree.get<unsigned long>("QuoteOffset", mQuoteOffset);
+        mUnhedgedLotsWarning = tree.get<double>("UnhedgedLotsWarning", mUnhedgedLotsWarning);
+        mDepthCutoff = tree.get<long>("DepthCutoff", mDepthCutoff);
+    }
+
+    long mLotSize = 20;                // volume of each quote
+    long mArbitrageLimit = 20;         // ETF position beyond which arbitrage isn't taken
+    unsigned long mQuoteOffset = 2;    // ticks from the future's best prices to the nearest quotes
+    double mUnhedgedLotsWarning = 5.0; // seconds before the unhedged lots deadline to hedge
+    long mDepthCutoff = 3;             // lots of other ETF orders behind which nothing is quoted (0 for none)
+};
 
 class AutoTrader : public ReadyTraderGo::BaseAutoTrader
 {
 public:
     explicit AutoTrader(boost::asio::io_context& context);
 
+    const StrategyParameters& GetParameters() const noexcept { return mParameters; }
+    void SetParameters(const StrategyParameters& parameters);
+
     // Called when the execution connection is lost.
     void DisconnectHandler() override;
 
@@ -54,8 +80,8 @@ public:
     //
     // If the order was unsuccessful, both the price and volume will be zero.
     void HedgeFilledMessageHandler(unsigned long clientOrderId,
-                                   unsigned long price,
-                                   unsigned long volume) override;
+                                   ReadyTraderGo::Price price,
+                                   ReadyTraderGo::Volume volume) override;
 
     // Called periodically to report the status of an order book.
     // The sequence number can be used to detect missed or out-of-order
@@ -64,15 +90,15 @@ public:
     // price levels.
     void OrderBookMessageHandler(ReadyTraderGo::Instrument instrument,
                                  unsigned long sequenceNumber,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes) override;
+                                 const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
+                                 const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
+                                 const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
+                                 const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes) override;
 
     // Called when one of your orders is filled, partially or fully.
     void OrderFilledMessageHandler(unsigned long clientOrderId,
-                                   unsigned long price,
-                                   unsigned long volume) override;
+                                   ReadyTraderGo::Price price,
+                                   ReadyTraderGo::Volume volume) override;
 
     // Called when the status of one of your orders changes.
     // The fill volume is the number of lots already traded, remaining volume
@@ -80,8 +106,8 @@ public:
     // or received for this order.
     // Remaining volume will be set to zero if the order is cancelled.
     void OrderStatusMessageHandler(unsigned long clientOrderId,
-                                   unsigned long fillVolume,
-                                   unsigned long remainingVolume,
+                                   ReadyTraderGo::Volume fillVolume,
+                                   ReadyTraderGo::Volume remainingVolume,
                                    signed long fees) override;
 
     // Called periodically when there is trading activity on the market.
@@ -90,30 +116,34 @@ public:
     // traded at each of those price levels.
     // If there are less than five prices on a side, then zeros will appear at
     // the end of both the prices and volumes arrays.
-    void TradeTicksMessageHandler(ReadyTraderGo::Instrument instrument,
-                                  unsigned long sequenceNumber,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes) override;
+    // Only the best level is used, so the view is read directly rather than
+    // having every level deserialised.
+    void TradeTicksMessageHandler(const ReadyTraderGo::TradeTicksView& ticks) override;
 
-    // Check if current message doesn't breach 50 messages limit
-    // Return true if can send, false if can't due to limit
-    bool checkMessageLimit();
+    // Resize the order table to the exchange's active order count limit
+    void SetActiveOrderCountLimit(std::size_t limit) override;
+
+    // Read the strategy parameters from the configuration
+    void SetStrategy(const boost::property_tree::ptree& strategy) override;
 
     // Wrapper to send bid orders
+    // The volume is clipped by the risk engine
+    // Return false if throttled by the message frequency limit, or if the
+    // risk engine rejects the order
     bool sendBidOrder(unsigned long price, long volume, ReadyTraderGo::Lifespan lifespanType);
 
     // Wrapper to send ask orders
     bool sendAskOrder(unsigned long price, long volume, ReadyTraderGo::Lifespan lifespanType);
 
     // Wrapper to send hedge orders
-    // Hedge cannot be ignored, must be sent
-    // This might be thread-unsafe, but everything here is thread-unsafe
-    bool sendHedgeOrder(unsigned long price, unsigned long volume, ReadyTraderGo::Side side);
+    // Hedge cannot be ignored, must be sent, so it is scheduled rather than
+    // dropped when throttled
+    // Return the order id, or zero only if it would breach the future
+    // position limit
+    unsigned long sendHedgeOrder(unsigned long price, unsigned long volume, ReadyTraderGo::Side side);
 
     // Wrapper to send cancel orders
-    // Return False if throttled
+    // Return False if throttled or already cancelling
     bool sendCancelOrder(unsigned long orderId);
 
     // Cancel all orders that can be arbitraged
@@ -123,42 +153,50 @@ public:
     // arbitrage if bid is higher than ask between ETF/future
     // Arbitrage can helps to reduce position as well, but can also limit market making
     // Maybe show more preference towards arbitrage that reduce position rather than increase
-    void handleArbitrage(const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes);
-    
-    // Cancel all bid and ask that has low chance of being filled
-    void clearBook(const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                    const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                    const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                    const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes);
+    void handleArbitrage(const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
+                        const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
+                        const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
+                        const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes);
     
+    // The ETF price level at which the other orders on one side of the book
+    // add up to the depth cutoff, or zero if they don't
+    // A quote there or further from the best price would wait too long
+    unsigned long depthCutoff(ReadyTraderGo::Side side,
+                              const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& prices,
+                              const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& volumes) const;
+
     // Setup bid and ask order based on price of future
     // bid: [future_bid - 3, future_bid - 2,... future_bid - 1]
     // ask: [future_ask + 1, future_ask +2,...  future_ask + 3]
-    void handleMarketMaking(const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                            const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                            const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                            const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes);
+    // Quotes beyond the depth cutoff are left out, and orders outside the
+    // range are cancelled by the quote ladder
+    void handleMarketMaking(const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
+                            const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
+                            const std::array<ReadyTraderGo::Price, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
+                            const std::array<ReadyTraderGo::Volume, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes);
 
 private:
+    StrategyParameters mParameters;
     unsigned long mNextMessageId = 1;
     // unsigned long mAskId = 0;
     // unsigned long mAskPrice = 0;
     // unsigned long mBidId = 0;
     // unsigned long mBidPrice = 0;
-    signed long mPosition = 0;
-    std::unordered_map<unsigned long, unsigned long> mAsks; // {id: rice}
-    std::unordered_map<unsigned long, unsigned long> mBids; // {id: rice}
+    ReadyTraderGo::OrderTable mOrders;
+    std::array<ReadyTraderGo::LocalBook, 2> mBooks; // indexed by instrument
+    // the ETF book keeps track of the quotes' places in the queue
+    ReadyTraderGo::QuoteLadder mLadder{mOrders, &mRiskEngine, &mBooks[static_cast<int>(ReadyTraderGo::Instrument::ETF)]};
+    std::vector<ReadyTraderGo::Quote> mAskQuotes;
+    std::vector<ReadyTraderGo::Quote> mBidQuotes;
 
     unsigned long futureBid = 0;
     unsigned long futureAsk = 0;
-    long delta = 0;
-    unsigned long msgSeq = 0;
-    std::deque<double> orderTimestamps;
-    std::unordered_set<unsigned long> hedgeBid; // store message ID
-    std::unordered_set<unsigned long> hedgeAsk; // store message ID
+    // Fills are left unhedged while they can net off against each other,
+    // until the unhedged lots timer is about to expire
+    ReadyTraderGo::UnhedgedLots mUnhedgedLots;
+    ReadyTraderGo::HedgeAggregator mHedger;
+    std::unordered_map<unsigned long, unsigned long> hedgeBid; // message ID to volume
+    std::unordered_map<unsigned long, unsigned long> hedgeAsk; // message ID to volume
 };
 
 #endif //CPPREADY_TRADER_GO_AUTOTRADER_H
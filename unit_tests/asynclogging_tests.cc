@@ -0,0 +1,185 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE asynclogging_tests
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/asynclogging.h"
+
+using namespace ReadyTraderGo;
+
+// Keeps what the logging thread writes, and can hold the thread up in the
+// middle of a write until it is opened
+class GatedBuffer : public std::streambuf
+{
+public:
+    // The lines written so far, without their times
+    std::vector<std::string> GetLines() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<std::string> lines;
+        std::istringstream text(mText);
+        for (std::string line; std::getline(text, line);)
+        {
+            lines.push_back(line.substr(line.find('[')));
+        }
+        return lines;
+    }
+
+    void Close() { mIsOpen = false; }
+    void Open() { mIsOpen = true; }
+    bool IsWaiting() const { return mIsWaiting; }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        const char ch = traits_type::to_char_type(c);
+        xsputn(&ch, 1);
+        return c;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override
+    {
+        while (!mIsOpen)
+        {
+            mIsWaiting = true;
+            std::this_thread::yield();
+        }
+        mIsWaiting = false;
+        std::lock_guard<std::mutex> lock(mMutex);
+        mText.append(data, size);
+        return size;
+    }
+
+private:
+    std::atomic<bool> mIsOpen{true};
+    std::atomic<bool> mIsWaiting{false};
+    mutable std::mutex mMutex;
+    std::string mText;
+};
+
+// What RLOG does with asynchronous logging on
+static void logNumber(LogLevel level, int number)
+{
+    for (AsyncLogRecord record{level, "TEST"}; record; record.Publish())
+    {
+        record << "record " << number;
+    }
+}
+
+static std::string expectedLine(int number)
+{
+    return "[INFO   ] [TEST] record " + std::to_string(number);
+}
+
+BOOST_AUTO_TEST_CASE(a_full_queue_refuses_records_until_one_is_taken)
+{
+    auto queue = std::make_unique<AsyncLogQueue>();
+    BOOST_TEST(queue->Front() == nullptr);
+    for (std::size_t i = 0; i < ASYNC_LOG_QUEUE_SIZE; ++i)
+    {
+        unsigned char* record = queue->Reserve();
+        BOOST_REQUIRE(record != nullptr);
+        std::memcpy(record, &i, sizeof(i));
+        queue->Publish();
+    }
+    BOOST_TEST(queue->Reserve() == nullptr);
+
+    std::size_t first;
+    std::memcpy(&first, queue->Front(), sizeof(first));
+    BOOST_TEST(first == 0u);
+    queue->Pop();
+    BOOST_TEST(queue->Reserve() != nullptr);
+    queue->Publish();
+    BOOST_TEST(queue->Reserve() == nullptr);
+
+    // The records come out in the order they went in, wrapping around
+    for (std::size_t i = 1; i <= ASYNC_LOG_QUEUE_SIZE; ++i)
+    {
+        std::size_t value;
+        std::memcpy(&value, queue->Front(), sizeof(value));
+        BOOST_REQUIRE(value == i % ASYNC_LOG_QUEUE_SIZE);
+        queue->Pop();
+    }
+    BOOST_TEST(queue->Front() == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(stopping_writes_everything_still_queued)
+{
+    GatedBuffer buffer;
+    AsyncLogBackend::Start(std::make_unique<std::ostream>(&buffer), LogLevel::LL_INFO);
+    constexpr int COUNT = 500;
+    for (int i = 0; i < COUNT; ++i)
+    {
+        logNumber(LogLevel::LL_INFO, i);
+        logNumber(LogLevel::LL_DEBUG, -i);
+    }
+    AsyncLogBackend::Stop();
+
+    // Nothing is recorded once stopped
+    logNumber(LogLevel::LL_FATAL, COUNT);
+
+    const std::vector<std::string> lines = buffer.GetLines();
+    BOOST_REQUIRE(lines.size() == static_cast<std::size_t>(COUNT));
+    for (int i = 0; i < COUNT; ++i)
+    {
+        BOOST_REQUIRE(lines[i] == expectedLine(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(records_logged_while_the_queue_is_full_are_dropped_and_counted)
+{
+    GatedBuffer buffer;
+    AsyncLogBackend::Start(std::make_unique<std::ostream>(&buffer), LogLevel::LL_INFO);
+
+    // Hold the logging thread up while it writes the first record, which
+    // stays at the front of the queue until it has been written
+    buffer.Close();
+    logNumber(LogLevel::LL_INFO, 0);
+    while (!buffer.IsWaiting())
+    {
+        std::this_thread::yield();
+    }
+    constexpr int COUNT = 2000;
+    for (int i = 1; i < COUNT; ++i)
+    {
+        logNumber(LogLevel::LL_INFO, i);
+    }
+    buffer.Open();
+    AsyncLogBackend::Stop();
+
+    const std::vector<std::string> lines = buffer.GetLines();
+    BOOST_REQUIRE(lines.size() == ASYNC_LOG_QUEUE_SIZE + 1);
+    for (std::size_t i = 0; i < ASYNC_LOG_QUEUE_SIZE; ++i)
+    {
+        BOOST_REQUIRE(lines[i] == expectedLine(static_cast<int>(i)));
+    }
+    BOOST_TEST(lines.back() == "[WARNING] [LOG] " + std::to_string(COUNT - ASYNC_LOG_QUEUE_SIZE)
+                               + " log records dropped because a queue was full");
+}
@@ -0,0 +1,248 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE backtest_tests
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "backtest/backtest.h"
+#include "backtest/marketeventfile.h"
+#include "backtest/marketevents.h"
+#include "ready_trader_go/baseautotrader.h"
+#include "ready_trader_go/traderclock.h"
+
+using namespace ReadyTraderGo;
+
+// Asks for more inserts than the message frequency limit allows on every
+// ETF order book, and leaves the schedule timer to send them
+class BusyTrader : public BaseAutoTrader
+{
+public:
+    explicit BusyTrader(boost::asio::io_context& context) : BaseAutoTrader(context) {}
+
+    using BaseAutoTrader::OrderBookMessageHandler;
+
+    void OrderBookMessageHandler(Instrument instrument,
+                                 unsigned long,
+                                 const std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                 const std::array<Volume, TOP_LEVEL_COUNT>&,
+                                 const std::array<Price, TOP_LEVEL_COUNT>&,
+                                 const std::array<Volume, TOP_LEVEL_COUNT>&) override
+    {
+        if (instrument == Instrument::ETF)
+        {
+            if (mFirstAskPrice == 0)
+            {
+                mFirstAskPrice = askPrices[0];
+            }
+            for (int i = 0; i < 20; ++i)
+            {
+                ScheduleInsertOrder(mNextMessageId++, Side::BUY, 100, 1, Lifespan::FILL_AND_KILL);
+            }
+        }
+    }
+
+    // The best ask in the first ETF order book update, if it had one
+    Price mFirstAskPrice = 0;
+
+private:
+    unsigned long mNextMessageId = 1;
+};
+
+static MarketEvents makeEvents()
+{
+    std::vector<MarketEvent> events;
+    for (double time : {0.5, 20.0, 60.0})
+    {
+        const auto orderId = static_cast<std::uint32_t>(events.size() + 1);
+        events.push_back({time, orderId, 10, 10000, Instrument::FUTURE, MarketEventOperation::INSERT, Side::SELL,
+                          Lifespan::GOOD_FOR_DAY});
+        events.push_back({time, orderId + 1000, 10, 10000, Instrument::ETF, MarketEventOperation::INSERT, Side::SELL,
+                          Lifespan::GOOD_FOR_DAY});
+    }
+    return MarketEvents(std::move(events));
+}
+
+static BacktestResult runBacktest(const BacktestConfig& config = BacktestConfig{}, Price* firstAskPrice = nullptr)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    BusyTrader trader{context};
+    Backtest backtest{context, config, makeEvents()};
+    backtest.Start(trader);
+    clock.Run(context);
+    BOOST_TEST(backtest.IsFinished());
+    if (firstAskPrice)
+    {
+        *firstAskPrice = trader.mFirstAskPrice;
+    }
+    return backtest.GetResult();
+}
+
+struct QuietLogging
+{
+    QuietLogging() { boost::log::core::get()->set_logging_enabled(false); }
+};
+
+BOOST_GLOBAL_FIXTURE(QuietLogging);
+
+BOOST_AUTO_TEST_CASE(a_backtest_needs_a_simulated_clock)
+{
+    boost::asio::io_context context;
+    BOOST_CHECK_THROW((Backtest{context, BacktestConfig{}, makeEvents()}), ReadyTraderGoError);
+}
+
+BOOST_AUTO_TEST_CASE(a_backtest_runs_in_simulated_time)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const BacktestResult result = runBacktest();
+    BOOST_TEST(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < 10.0);
+
+    // The last events are taken on the market event tick after them, and the
+    // match ends on the order book tick after that
+    BOOST_TEST(result.mStatus == "OK");
+    BOOST_TEST(result.mEndTime == 60.25);
+
+    // The schedule timer sends as many inserts as the limit allows, to the
+    // end, without breaching it
+    BOOST_TEST(result.mMessageCount <= 50u * 61u);
+    BOOST_TEST(result.mMessageCount >= 50u * 60u);
+}
+
+BOOST_AUTO_TEST_CASE(a_backtest_gives_the_same_result_every_time)
+{
+    const BacktestResult first = runBacktest();
+    const BacktestResult second = runBacktest();
+    BOOST_TEST(first.mStatus == second.mStatus);
+    BOOST_TEST(first.mEndTime == second.mEndTime);
+    BOOST_TEST(first.mMessageCount == second.mMessageCount);
+    BOOST_TEST(first.mErrorCount == second.mErrorCount);
+    BOOST_TEST(first.mProfitOrLoss == second.mProfitOrLoss);
+}
+
+BOOST_AUTO_TEST_CASE(a_backtest_trades_between_its_start_and_end_times)
+{
+    BacktestConfig config;
+    config.mStartTime = 10.0;
+    config.mEndTime = 30.0;
+    Price firstAskPrice = 0;
+    const BacktestResult result = runBacktest(config, &firstAskPrice);
+
+    // The order from before the start time is already in the book, and the
+    // events after the end time are never taken
+    BOOST_TEST(firstAskPrice == 10000u);
+    BOOST_TEST(result.mStatus == "OK");
+    BOOST_TEST(result.mMarketEventCount == 2u);
+    BOOST_TEST(result.mEndTime == 20.25);
+    BOOST_TEST(result.mMessageCount <= 50u * 11u);
+    BOOST_TEST(result.mMessageCount >= 50u * 10u);
+}
+
+BOOST_AUTO_TEST_CASE(a_backtest_ends_after_it_starts)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    BacktestConfig config;
+    config.mStartTime = 30.0;
+    config.mEndTime = 10.0;
+    BOOST_CHECK_THROW((Backtest{context, config, makeEvents()}), ReadyTraderGoError);
+}
+
+// Writes the test events to a binary market data file, which is removed
+// again at the end of the test
+struct MarketEventFileFixture
+{
+    MarketEventFileFixture() { writeMarketEventFile(mFilename, makeEvents()); }
+    ~MarketEventFileFixture() { std::filesystem::remove(mFilename); }
+
+    // Overwrite an entry of the file's index
+    void SetIndexEntry(std::size_t entry, std::uint64_t position) const
+    {
+        std::fstream file{mFilename, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(static_cast<std::streamoff>(sizeof(MarketEventFileHeader) + entry * sizeof(position)));
+        file.write(reinterpret_cast<const char*>(&position), sizeof(position));
+    }
+
+    // Overwrite one byte of an event, at the given offset into its record,
+    // and return the byte it replaced
+    unsigned char SetEventByte(std::size_t event, std::size_t offset, unsigned char value) const
+    {
+        std::fstream file{mFilename, std::ios::binary | std::ios::in | std::ios::out};
+        MarketEventFileHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        const auto position = static_cast<std::streamoff>(sizeof(header) + header.mIndexCount * sizeof(std::uint64_t)
+                                                          + event * sizeof(MarketEvent) + offset);
+        unsigned char previous;
+        file.seekg(position);
+        file.read(reinterpret_cast<char*>(&previous), sizeof(previous));
+        file.seekp(position);
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        return previous;
+    }
+
+    const std::string mFilename = (std::filesystem::temp_directory_path() / "backtest_tests_events.bin").string();
+};
+
+BOOST_FIXTURE_TEST_CASE(seek_finds_the_first_event_at_or_after_a_time, MarketEventFileFixture)
+{
+    const MarketEvents events = mapMarketEventFile(mFilename);
+    BOOST_TEST(events.Seek(0.0) == 0u);
+    BOOST_TEST(events.Seek(0.5) == 0u);
+    BOOST_TEST(events.Seek(10.0) == 2u);
+    BOOST_TEST(events.Seek(20.0) == 2u);
+    BOOST_TEST(events.Seek(20.5) == 4u);
+    BOOST_TEST(events.Seek(100.0) == 6u);
+}
+
+BOOST_FIXTURE_TEST_CASE(a_market_event_file_index_must_match_its_events, MarketEventFileFixture)
+{
+    // Entry 30 is the first event at or after 30 seconds, which is event 4
+    SetIndexEntry(30, 2);
+    BOOST_CHECK_THROW(mapMarketEventFile(mFilename), ReadyTraderGoError);
+    SetIndexEntry(30, 5);
+    BOOST_CHECK_THROW(mapMarketEventFile(mFilename), ReadyTraderGoError);
+    SetIndexEntry(30, 4);
+    BOOST_CHECK_NO_THROW(mapMarketEventFile(mFilename));
+
+    // Nor may an entry go back before the one ahead of it
+    SetIndexEntry(25, 2);
+    BOOST_CHECK_THROW(mapMarketEventFile(mFilename), ReadyTraderGoError);
+}
+
+BOOST_FIXTURE_TEST_CASE(a_market_event_file_must_hold_valid_events, MarketEventFileFixture)
+{
+    for (std::size_t offset : {offsetof(MarketEvent, mInstrument), offsetof(MarketEvent, mOperation),
+                               offsetof(MarketEvent, mSide), offsetof(MarketEvent, mLifespan)})
+    {
+        const unsigned char valid = SetEventByte(3, offset, 3);
+        BOOST_CHECK_THROW(mapMarketEventFile(mFilename), ReadyTraderGoError);
+        SetEventByte(3, offset, 255);
+        BOOST_CHECK_THROW(mapMarketEventFile(mFilename), ReadyTraderGoError);
+        SetEventByte(3, offset, valid);
+        BOOST_CHECK_NO_THROW(mapMarketEventFile(mFilename));
+    }
+}
@@ -0,0 +1,215 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE baseautotrader_tests
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/baseautotrader.h"
+#include "ready_trader_go/traderclock.h"
+
+#include "mockconnection.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+// An auto-trader whose order status callbacks are kept as lines of text
+class TestTrader : public BaseAutoTrader
+{
+public:
+    using BaseAutoTrader::BaseAutoTrader;
+
+    std::vector<std::string> mStatuses;
+
+protected:
+    using BaseAutoTrader::OrderStatusMessageHandler;
+
+    void OrderStatusMessageHandler(unsigned long clientOrderId,
+                                   Volume fillVolume,
+                                   Volume remainingVolume,
+                                   signed long fees) override
+    {
+        std::ostringstream line;
+        line << clientOrderId << ' ' << fillVolume << ' ' << remainingVolume << ' ' << fees;
+        mStatuses.push_back(line.str());
+    }
+};
+
+// An auto-trader on a simulated clock, logged in over a mock connection with
+// a limit of two messages a second. The login takes up one of them.
+struct SchedulingFixture
+{
+    SchedulingFixture()
+    {
+        boost::log::core::get()->set_logging_enabled(false);
+
+        auto connection = std::make_unique<MockConnection>();
+        mConnection = connection.get();
+        mTrader.SetMessageFrequencyLimit(1s, 2);
+        mTrader.SetExecutionConnection(std::move(connection));
+    }
+
+    // Run the event loop until nothing is left to do, and return the
+    // messages sent since the login
+    std::vector<std::string> Run()
+    {
+        mClock.Run(mContext);
+        return {mConnection->mSent.begin() + 1, mConnection->mSent.end()};
+    }
+
+    SimulatedClock mClock;
+    boost::asio::io_context mContext;
+    TestTrader mTrader{mContext};
+    MockConnection* mConnection;
+};
+
+BOOST_FIXTURE_TEST_SUITE(scheduling, SchedulingFixture)
+
+BOOST_AUTO_TEST_CASE(queued_orders_are_sent_hedges_first_then_cancels_and_amends_then_inserts)
+{
+    mTrader.ScheduleInsertOrder(1, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(2, Side::SELL, 200, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(3, Side::SELL, 200, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleCancelOrder(1);
+    mTrader.ScheduleAmendOrder(1, 5);
+    mTrader.ScheduleHedgeOrder(4, Side::SELL, 100, 10);
+    BOOST_TEST(mTrader.GetScheduledOrderCount() == 5u);
+
+    const std::vector<std::string> expected{"0s insert 1 10",
+                                            "1s hedge 4 10",
+                                            "1s cancel 1",
+                                            "2s amend 1 5",
+                                            "2s insert 2 10",
+                                            "3s insert 3 10"};
+    BOOST_TEST(Run() == expected, boost::test_tools::per_element());
+    BOOST_TEST(mTrader.GetScheduledOrderCount() == 0u);
+    BOOST_TEST(mTrader.mStatuses.empty());
+}
+
+BOOST_AUTO_TEST_CASE(messages_released_together_are_committed_together)
+{
+    mTrader.ScheduleInsertOrder(1, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(2, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(3, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    BOOST_TEST(mConnection->mCommitCount == 2u);
+
+    Run();
+    BOOST_TEST(mConnection->mCommitCount == 3u);
+    BOOST_TEST(mConnection->mSent.size() == 4u);
+}
+
+BOOST_AUTO_TEST_CASE(only_the_outermost_batch_is_committed)
+{
+    mTrader.SetMessageFrequencyLimit(1s, 10);
+    const std::size_t loginCommits = mConnection->mCommitCount;
+
+    mTrader.BeginBatch();
+    mTrader.SendInsertOrder(1, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.BeginBatch();
+    mTrader.SendCancelOrder(1);
+    mTrader.CommitBatch();
+    BOOST_TEST(mConnection->mCommitCount == loginCommits);
+    mTrader.SendInsertOrder(2, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.CommitBatch();
+    BOOST_TEST(mConnection->mCommitCount == loginCommits + 1);
+
+    // Outside a batch, each message is committed as it is sent, and a
+    // CommitBatch without a BeginBatch does nothing
+    mTrader.SendCancelOrder(2);
+    mTrader.CommitBatch();
+    BOOST_TEST(mConnection->mCommitCount == loginCommits + 2);
+
+    const std::vector<std::string> expected{"0s insert 1 10", "0s cancel 1", "0s insert 2 10", "0s cancel 2"};
+    BOOST_TEST(Run() == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(sends_that_would_overtake_queued_orders_are_refused)
+{
+    // These start waiting before the auto-trader's own timer, so they run
+    // first when the limit next allows a message, while orders are still
+    // queued
+    TraderTimer cancelQueued{mContext}, insertQueued{mContext};
+    std::vector<bool> sent;
+    cancelQueued.expires_after(1s);
+    cancelQueued.async_wait([&](const boost::system::error_code&) {
+        sent.push_back(mTrader.SendInsertOrder(3, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY));
+        sent.push_back(mTrader.SendCancelOrder(4));
+        sent.push_back(mTrader.SendHedgeOrder(5, Side::SELL, 100, 10));
+    });
+    insertQueued.expires_after(2s);
+    insertQueued.async_wait([&](const boost::system::error_code&) {
+        sent.push_back(mTrader.SendInsertOrder(6, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY));
+        sent.push_back(mTrader.SendAmendOrder(1, 5));
+    });
+
+    BOOST_TEST(mTrader.SendInsertOrder(1, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY));
+    BOOST_TEST(!mTrader.SendInsertOrder(2, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY));
+    mTrader.ScheduleCancelOrder(1);
+    mTrader.ScheduleInsertOrder(2, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+
+    const std::vector<std::string> expected{"0s insert 1 10",
+                                            "1s hedge 5 10",
+                                            "1s cancel 1",
+                                            "2s amend 1 5",
+                                            "2s insert 2 10"};
+    BOOST_TEST(Run() == expected, boost::test_tools::per_element());
+    const std::vector<bool> expectedSent{false, false, true, false, true};
+    BOOST_TEST(sent == expectedSent, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(cancelling_or_amending_a_queued_insert_changes_it)
+{
+    mTrader.ScheduleInsertOrder(1, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(2, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(3, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    mTrader.ScheduleInsertOrder(4, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    BOOST_TEST(mTrader.GetScheduledOrderCount() == 3u);
+
+    // An amend can only reduce the volume; amending to nothing, or
+    // cancelling, drops the insert
+    mTrader.ScheduleAmendOrder(2, 4);
+    mTrader.ScheduleAmendOrder(2, 6);
+    mTrader.ScheduleAmendOrder(3, 0);
+    mTrader.ScheduleCancelOrder(4);
+    BOOST_TEST(mTrader.GetScheduledOrderCount() == 1u);
+
+    // The order already sent is cancelled as usual
+    mTrader.ScheduleCancelOrder(1);
+    BOOST_TEST(mTrader.GetScheduledOrderCount() == 2u);
+
+    // The dropped orders are reported later, not from inside the calls that
+    // dropped them
+    BOOST_TEST(mTrader.mStatuses.empty());
+
+    const std::vector<std::string> expected{"0s insert 1 10",
+                                            "1s cancel 1",
+                                            "1s insert 2 4"};
+    BOOST_TEST(Run() == expected, boost::test_tools::per_element());
+    const std::vector<std::string> expectedStatuses{"3 0 0 0", "4 0 0 0"};
+    BOOST_TEST(mTrader.mStatuses == expectedStatuses, boost::test_tools::per_element());
+    BOOST_TEST(mTrader.GetScheduledOrderCount() == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,385 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE connection_tests
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/log/core.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/connectivity.h"
+
+#include <sys/ioctl.h>
+
+using namespace ReadyTraderGo;
+using boost::asio::ip::tcp;
+
+// Every heap allocation is counted, so that tests can check that a path
+// allocates nothing. The whole set of replaceable allocation functions is
+// replaced, all of them through the two functions below, which are kept out
+// of line so that the compiler never sees a new paired with free().
+static std::size_t allocationCount = 0;
+
+[[gnu::noinline]] static void* allocate(std::size_t size, std::size_t alignment) noexcept
+{
+    ++allocationCount;
+    size = (size != 0) ? size : 1;
+    if (alignment <= alignof(std::max_align_t))
+    {
+        return std::malloc(size);
+    }
+    // aligned_alloc needs a size that is a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+[[gnu::noinline]] static void deallocate(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+static void* allocateOrThrow(std::size_t size, std::size_t alignment)
+{
+    if (void* memory = allocate(size, alignment))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size)
+{
+    return allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocateOrThrow(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept { deallocate(memory); }
+void operator delete[](void* memory) noexcept { deallocate(memory); }
+void operator delete(void* memory, std::size_t) noexcept { deallocate(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { deallocate(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { deallocate(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { deallocate(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { deallocate(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { deallocate(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { deallocate(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { deallocate(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(memory); }
+
+struct Message
+{
+    unsigned char mType;
+    std::vector<unsigned char> mPayload;
+
+    bool operator==(const Message& other) const
+    {
+        return mType == other.mType && mPayload == other.mPayload;
+    }
+};
+
+std::ostream& operator<<(std::ostream& stream, const Message& message)
+{
+    return stream << "{type=" << int(message.mType) << ", size=" << message.mPayload.size() << "}";
+}
+
+// A Connection on one end of a loopback socket while the test writes byte
+// streams, a chunk at a time, into the other end or reads from it. The socket
+// buffers are kept small so that the connection's writes soon have to wait.
+struct ConnectionFixture
+{
+    ConnectionFixture()
+    {
+        boost::log::core::get()->set_logging_enabled(false);
+
+        tcp::acceptor acceptor(mContext, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+        mPeer.open(tcp::v4());
+        mPeer.set_option(tcp::socket::receive_buffer_size(4096));
+        mPeer.connect(acceptor.local_endpoint());
+        mPeer.non_blocking(true);
+        tcp::socket socket(mContext);
+        acceptor.accept(socket);
+        socket.set_option(tcp::socket::send_buffer_size(4096));
+        mSocketHandle = socket.native_handle();
+
+        mConnection = std::make_unique<Connection>(mContext, std::move(socket));
+        mConnection->Disconnected = [this]() { mIsDisconnected = true; };
+        mConnection->MessageReceived = [this](auto*, unsigned char type, unsigned char const* data, std::size_t size) {
+            mReceived.push_back({type, std::vector<unsigned char>(data, data + size)});
+        };
+        mConnection->AsyncRead();
+    }
+
+    // Write the chunk to the peer socket and let the connection read all of
+    // it before returning, so that each chunk arrives on its own.
+    void Deliver(unsigned char const* chunk, std::size_t size)
+    {
+        std::size_t written = 0;
+        while (written < size && !mIsDisconnected)
+        {
+            boost::system::error_code error;
+            written += mPeer.write_some(boost::asio::buffer(chunk + written, size - written), error);
+            BOOST_REQUIRE(!error || error == boost::asio::error::would_block);
+            do
+            {
+                mContext.poll();
+            }
+            while (BytesAvailable() != 0 && !mIsDisconnected);
+        }
+    }
+
+    // Deliver the stream in chunks of random size, most of them small enough
+    // to split headers as well as payloads.
+    void DeliverInRandomChunks(const std::vector<unsigned char>& stream, std::mt19937& random,
+                               std::size_t maxChunkSize = 2 * MAXIMUM_MESSAGE_SIZE)
+    {
+        std::geometric_distribution<std::size_t> smallChunk(0.05);
+        std::uniform_int_distribution<std::size_t> largeChunk(1, maxChunkSize);
+        std::size_t offset = 0;
+        while (offset < stream.size())
+        {
+            const std::size_t chunk = (random() % 4 == 0) ? largeChunk(random) : 1 + smallChunk(random);
+            const std::size_t size = std::min(chunk, stream.size() - offset);
+            Deliver(stream.data() + offset, size);
+            offset += size;
+        }
+    }
+
+    // Prepare and commit a message whose payload bytes count up from 'first'.
+    void Send(unsigned char type, std::size_t size, unsigned char first)
+    {
+        unsigned char* payload = mConnection->PrepareMessage(type, size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            payload[i] = static_cast<unsigned char>(first + i);
+        }
+        mConnection->CommitMessage(SendMode::ASAP);
+    }
+
+    // Read from the peer socket, and let the connection write, until 'count'
+    // bytes have been received in all.
+    void ReceiveFromPeer(std::size_t count, std::vector<unsigned char>* received = nullptr)
+    {
+        std::size_t total = 0;
+        for (int idle = 0; total < count && idle < 10000;)
+        {
+            mContext.poll();
+            boost::system::error_code error;
+            const std::size_t size = mPeer.read_some(boost::asio::buffer(mPeerBuffer), error);
+            BOOST_REQUIRE(!error || error == boost::asio::error::would_block);
+            if (received != nullptr)
+            {
+                received->insert(received->end(), mPeerBuffer.begin(), mPeerBuffer.begin() + size);
+            }
+            total += size;
+            idle = (size == 0) ? idle + 1 : 0;
+        }
+        BOOST_REQUIRE_EQUAL(total, count);
+    }
+
+    std::size_t BytesAvailable() const
+    {
+        int count = 0;
+        ::ioctl(mSocketHandle, FIONREAD, &count);
+        return count;
+    }
+
+    static Message RandomMessage(std::mt19937& random, std::size_t length)
+    {
+        Message message{static_cast<unsigned char>(random()), std::vector<unsigned char>(length - MESSAGE_HEADER_SIZE)};
+        std::generate(message.mPayload.begin(), message.mPayload.end(), [&random]() { return random(); });
+        return message;
+    }
+
+    static void Append(std::vector<unsigned char>& stream, const Message& message)
+    {
+        const std::size_t length = MESSAGE_HEADER_SIZE + message.mPayload.size();
+        stream.push_back(static_cast<unsigned char>(length >> 8));
+        stream.push_back(static_cast<unsigned char>(length));
+        stream.push_back(message.mType);
+        stream.insert(stream.end(), message.mPayload.begin(), message.mPayload.end());
+    }
+
+    boost::asio::io_context mContext;
+    tcp::socket mPeer{mContext};
+    std::array<unsigned char, 65536> mPeerBuffer;
+    int mSocketHandle = -1;
+    std::unique_ptr<Connection> mConnection;
+    std::vector<Message> mReceived;
+    bool mIsDisconnected = false;
+};
+
+BOOST_FIXTURE_TEST_CASE(randomly_split_streams_are_reassembled, ConnectionFixture)
+{
+    std::mt19937 random(1);
+    for (int round = 0; round < 20; ++round)
+    {
+        // Mostly small messages, with some that are just a header and some
+        // of the maximum length.
+        std::vector<Message> sent;
+        std::vector<unsigned char> stream;
+        for (int i = 0; i < 200; ++i)
+        {
+            const unsigned kind = random() % 10;
+            const std::size_t length = (kind == 0) ? MESSAGE_HEADER_SIZE
+                                     : (kind == 1) ? MAXIMUM_MESSAGE_SIZE
+                                     : MESSAGE_HEADER_SIZE + random() % 200;
+            sent.push_back(RandomMessage(random, length));
+            Append(stream, sent.back());
+        }
+
+        mReceived.clear();
+        DeliverInRandomChunks(stream, random);
+        BOOST_TEST(!mIsDisconnected);
+        BOOST_TEST(mReceived == sent, boost::test_tools::per_element());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(maximum_length_frames_split_anywhere_are_reassembled, ConnectionFixture)
+{
+    std::mt19937 random(2);
+    std::vector<Message> sent;
+    std::vector<unsigned char> stream;
+    for (int i = 0; i < 8; ++i)
+    {
+        sent.push_back(RandomMessage(random, MAXIMUM_MESSAGE_SIZE));
+        Append(stream, sent.back());
+    }
+
+    DeliverInRandomChunks(stream, random, 4096);
+    BOOST_TEST(!mIsDisconnected);
+    BOOST_TEST(mReceived == sent, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(a_length_below_the_header_size_disconnects)
+{
+    for (std::size_t badLength = 0; badLength < MESSAGE_HEADER_SIZE; ++badLength)
+    {
+        ConnectionFixture fixture;
+        std::mt19937 random(3 + badLength);
+        std::vector<Message> sent;
+        std::vector<unsigned char> stream;
+        for (int i = 0; i < 20; ++i)
+        {
+            sent.push_back(ConnectionFixture::RandomMessage(random, MESSAGE_HEADER_SIZE + random() % 100));
+            ConnectionFixture::Append(stream, sent.back());
+        }
+
+        // A malformed header followed by what would otherwise be a valid
+        // message, which must not be delivered.
+        stream.push_back(0);
+        stream.push_back(static_cast<unsigned char>(badLength));
+        stream.push_back(1);
+        ConnectionFixture::Append(stream, ConnectionFixture::RandomMessage(random, 10));
+
+        fixture.DeliverInRandomChunks(stream, random);
+        BOOST_TEST(fixture.mIsDisconnected);
+        BOOST_TEST(fixture.mReceived == sent, boost::test_tools::per_element());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(messages_prepared_during_a_write_are_held_back_until_it_completes, ConnectionFixture)
+{
+    // Far more than fits in the send buffer, let alone the socket buffers,
+    // is sent before the peer reads anything.
+    std::mt19937 random(4);
+    std::vector<unsigned char> expected;
+    for (int i = 0; i < 5000; ++i)
+    {
+        const unsigned char type = random();
+        const std::size_t size = 10 + random() % 90;
+        const unsigned char first = random();
+        Send(type, size, first);
+
+        ConnectionFixture::Append(expected, Message{type, std::vector<unsigned char>(size)});
+        for (std::size_t j = 0; j < size; ++j)
+        {
+            expected[expected.size() - size + j] = static_cast<unsigned char>(first + j);
+        }
+    }
+
+    std::vector<unsigned char> received;
+    ReceiveFromPeer(expected.size(), &received);
+    BOOST_TEST(received == expected, boost::test_tools::per_element());
+}
+
+BOOST_FIXTURE_TEST_CASE(sending_allocates_nothing_while_the_peer_keeps_up, ConnectionFixture)
+{
+    // Each burst fits in the socket buffers, so every message is written
+    // straight away, as orders are when the exchange is keeping up.
+    auto sendBursts = [this](int burstCount) {
+        constexpr std::size_t messageCount = 20;
+        constexpr std::size_t payloadSize = 27;
+        for (int burst = 0; burst < burstCount; ++burst)
+        {
+            for (std::size_t i = 0; i < messageCount; ++i)
+            {
+                Send(1, payloadSize, static_cast<unsigned char>(i));
+            }
+            ReceiveFromPeer(messageCount * (MESSAGE_HEADER_SIZE + payloadSize));
+        }
+    };
+
+    sendBursts(10);
+    const std::size_t before = allocationCount;
+    sendBursts(10000);
+    const std::size_t allocations = allocationCount - before;
+    BOOST_TEST(allocations == 0u);
+}
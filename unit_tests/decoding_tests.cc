@@ -0,0 +1,116 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE decoding_tests
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+#include <boost/mpl/list.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/fielddecoding.h"
+#include "ready_trader_go/protocol.h"
+#include "ready_trader_go/types.h"
+
+using namespace ReadyTraderGo;
+
+// Each variant of this test is built for one instruction set and says which
+// decoder it expects readLongs to have been compiled to use.
+#ifdef RTG_EXPECTED_DECODER
+BOOST_AUTO_TEST_CASE(expected_decoder_is_compiled_in)
+{
+    BOOST_TEST(std::string(READ_LONGS_DECODER) == RTG_EXPECTED_DECODER);
+}
+#endif
+
+using FieldTypes = boost::mpl::list<uint32_t, uint64_t, Price, Volume>;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(vector_and_scalar_decoders_agree_on_random_input, T, FieldTypes)
+{
+    BOOST_TEST_MESSAGE("readLongs decoder: " << READ_LONGS_DECODER);
+
+    std::mt19937_64 random(42);
+    std::vector<unsigned char> data(MessageFieldSize::LONG * 64 + 16);
+    for (int round = 0; round < 1000; ++round)
+    {
+        for (auto& byte : data)
+        {
+            byte = static_cast<unsigned char>(random());
+        }
+
+        // Every count up to a few whole vectors plus a remainder, read from
+        // unaligned offsets.
+        const std::size_t count = random() % 41;
+        const std::size_t offset = random() % 16;
+        std::vector<T> vector(count + 1, T(0xDEADBEEFul));
+        std::vector<T> scalar(count + 1, T(0xDEADBEEFul));
+
+        auto* vectorEnd = readLongs(data.data() + offset, vector.data(), count);
+        auto* scalarEnd = readLongsScalar(data.data() + offset, scalar.data(), count);
+
+        BOOST_TEST(vectorEnd == scalarEnd);
+        BOOST_TEST(vectorEnd == data.data() + offset + count * MessageFieldSize::LONG);
+        for (std::size_t i = 0; i <= count; ++i)
+        {
+            BOOST_TEST(static_cast<uint64_t>(vector[i]) == static_cast<uint64_t>(scalar[i]));
+        }
+        BOOST_TEST(static_cast<uint64_t>(vector[count]) == 0xDEADBEEFul);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(scalar_decoder_reads_big_endian_fields)
+{
+    const std::array<unsigned char, 8> data{0x01, 0x02, 0x03, 0x04, 0xFF, 0xFF, 0xFF, 0xFE};
+    std::array<uint64_t, 2> fields{};
+    readLongsScalar(data.data(), fields.data(), fields.size());
+    BOOST_TEST(fields[0] == 0x01020304u);
+    BOOST_TEST(fields[1] == 0xFFFFFFFEu);
+}
+
+BOOST_AUTO_TEST_CASE(order_book_message_round_trips)
+{
+    std::mt19937 random(7);
+    std::array<Price, TOP_LEVEL_COUNT> askPrices, bidPrices;
+    std::array<Volume, TOP_LEVEL_COUNT> askVolumes, bidVolumes;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        askPrices[i] = random();
+        askVolumes[i] = random();
+        bidPrices[i] = random();
+        bidVolumes[i] = random();
+    }
+
+    const OrderBookMessage original(Instrument::ETF, 123456, askPrices, askVolumes, bidPrices, bidVolumes);
+    std::vector<unsigned char> buffer(original.Size());
+    original.Serialise(buffer.data());
+
+    OrderBookMessage decoded;
+    decoded.Deserialise(buffer.data(), buffer.size());
+    BOOST_TEST((decoded.mInstrument == Instrument::ETF));
+    BOOST_TEST(decoded.mSequenceNumber == 123456u);
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        BOOST_TEST(decoded.mAskPrices[i] == askPrices[i]);
+        BOOST_TEST(decoded.mAskVolumes[i] == askVolumes[i]);
+        BOOST_TEST(decoded.mBidPrices[i] == bidPrices[i]);
+        BOOST_TEST(decoded.mBidVolumes[i] == bidVolumes[i]);
+    }
+}
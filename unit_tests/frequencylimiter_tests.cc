@@ -0,0 +1,64 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE frequencylimiter_tests
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/error.h"
+#include "ready_trader_go/frequencylimiter.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+constexpr TraderClock::time_point T0{std::chrono::hours(1)};
+
+BOOST_AUTO_TEST_CASE(events_beyond_the_limit_are_refused)
+{
+    FrequencyLimiter limiter{1s, 3};
+    BOOST_TEST(limiter.GetLimit() == 3u);
+    BOOST_TEST(limiter.Admit(T0));
+    BOOST_TEST(limiter.Admit(T0 + 100ms));
+    BOOST_TEST(limiter.Admit(T0 + 200ms));
+    BOOST_TEST(!limiter.CanAdmit(T0 + 300ms));
+    BOOST_TEST(!limiter.Admit(T0 + 300ms));
+
+    BOOST_TEST((limiter.GetNextAdmitTime() == T0 + 1s));
+    BOOST_TEST(limiter.Admit(T0 + 1s));
+    BOOST_TEST(!limiter.Admit(T0 + 1s));
+}
+
+BOOST_AUTO_TEST_CASE(an_event_counts_until_exactly_one_interval_after_it)
+{
+    FrequencyLimiter limiter{1s, 2};
+    BOOST_TEST(limiter.Admit(T0));
+    BOOST_TEST(limiter.Admit(T0 + 400ms));
+
+    BOOST_TEST(!limiter.Admit(T0 + 1s - 1ns));
+    BOOST_TEST(limiter.Admit(T0 + 1s));
+    BOOST_TEST((limiter.GetNextAdmitTime() == T0 + 1400ms));
+    BOOST_TEST(!limiter.Admit(T0 + 1400ms - 1ns));
+    BOOST_TEST(limiter.Admit(T0 + 1400ms));
+    BOOST_TEST(!limiter.Admit(T0 + 1400ms));
+    BOOST_TEST((limiter.GetNextAdmitTime() == T0 + 2s));
+}
+
+BOOST_AUTO_TEST_CASE(a_limit_of_zero_is_rejected)
+{
+    BOOST_CHECK_THROW((FrequencyLimiter{1s, 0}), ReadyTraderGoError);
+}
@@ -0,0 +1,213 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE hedgeaggregator_tests
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/error.h"
+#include "ready_trader_go/hedgeaggregator.h"
+#include "ready_trader_go/traderclock.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+// Keeps each hedge the aggregator sends as a line of text, prefixed with
+// the simulated time it was sent at, and gives them ids from 1
+struct HedgeRecorder
+{
+    explicit HedgeRecorder(HedgeAggregator& hedger)
+    {
+        hedger.SendHedge = [this](Side side, Volume volume) -> unsigned long {
+            if (mIsRefusing)
+            {
+                return 0;
+            }
+            const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(TraderClock::now()
+                                                                                   - SimulatedClock::START);
+            std::ostringstream line;
+            line << time.count() << "ms " << side << ' ' << volume;
+            mHedges.push_back(line.str());
+            return mHedges.size();
+        };
+    }
+
+    bool mIsRefusing = false;
+    std::vector<std::string> mHedges;
+};
+
+BOOST_AUTO_TEST_CASE(an_opposite_fill_nets_off_and_can_flip_the_position)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    HedgeAggregator hedger(context, MANUAL_HEDGE_WINDOW);
+    HedgeRecorder recorder(hedger);
+
+    hedger.AddFill(Side::BUY, 10, 100);
+    hedger.AddFill(Side::BUY, 10, 120);
+    hedger.AddFill(Side::SELL, 5, 999);
+    BOOST_TEST(hedger.GetNetPosition() == 15);
+
+    // The sell leaves 25 lots short, at the sell's own reference price
+    hedger.AddFill(Side::SELL, 40, 200);
+    BOOST_TEST(hedger.GetNetPosition() == -25);
+    BOOST_TEST(hedger.GetStats().mNettedVolume == 40u);
+    BOOST_TEST(hedger.GetStats().mFillVolume == 65u);
+
+    hedger.Flush();
+    BOOST_TEST(recorder.mHedges == std::vector<std::string>{"0ms Buy 25"}, boost::test_tools::per_element());
+    BOOST_TEST(hedger.GetNetPosition() == 0);
+    BOOST_TEST(hedger.HedgeFilled(1, 202, 25));
+    BOOST_TEST(hedger.GetStats().mSlippage == 2 * 25);
+    BOOST_TEST(hedger.GetStats().GetMessagesSaved() == 3);
+
+    // Netting to nothing sends nothing
+    hedger.AddFill(Side::BUY, 5, 100);
+    hedger.AddFill(Side::SELL, 5, 100);
+    hedger.Flush();
+    BOOST_TEST(recorder.mHedges.size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(slippage_is_the_cost_against_the_reference_price_on_either_side)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    HedgeAggregator hedger(context, MANUAL_HEDGE_WINDOW);
+    HedgeRecorder recorder(hedger);
+
+    // Long ETF lots are hedged by selling the future: selling below the
+    // reference price costs, selling above it gains
+    hedger.AddFill(Side::BUY, 10, 1000);
+    hedger.Flush();
+    BOOST_TEST(hedger.HedgeFilled(1, 990, 10));
+    BOOST_TEST(hedger.GetStats().mSlippage == 100);
+    hedger.AddFill(Side::BUY, 10, 1000);
+    hedger.Flush();
+    BOOST_TEST(hedger.HedgeFilled(2, 1003, 10));
+    BOOST_TEST(hedger.GetStats().mSlippage == 100 - 30);
+
+    // Short ETF lots are hedged by buying: buying above it costs
+    hedger.AddFill(Side::SELL, 10, 1000);
+    hedger.Flush();
+    BOOST_TEST(hedger.HedgeFilled(3, 1005, 10));
+    BOOST_TEST(hedger.GetStats().mSlippage == 70 + 50);
+    hedger.AddFill(Side::SELL, 10, 1000);
+    hedger.Flush();
+    BOOST_TEST(hedger.HedgeFilled(4, 980, 10));
+    BOOST_TEST(hedger.GetStats().mSlippage == 120 - 200);
+
+    const std::vector<std::string> expected{"0ms Sell 10", "0ms Sell 10", "0ms Buy 10", "0ms Buy 10"};
+    BOOST_TEST(recorder.mHedges == expected, boost::test_tools::per_element());
+    BOOST_TEST(hedger.GetStats().mHedgedVolume == 40u);
+    BOOST_TEST(hedger.GetStats().GetSlippagePerLot() == -2.0);
+    BOOST_TEST(!hedger.HedgeFilled(4, 980, 10));
+}
+
+BOOST_AUTO_TEST_CASE(an_unfilled_hedge_is_put_back_at_its_reference_price)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    HedgeAggregator hedger(context, MANUAL_HEDGE_WINDOW);
+    HedgeRecorder recorder(hedger);
+
+    hedger.AddFill(Side::BUY, 10, 100);
+    hedger.Flush();
+    BOOST_TEST(hedger.HedgeFilled(1, 98, 6));
+    BOOST_TEST(hedger.GetStats().mSlippage == 12);
+    BOOST_TEST(hedger.GetStats().mHedgedVolume == 6u);
+    BOOST_TEST(hedger.GetNetPosition() == 4);
+
+    // The 4 lots put back at 100 and 4 more at 200 average 150, so a hedge
+    // filled at 150 costs nothing more
+    hedger.AddFill(Side::BUY, 4, 200);
+    hedger.Flush();
+    BOOST_TEST(hedger.HedgeFilled(2, 150, 8));
+    BOOST_TEST(hedger.GetStats().mSlippage == 12);
+
+    // A hedge that can't be sent leaves the lots to be hedged
+    hedger.AddFill(Side::SELL, 3, 100);
+    recorder.mIsRefusing = true;
+    hedger.Flush();
+    BOOST_TEST(hedger.GetNetPosition() == -3);
+    BOOST_TEST(hedger.GetStats().mHedgeCount == 2u);
+
+    const std::vector<std::string> expected{"0ms Sell 10", "0ms Sell 8"};
+    BOOST_TEST(recorder.mHedges == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(with_a_zero_window_fills_are_hedged_at_the_end_of_the_turn)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    HedgeAggregator hedger(context);
+    HedgeRecorder recorder(hedger);
+
+    hedger.AddFill(Side::BUY, 10, 100);
+    hedger.AddFill(Side::SELL, 4, 100);
+    BOOST_TEST(recorder.mHedges.empty());
+    clock.Run(context);
+    BOOST_TEST(recorder.mHedges == std::vector<std::string>{"0ms Sell 6"}, boost::test_tools::per_element());
+
+    // What a hedge leaves unfilled is hedged again straight away
+    BOOST_TEST(hedger.HedgeFilled(1, 100, 2));
+    context.restart();
+    clock.Run(context);
+    const std::vector<std::string> expected{"0ms Sell 6", "0ms Sell 4"};
+    BOOST_TEST(recorder.mHedges == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(with_a_fixed_window_fills_are_hedged_a_window_after_the_first)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    HedgeAggregator hedger(context, 50ms);
+    HedgeRecorder recorder(hedger);
+
+    TraderTimer later{context};
+    hedger.AddFill(Side::BUY, 10, 100);
+    later.expires_after(30ms);
+    later.async_wait([&](const boost::system::error_code&) { hedger.AddFill(Side::BUY, 5, 100); });
+    clock.Run(context);
+    BOOST_TEST(recorder.mHedges == std::vector<std::string>{"50ms Sell 15"}, boost::test_tools::per_element());
+
+    BOOST_TEST(hedger.HedgeFilled(1, 100, 10));
+    context.restart();
+    clock.Run(context);
+    const std::vector<std::string> expected{"50ms Sell 15", "100ms Sell 5"};
+    BOOST_TEST(recorder.mHedges == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(with_a_manual_window_fills_wait_for_a_flush)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    HedgeAggregator hedger(context, MANUAL_HEDGE_WINDOW);
+    HedgeRecorder recorder(hedger);
+
+    hedger.AddFill(Side::SELL, 10, 100);
+    BOOST_TEST(clock.Run(context) == 0u);
+    BOOST_TEST(recorder.mHedges.empty());
+    hedger.Flush();
+    BOOST_TEST(recorder.mHedges == std::vector<std::string>{"0ms Buy 10"}, boost::test_tools::per_element());
+
+    BOOST_CHECK_THROW(HedgeAggregator(context, -1ms), ReadyTraderGoError);
+}
@@ -0,0 +1,187 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE localbook_tests
+#include <array>
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/localbook.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+using Prices = std::array<Price, TOP_LEVEL_COUNT>;
+using Volumes = std::array<Volume, TOP_LEVEL_COUNT>;
+
+constexpr TraderClock::time_point T0{std::chrono::hours(1)};
+
+// Five levels a tick apart from the given price (in ticks of 100 cents),
+// going up for asks and down for bids
+static Prices levels(Side side, unsigned long tick)
+{
+    Prices prices{};
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        prices[i] = (side == Side::SELL ? tick + i : tick - i) * 100;
+    }
+    return prices;
+}
+
+static const Volumes VOLUMES{10, 20, 30, 40, 50};
+
+BOOST_AUTO_TEST_CASE(levels_the_snapshot_reaches_are_replaced_and_those_beyond_it_are_kept)
+{
+    LocalBook book;
+    BOOST_TEST(book.ApplyOrderBook(1, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0));
+    BOOST_TEST(book.GetBestAsk() == 10100u);
+    BOOST_TEST(book.GetBestBid() == 9900u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10500) == 50u);
+
+    // The market moves down a tick. The ask at 105 is now beyond the fifth
+    // level, so it keeps its volume; the bid at 99 is still within reach, so
+    // it has gone.
+    BOOST_TEST(book.ApplyOrderBook(2, levels(Side::SELL, 100), VOLUMES, levels(Side::BUY, 98), VOLUMES, T0));
+    BOOST_TEST(book.GetVolume(Side::SELL, 10000) == 10u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10400) == 50u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10500) == 50u);
+    BOOST_TEST(book.GetVolume(Side::BUY, 9900) == 0u);
+    BOOST_TEST(book.GetVolume(Side::BUY, 9400) == 50u);
+
+    // Prices skipped between two levels of a snapshot are empty
+    const Prices asks{10000, 10300, 10400, 10500, 10600};
+    BOOST_TEST(book.ApplyOrderBook(3, asks, VOLUMES, levels(Side::BUY, 98), VOLUMES, T0));
+    BOOST_TEST(book.GetVolume(Side::SELL, 10100) == 0u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10200) == 0u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10300) == 20u);
+
+    // Trade ticks take volume off the levels they traded at
+    const Prices traded{10000, 10300, 0, 0, 0};
+    const Volumes tradedVolumes{4, 25, 0, 0, 0};
+    book.ApplyTradeTicks(traded, tradedVolumes, Prices{}, Volumes{});
+    BOOST_TEST(book.GetVolume(Side::SELL, 10000) == 6u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10300) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(snapshots_that_are_not_later_than_the_last_are_ignored)
+{
+    LocalBook book;
+    BOOST_TEST(book.ApplyOrderBook(5, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0));
+    BOOST_TEST(!book.ApplyOrderBook(5, levels(Side::SELL, 111), VOLUMES, levels(Side::BUY, 109), VOLUMES, T0));
+    BOOST_TEST(!book.ApplyOrderBook(4, levels(Side::SELL, 111), VOLUMES, levels(Side::BUY, 109), VOLUMES, T0));
+    BOOST_TEST(book.GetSequenceNumber() == 5u);
+    BOOST_TEST(book.GetBestAsk() == 10100u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 11100) == 0u);
+
+    // A gap in the sequence numbers doesn't matter
+    BOOST_TEST(book.ApplyOrderBook(9, levels(Side::SELL, 111), VOLUMES, levels(Side::BUY, 109), VOLUMES, T0));
+    BOOST_TEST(book.GetSequenceNumber() == 9u);
+    BOOST_TEST(book.GetBestAsk() == 11100u);
+}
+
+BOOST_AUTO_TEST_CASE(the_window_follows_the_market_keeping_the_levels_that_overlap)
+{
+    // A window of 32 ticks, centred on the first price seen: 80 to 111
+    LocalBook book(100, 32);
+    book.ApplyOrderBook(1, levels(Side::SELL, 96), VOLUMES, levels(Side::BUY, 95), VOLUMES, T0);
+    book.ApplyOrderBook(2, levels(Side::SELL, 106), VOLUMES, levels(Side::BUY, 105), VOLUMES, T0);
+    BOOST_TEST(book.GetVolume(Side::BUY, 10100) == 50u);
+
+    // An ask at 120 moves the window on to 104 to 135. The bids at 105 and
+    // below are beyond the new snapshot's fifth level, so those still in the
+    // window keep their volumes and the rest are forgotten. The asks the
+    // market has moved through are empty.
+    book.ApplyOrderBook(3, levels(Side::SELL, 120), VOLUMES, levels(Side::BUY, 119), VOLUMES, T0);
+    BOOST_TEST(book.GetVolume(Side::BUY, 11900) == 10u);
+    BOOST_TEST(book.GetVolume(Side::BUY, 10500) == 10u);
+    BOOST_TEST(book.GetVolume(Side::BUY, 10400) == 20u);
+    BOOST_TEST(book.GetVolume(Side::BUY, 10300) == 0u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 10600) == 0u);
+
+    // A jump further than the window clears it
+    book.ApplyOrderBook(4, levels(Side::SELL, 500), VOLUMES, levels(Side::BUY, 499), VOLUMES, T0);
+    BOOST_TEST(book.GetVolume(Side::SELL, 50000) == 10u);
+    BOOST_TEST(book.GetVolume(Side::SELL, 12400) == 0u);
+    BOOST_TEST(book.GetVolume(Side::BUY, 11900) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(a_level_ages_while_it_is_in_every_snapshot)
+{
+    LocalBook book;
+    book.ApplyOrderBook(1, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0);
+    book.ApplyOrderBook(2, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0 + 1s);
+    BOOST_TEST((book.GetLevelAge(Side::SELL, 10100, T0 + 2s) == 2s));
+    BOOST_TEST((book.GetLevelAge(Side::BUY, 9500, T0 + 2s) == 2s));
+
+    // The asks move up a tick: 101 drops out and 106 is new
+    book.ApplyOrderBook(3, levels(Side::SELL, 102), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0 + 3s);
+    BOOST_TEST((book.GetLevelAge(Side::SELL, 10100, T0 + 4s) == 0s));
+    BOOST_TEST((book.GetLevelAge(Side::SELL, 10200, T0 + 4s) == 4s));
+    BOOST_TEST((book.GetLevelAge(Side::SELL, 10600, T0 + 4s) == 1s));
+
+    // A level that comes back starts again
+    book.ApplyOrderBook(4, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0 + 5s);
+    BOOST_TEST((book.GetLevelAge(Side::SELL, 10100, T0 + 6s) == 1s));
+    BOOST_TEST((book.GetLevelAge(Side::BUY, 9900, T0 + 6s) == 6s));
+    BOOST_TEST((book.GetLevelAge(Side::SELL, 20000, T0 + 6s) == 0s));
+}
+
+BOOST_AUTO_TEST_CASE(imbalance_compares_the_best_levels)
+{
+    LocalBook book;
+    BOOST_TEST(book.GetImbalance() == 0.0);
+
+    const Volumes bidVolumes{30, 10, 0, 0, 0};
+    book.ApplyOrderBook(1, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), bidVolumes, T0);
+    BOOST_TEST(book.GetImbalance() == 0.5);
+    BOOST_TEST(book.GetImbalance(2) == 10.0 / 70.0);
+    BOOST_TEST(book.GetImbalance(TOP_LEVEL_COUNT) == (40.0 - 150.0) / 190.0);
+}
+
+BOOST_AUTO_TEST_CASE(volume_ahead_of_an_order_only_falls)
+{
+    LocalBook book;
+    book.ApplyOrderBook(1, levels(Side::SELL, 101), VOLUMES, levels(Side::BUY, 99), VOLUMES, T0);
+    book.AddOrder(1, Side::SELL, 10200, 10);
+    BOOST_TEST(book.GetVolumeAhead(1) == 20u);
+
+    // Trades at the price take volume from the front of the queue
+    const Prices traded{10200, 0, 0, 0, 0};
+    book.ApplyTradeTicks(traded, Volumes{5, 0, 0, 0, 0}, Prices{}, Volumes{});
+    BOOST_TEST(book.GetVolumeAhead(1) == 15u);
+
+    // Our own order is on the level now. Volume that others add joins the
+    // queue behind it, but volume they cancel may have been ahead of it.
+    Volumes volumes = VOLUMES;
+    volumes[1] = 10 + 40;
+    book.ApplyOrderBook(2, levels(Side::SELL, 101), volumes, levels(Side::BUY, 99), VOLUMES, T0);
+    BOOST_TEST(book.GetVolumeAhead(1) == 15u);
+    volumes[1] = 10 + 12;
+    book.ApplyOrderBook(3, levels(Side::SELL, 101), volumes, levels(Side::BUY, 99), VOLUMES, T0);
+    BOOST_TEST(book.GetVolumeAhead(1) == 12u);
+
+    // A partial fill leaves less of ours on the level
+    book.SetOrderRemaining(1, 4);
+    volumes[1] = 4 + 9;
+    book.ApplyOrderBook(4, levels(Side::SELL, 101), volumes, levels(Side::BUY, 99), VOLUMES, T0);
+    BOOST_TEST(book.GetVolumeAhead(1) == 9u);
+
+    book.SetOrderRemaining(1, 0);
+    BOOST_TEST(book.GetVolumeAhead(1) == 0u);
+    BOOST_TEST(book.GetVolumeAhead(2) == 0u);
+}
@@ -0,0 +1,316 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE matchingbook_tests
+#include <array>
+#include <deque>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "backtest/marketevents.h"
+#include "matching_engine/matchingbook.h"
+#include "referenceorderbook.h"
+
+using namespace ReadyTraderGo;
+
+constexpr unsigned long TICK_SIZE = 100;
+constexpr double MAKER_FEE = -0.0001;
+constexpr double TAKER_FEE = 0.0002;
+
+// Everything a book tells an order's listener, in order
+class RecordingListener : public IOrderListener
+{
+public:
+    using Record = std::tuple<int, unsigned long, unsigned long, unsigned long, long, unsigned long>;
+
+    void OnOrderAmended(double, Order& order, unsigned long volumeRemoved) override
+    {
+        mRecords.emplace_back(0, order.mClientOrderId, volumeRemoved, 0, 0, order.mRemainingVolume);
+    }
+    void OnOrderCancelled(double, Order& order, unsigned long volumeRemoved) override
+    {
+        mRecords.emplace_back(1, order.mClientOrderId, volumeRemoved, 0, 0, order.mRemainingVolume);
+    }
+    void OnOrderPlaced(double, Order& order) override
+    {
+        mRecords.emplace_back(2, order.mClientOrderId, 0, 0, 0, order.mRemainingVolume);
+    }
+    void OnOrderFilled(double, Order& order, unsigned long price, unsigned long volume, long fee) override
+    {
+        mRecords.emplace_back(3, order.mClientOrderId, price, volume, fee, order.mRemainingVolume);
+    }
+
+    std::vector<Record> mRecords;
+};
+
+// The same orders sent to a MatchingBook and to the reference book, which
+// must agree after every one of them
+class BookComparison
+{
+public:
+    explicit BookComparison(Instrument instrument, std::size_t window = DEFAULT_MATCHING_BOOK_WINDOW)
+        : mBook(instrument, TICK_SIZE, MAKER_FEE, TAKER_FEE, window),
+          mReference(instrument, MAKER_FEE, TAKER_FEE)
+    {
+        mBook.TradeOccurred = [this](MatchingBook&) { ++mBookTradeCount; };
+        mReference.TradeOccurred = [this](ReferenceOrderBook&) { ++mReferenceTradeCount; };
+    }
+
+    void Insert(double now, unsigned long id, Side side, unsigned long price, unsigned long volume,
+                Lifespan lifespan)
+    {
+        Order& order = mOrders.emplace_back(Order{id, mBook.GetInstrument(), lifespan, side, price, volume, volume, 0,
+                                                  &mBookListener});
+        Order& reference = mReferenceOrders.emplace_back(order);
+        reference.mListener = &mReferenceListener;
+        mBook.Insert(now, order);
+        mReference.Insert(now, reference);
+        if (order.mRemainingVolume != 0)
+        {
+            mLive[id] = {&order, &reference};
+        }
+        Compare();
+    }
+
+    void Amend(double now, unsigned long id, unsigned long newVolume)
+    {
+        auto it = mLive.find(id);
+        mBook.Amend(now, *it->second.first, newVolume);
+        mReference.Amend(now, *it->second.second, newVolume);
+        Forget(it);
+        Compare();
+    }
+
+    void Cancel(double now, unsigned long id)
+    {
+        auto it = mLive.find(id);
+        mBook.Cancel(now, *it->second.first);
+        mReference.Cancel(now, *it->second.second);
+        Forget(it);
+        Compare();
+    }
+
+    // Compare the prices a hedge would get
+    void TryTrade(Side side, unsigned long limitPrice, unsigned long volume)
+    {
+        const auto expected = mReference.TryTrade(side, limitPrice, volume);
+        const auto actual = mBook.TryTrade(side, limitPrice, volume);
+        BOOST_TEST(actual.first == expected.first);
+        BOOST_TEST(actual.second == expected.second);
+    }
+
+    void TradeTicks()
+    {
+        std::array<Price, TOP_LEVEL_COUNT> askPrices, bidPrices, referenceAskPrices, referenceBidPrices;
+        std::array<Volume, TOP_LEVEL_COUNT> askVolumes, bidVolumes, referenceAskVolumes, referenceBidVolumes;
+        const bool traded = mBook.TradeTicks(askPrices, askVolumes, bidPrices, bidVolumes);
+        BOOST_TEST(traded == mReference.TradeTicks(referenceAskPrices, referenceAskVolumes, referenceBidPrices,
+                                                   referenceBidVolumes));
+        if (traded)
+        {
+            BOOST_TEST(askPrices == referenceAskPrices);
+            BOOST_TEST(askVolumes == referenceAskVolumes);
+            BOOST_TEST(bidPrices == referenceBidPrices);
+            BOOST_TEST(bidVolumes == referenceBidVolumes);
+        }
+    }
+
+    const MatchingBook& GetBook() const noexcept { return mBook; }
+    std::vector<unsigned long> GetLiveIds() const
+    {
+        std::vector<unsigned long> ids;
+        for (const auto& [id, orders] : mLive)
+        {
+            ids.push_back(id);
+        }
+        return ids;
+    }
+    std::size_t GetRecordCount() const noexcept { return mRecordCount; }
+    // The live order with the given id, or nullptr
+    const Order* Find(unsigned long id) const
+    {
+        auto it = mLive.find(id);
+        return (it == mLive.end()) ? nullptr : it->second.first;
+    }
+
+private:
+    using Live = std::unordered_map<unsigned long, std::pair<Order*, Order*>>;
+
+    void Compare()
+    {
+        // Stop at the first difference, rather than report every later one
+        if (mIsDifferent)
+        {
+            return;
+        }
+
+        std::array<Price, TOP_LEVEL_COUNT> askPrices, bidPrices, referenceAskPrices, referenceBidPrices;
+        std::array<Volume, TOP_LEVEL_COUNT> askVolumes, bidVolumes, referenceAskVolumes, referenceBidVolumes;
+        mBook.TopLevels(askPrices, askVolumes, bidPrices, bidVolumes);
+        mReference.TopLevels(referenceAskPrices, referenceAskVolumes, referenceBidPrices, referenceBidVolumes);
+
+        mIsDifferent = askPrices != referenceAskPrices || askVolumes != referenceAskVolumes
+                       || bidPrices != referenceBidPrices || bidVolumes != referenceBidVolumes
+                       || mBook.GetBestAsk() != mReference.GetBestAsk()
+                       || mBook.GetBestBid() != mReference.GetBestBid()
+                       || mBook.GetMidpointPrice() != mReference.GetMidpointPrice()
+                       || mBook.GetLastTradedPrice() != mReference.GetLastTradedPrice()
+                       || mBookTradeCount != mReferenceTradeCount
+                       || mBookListener.mRecords != mReferenceListener.mRecords;
+        BOOST_TEST(!mIsDifferent, "the books differ after " << mRecordCount << " records");
+
+        // Only the records since the last comparison are kept
+        mRecordCount += mBookListener.mRecords.size();
+        mBookListener.mRecords.clear();
+        mReferenceListener.mRecords.clear();
+    }
+
+    void Forget(Live::iterator it)
+    {
+        if (it->second.first->mRemainingVolume == 0)
+        {
+            mLive.erase(it);
+        }
+    }
+
+    MatchingBook mBook;
+    ReferenceOrderBook mReference;
+    RecordingListener mBookListener;
+    RecordingListener mReferenceListener;
+    unsigned long mBookTradeCount = 0;
+    unsigned long mReferenceTradeCount = 0;
+    std::deque<Order> mOrders;
+    std::deque<Order> mReferenceOrders;
+    Live mLive;
+    std::size_t mRecordCount = 0;
+    bool mIsDifferent = false;
+};
+
+// Random orders around a wandering price, crossing often and sometimes
+// jumping far enough to leave the book's level arrays
+static void runRandomOrders(BookComparison& books, unsigned seed, int count)
+{
+    std::mt19937 random(seed);
+    long mid = 1000;  // in ticks
+    unsigned long nextId = 1;
+    for (int i = 0; i < count; ++i)
+    {
+        const double now = i * 0.001;
+        const unsigned action = random() % 100;
+        if (action < 5)
+        {
+            mid = std::max(10l, mid + static_cast<long>(random() % 401) - 200);
+        }
+        else if (action < 60 || books.GetLiveIds().empty())
+        {
+            const Side side = (random() % 2 == 0) ? Side::BUY : Side::SELL;
+            const long offset = static_cast<long>(random() % 11) - ((side == Side::BUY) ? 8 : 2);
+            const auto price = static_cast<unsigned long>(std::max(1l, mid + offset)) * TICK_SIZE;
+            const Lifespan lifespan = (random() % 5 == 0) ? Lifespan::FILL_AND_KILL : Lifespan::GOOD_FOR_DAY;
+            books.Insert(now, nextId++, side, price, 1 + random() % 100, lifespan);
+        }
+        else
+        {
+            const auto ids = books.GetLiveIds();
+            const unsigned long id = ids[random() % ids.size()];
+            if (action < 80)
+            {
+                books.Cancel(now, id);
+            }
+            else
+            {
+                books.Amend(now, id, random() % 100);
+            }
+        }
+
+        if (i % 10 == 0)
+        {
+            const Side side = (random() % 2 == 0) ? Side::BUY : Side::SELL;
+            books.TryTrade(side, static_cast<unsigned long>(mid + static_cast<long>(random() % 9) - 4) * TICK_SIZE,
+                           1 + random() % 300);
+        }
+        if (i % 37 == 0)
+        {
+            books.TradeTicks();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(random_orders_match_as_in_the_reference_book)
+{
+    for (unsigned seed = 1; seed <= 3; ++seed)
+    {
+        BookComparison books{Instrument::ETF};
+        runRandomOrders(books, seed, 50000);
+        BOOST_TEST(books.GetRecordCount() > 50000u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(levels_outside_the_window_match_as_in_the_reference_book)
+{
+    // A window of a few ticks puts most levels in the overflow map
+    BookComparison books{Instrument::ETF, 16};
+    runRandomOrders(books, 4, 50000);
+}
+
+// The events of a day of market data, in one book per instrument, as the
+// backtest replays them
+BOOST_AUTO_TEST_CASE(market_data_matches_as_in_the_reference_book)
+{
+    const std::string filename = std::string(RTG_SOURCE_DIR) + "/data/market_data1.csv";
+    if (!std::filesystem::exists(filename))
+    {
+        BOOST_TEST_MESSAGE("skipped: " << filename << " not found");
+        return;
+    }
+
+    BookComparison futureBook{Instrument::FUTURE};
+    BookComparison etfBook{Instrument::ETF};
+    std::size_t count = 0;
+    for (const MarketEvent& event : readMarketEvents(filename))
+    {
+        BookComparison& book = (event.mInstrument == Instrument::FUTURE) ? futureBook : etfBook;
+        if (event.mOperation == MarketEventOperation::INSERT)
+        {
+            const auto volume = static_cast<unsigned long>(std::max<std::int32_t>(event.mVolume, 0));
+            book.Insert(event.mTime, event.mOrderId, event.mSide, event.mPrice, volume, event.mLifespan);
+        }
+        else if (const Order* order = book.Find(event.mOrderId))
+        {
+            if (event.mOperation == MarketEventOperation::CANCEL)
+            {
+                book.Cancel(event.mTime, event.mOrderId);
+            }
+            else if (event.mVolume < 0)
+            {
+                const long volume = static_cast<long>(order->mVolume) + event.mVolume;
+                book.Amend(event.mTime, event.mOrderId, static_cast<unsigned long>(std::max(volume, 0l)));
+            }
+        }
+        if (++count % 97 == 0)
+        {
+            book.TradeTicks();
+        }
+    }
+    BOOST_TEST(count > 100000u);
+}
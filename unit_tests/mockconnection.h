@@ -0,0 +1,106 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_UNIT_TESTS_MOCKCONNECTION_H
+#define CPPREADY_TRADER_GO_UNIT_TESTS_MOCKCONNECTION_H
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ready_trader_go/connectivitytypes.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/traderclock.h>
+
+namespace ReadyTraderGo {
+
+// An execution connection that writes each message the auto-trader commits
+// out as a line of text, prefixed with the simulated second it was sent in.
+class MockConnection : public IConnection
+{
+public:
+    void AsyncRead() override {}
+
+    unsigned char* PrepareMessage(unsigned char messageType, std::size_t size) override
+    {
+        mPrepared.push_back({messageType, std::vector<unsigned char>(size)});
+        return mPrepared.back().second.data();
+    }
+
+    void CommitMessage(SendMode) override
+    {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(TraderClock::now() - SimulatedClock::START);
+        for (const auto& [type, payload] : mPrepared)
+        {
+            std::ostringstream line;
+            line << seconds.count() << "s " << describe(type, payload);
+            mSent.push_back(line.str());
+        }
+        mPrepared.clear();
+        ++mCommitCount;
+    }
+
+    std::size_t mCommitCount = 0;
+    std::vector<std::string> mSent;
+
+private:
+    static std::string describe(unsigned char type, const std::vector<unsigned char>& payload)
+    {
+        std::ostringstream text;
+        switch (type)
+        {
+        case MessageType::AMEND_ORDER:
+        {
+            auto amend = makeMessage<AmendMessage>(payload.data(), payload.size());
+            text << "amend " << amend.mClientOrderId << ' ' << amend.mNewVolume;
+            break;
+        }
+        case MessageType::CANCEL_ORDER:
+            text << "cancel " << makeMessage<CancelMessage>(payload.data(), payload.size()).mClientOrderId;
+            break;
+        case MessageType::HEDGE_ORDER:
+        {
+            auto hedge = makeMessage<HedgeMessage>(payload.data(), payload.size());
+            text << "hedge " << hedge.mClientOrderId << ' ' << hedge.mVolume;
+            break;
+        }
+        case MessageType::INSERT_ORDER:
+        {
+            auto insert = makeMessage<InsertMessage>(payload.data(), payload.size());
+            text << "insert " << insert.mClientOrderId << ' ' << insert.mVolume;
+            break;
+        }
+        case MessageType::LOGIN:
+            text << "login";
+            break;
+        default:
+            text << "type " << static_cast<int>(type);
+            break;
+        }
+        return text.str();
+    }
+
+    std::deque<std::pair<unsigned char, std::vector<unsigned char>>> mPrepared;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_UNIT_TESTS_MOCKCONNECTION_H
@@ -0,0 +1,473 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE ordertable_tests
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/ordertable.h"
+
+using namespace ReadyTraderGo;
+
+// The slot an OrderTable index with the given number of entries starts
+// looking for a key in. This is the index's own hash, repeated here so that
+// the tests can choose keys that collide.
+static std::size_t home(std::uint64_t key, std::size_t indexSize)
+{
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (indexSize - 1);
+}
+
+// The first count keys, from first upwards, that start in one of the last
+// slots of an index with the given number of entries
+static std::vector<unsigned long> keysHomedNearTheEnd(std::size_t count,
+                                                     std::size_t lastSlots,
+                                                     std::size_t indexSize,
+                                                     unsigned long first)
+{
+    std::vector<unsigned long> keys;
+    for (unsigned long key = first; keys.size() < count; ++key)
+    {
+        if (home(key, indexSize) >= indexSize - lastSlots)
+        {
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+// The same bookkeeping as an OrderTable, done the obvious way
+class ReferenceTable
+{
+public:
+    explicit ReferenceTable(std::size_t capacity) : mCapacity(capacity) {}
+
+    bool Insert(unsigned long clientOrderId, Side side, Price price, Volume volume, Lifespan lifespan)
+    {
+        if (mOrders.size() == mCapacity || mOrders.count(clientOrderId) != 0)
+        {
+            return false;
+        }
+        mOrders[clientOrderId] = {clientOrderId, side, lifespan, OrderState::INSERTING, price, volume, volume, volume};
+        return true;
+    }
+
+    bool Amend(unsigned long clientOrderId, Volume volume)
+    {
+        auto it = mOrders.find(clientOrderId);
+        if (it == mOrders.end())
+        {
+            return false;
+        }
+        LiveOrder& order = it->second;
+        const unsigned long filled = order.mVolume - order.mRemainingVolume;
+        if (volume >= order.mVolume)
+        {
+            return true;
+        }
+        if (volume <= filled)
+        {
+            order.mVolume = filled;
+            order.mRemainingVolume = 0;
+            order.mState = OrderState::CANCELLING;
+        }
+        else
+        {
+            order.mVolume = volume;
+            order.mRemainingVolume = volume - filled;
+        }
+        return true;
+    }
+
+    bool ApplyStatus(unsigned long clientOrderId, Volume fillVolume, Volume remainingVolume)
+    {
+        auto it = mOrders.find(clientOrderId);
+        if (it == mOrders.end())
+        {
+            return false;
+        }
+        if (remainingVolume == 0)
+        {
+            mOrders.erase(it);
+            return true;
+        }
+        LiveOrder& order = it->second;
+        order.mRemainingVolume = remainingVolume;
+        order.mConfirmedVolume = remainingVolume;
+        order.mVolume = fillVolume + remainingVolume;
+        if (order.mState == OrderState::INSERTING)
+        {
+            order.mState = OrderState::LIVE;
+        }
+        return true;
+    }
+
+    bool MarkCancelling(unsigned long clientOrderId)
+    {
+        auto it = mOrders.find(clientOrderId);
+        if (it == mOrders.end())
+        {
+            return false;
+        }
+        it->second.mState = OrderState::CANCELLING;
+        return true;
+    }
+
+    bool Remove(unsigned long clientOrderId) { return mOrders.erase(clientOrderId) != 0; }
+    void Clear() { mOrders.clear(); }
+
+    const LiveOrder* Find(unsigned long clientOrderId) const
+    {
+        auto it = mOrders.find(clientOrderId);
+        return (it != mOrders.end()) ? &it->second : nullptr;
+    }
+
+    std::size_t GetCount() const { return mOrders.size(); }
+
+    std::size_t GetCount(Side side) const
+    {
+        return std::count_if(mOrders.begin(), mOrders.end(), [side](const auto& o) { return o.second.mSide == side; });
+    }
+
+    std::size_t GetCountAt(Side side, Price price) const
+    {
+        return std::count_if(mOrders.begin(), mOrders.end(), [side, price](const auto& o) {
+            return o.second.mSide == side && o.second.mPrice == price;
+        });
+    }
+
+    unsigned long GetVolumeAt(Side side, Price price) const
+    {
+        unsigned long volume = 0;
+        for (const auto& [id, order] : mOrders)
+        {
+            if (order.mSide == side && order.mPrice == price)
+            {
+                volume += order.mRemainingVolume;
+            }
+        }
+        return volume;
+    }
+
+    unsigned long GetRemainingVolume() const
+    {
+        unsigned long volume = 0;
+        for (const auto& [id, order] : mOrders)
+        {
+            volume += order.mRemainingVolume;
+        }
+        return volume;
+    }
+
+private:
+    std::size_t mCapacity;
+    std::map<unsigned long, LiveOrder> mOrders;
+};
+
+static bool isSameOrder(const LiveOrder& a, const LiveOrder& b)
+{
+    return a.mClientOrderId == b.mClientOrderId && a.mSide == b.mSide && a.mLifespan == b.mLifespan
+           && a.mState == b.mState && a.mPrice == b.mPrice && a.mVolume == b.mVolume
+           && a.mRemainingVolume == b.mRemainingVolume && a.mConfirmedVolume == b.mConfirmedVolume;
+}
+
+// Describe the first difference between a table and the reference, or
+// return an empty string if there is none
+static std::string difference(const OrderTable& table,
+                              const ReferenceTable& reference,
+                              const std::vector<unsigned long>& ids,
+                              const std::vector<unsigned long>& prices)
+{
+    std::ostringstream text;
+    if (table.GetCount() != reference.GetCount()
+        || table.GetCount(Side::BUY) != reference.GetCount(Side::BUY)
+        || table.GetCount(Side::SELL) != reference.GetCount(Side::SELL))
+    {
+        text << "count " << table.GetCount() << " != " << reference.GetCount();
+        return text.str();
+    }
+    if (table.GetRemainingVolume() != reference.GetRemainingVolume())
+    {
+        text << "remaining volume " << table.GetRemainingVolume() << " != " << reference.GetRemainingVolume();
+        return text.str();
+    }
+    for (const auto& order : table)
+    {
+        const LiveOrder* expected = reference.Find(order.mClientOrderId);
+        if (expected == nullptr || !isSameOrder(order, *expected))
+        {
+            text << "order " << order.mClientOrderId << " is not in the reference as it is in the table";
+            return text.str();
+        }
+    }
+    for (unsigned long id : ids)
+    {
+        const LiveOrder* order = table.Find(id);
+        const LiveOrder* expected = reference.Find(id);
+        if ((order == nullptr) != (expected == nullptr) || (order && !isSameOrder(*order, *expected)))
+        {
+            text << "order " << id << " is not found as it is in the reference";
+            return text.str();
+        }
+    }
+    for (Side side : {Side::SELL, Side::BUY})
+    {
+        for (unsigned long price : prices)
+        {
+            if (table.HasOrderAt(side, price) != (reference.GetCountAt(side, price) != 0)
+                || table.GetVolumeAt(side, price) != reference.GetVolumeAt(side, price))
+            {
+                text << side << " level at " << price << " has volume " << table.GetVolumeAt(side, price)
+                     << " != " << reference.GetVolumeAt(side, price);
+                return text.str();
+            }
+        }
+    }
+    return text.str();
+}
+
+BOOST_AUTO_TEST_CASE(random_operations_match_the_reference)
+{
+    // A capacity of 10 gives indexes of 64 entries. Half the ids and prices
+    // are chosen to start in the last few of them, so that probe sequences
+    // are long and wrap around, and removals shift entries back across the
+    // end of the index.
+    constexpr std::size_t CAPACITY = 10;
+    constexpr std::size_t INDEX_SIZE = 64;
+    std::vector<unsigned long> ids = keysHomedNearTheEnd(16, 4, INDEX_SIZE, 1);
+    for (unsigned long id = 1; id <= 16; ++id)
+    {
+        ids.push_back(id);
+    }
+    std::vector<unsigned long> prices = keysHomedNearTheEnd(8, 3, INDEX_SIZE, 100);
+    for (unsigned long price = 100; price < 108; ++price)
+    {
+        prices.push_back(price);
+    }
+
+    OrderTable table(CAPACITY);
+    ReferenceTable reference(CAPACITY);
+    std::mt19937 random(42);
+    auto pick = [&random](const std::vector<unsigned long>& values) {
+        return values[std::uniform_int_distribution<std::size_t>(0, values.size() - 1)(random)];
+    };
+    auto upTo = [&random](unsigned long n) { return std::uniform_int_distribution<unsigned long>(0, n)(random); };
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        const unsigned long id = pick(ids);
+        const LiveOrder* order = reference.Find(id);
+        const unsigned long volume = order ? static_cast<unsigned long>(order->mVolume) : 10;
+        bool isDone, isExpected;
+        switch (upTo(19))
+        {
+        case 0:
+            table.Clear();
+            reference.Clear();
+            isDone = isExpected = true;
+            break;
+        case 1:
+        case 2:
+        case 3:
+            isDone = table.Remove(id);
+            isExpected = reference.Remove(id);
+            break;
+        case 4:
+        case 5:
+            isDone = table.MarkCancelling(id);
+            isExpected = reference.MarkCancelling(id);
+            break;
+        case 6:
+        case 7:
+        case 8:
+        case 9:
+        {
+            const unsigned long newVolume = upTo(volume + 2);
+            isDone = table.Amend(id, newVolume);
+            isExpected = reference.Amend(id, newVolume);
+            break;
+        }
+        case 10:
+        case 11:
+        case 12:
+        case 13:
+        {
+            const unsigned long filled = upTo(volume);
+            const unsigned long remaining = upTo(volume - filled);
+            isDone = table.ApplyStatus(id, filled, remaining);
+            isExpected = reference.ApplyStatus(id, filled, remaining);
+            break;
+        }
+        default:
+        {
+            const Side side = upTo(1) ? Side::BUY : Side::SELL;
+            const unsigned long price = pick(prices);
+            const Lifespan lifespan = upTo(1) ? Lifespan::GOOD_FOR_DAY : Lifespan::FILL_AND_KILL;
+            const unsigned long newVolume = 1 + upTo(20);
+            isDone = table.Insert(id, side, price, newVolume, lifespan) != nullptr;
+            isExpected = reference.Insert(id, side, price, newVolume, lifespan);
+            break;
+        }
+        }
+
+        BOOST_REQUIRE_MESSAGE(isDone == isExpected, "operation " << i << " on order " << id << " returned " << isDone);
+        const std::string mismatch = difference(table, reference, ids, prices);
+        BOOST_REQUIRE_MESSAGE(mismatch.empty(), "after operation " << i << ": " << mismatch);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(colliding_keys_that_wrap_past_the_end_are_found_in_any_order)
+{
+    // A capacity of 4 gives indexes of 16 entries. Three ids start in the
+    // last slot, and so wrap around to the front, where the fourth id starts.
+    constexpr std::size_t INDEX_SIZE = 16;
+    std::vector<unsigned long> ids = keysHomedNearTheEnd(3, 1, INDEX_SIZE, 1);
+    for (unsigned long id = 1; ids.size() < 4; ++id)
+    {
+        if (home(id, INDEX_SIZE) == 0)
+        {
+            ids.push_back(id);
+        }
+    }
+    // Sell prices are their own level keys, so they collide in the same way
+    std::vector<unsigned long> prices = keysHomedNearTheEnd(3, 1, INDEX_SIZE, 100);
+    for (unsigned long price = 100; prices.size() < 4; ++price)
+    {
+        if (home(price, INDEX_SIZE) == 0)
+        {
+            prices.push_back(price);
+        }
+    }
+
+    std::vector<std::size_t> insertOrder{0, 1, 2, 3};
+    do
+    {
+        std::vector<std::size_t> removeOrder{0, 1, 2, 3};
+        do
+        {
+            OrderTable table(4);
+            for (std::size_t i : insertOrder)
+            {
+                BOOST_REQUIRE(table.Insert(ids[i], Side::SELL, prices[i], 10 + i, Lifespan::GOOD_FOR_DAY));
+            }
+            std::vector<bool> isRemoved(4, false);
+            for (std::size_t r : removeOrder)
+            {
+                BOOST_REQUIRE(table.Remove(ids[r]));
+                isRemoved[r] = true;
+                for (std::size_t i = 0; i < 4; ++i)
+                {
+                    const LiveOrder* order = table.Find(ids[i]);
+                    BOOST_REQUIRE((order == nullptr) == isRemoved[i]);
+                    BOOST_REQUIRE(!order || (order->mClientOrderId == ids[i] && order->mPrice == prices[i]));
+                    BOOST_REQUIRE(table.HasOrderAt(Side::SELL, prices[i]) == !isRemoved[i]);
+                    BOOST_REQUIRE(table.GetVolumeAt(Side::SELL, prices[i]) == (isRemoved[i] ? 0u : 10 + i));
+                }
+            }
+        } while (std::next_permutation(removeOrder.begin(), removeOrder.end()));
+    } while (std::next_permutation(insertOrder.begin(), insertOrder.end()));
+}
+
+BOOST_AUTO_TEST_CASE(removing_an_order_moves_the_last_into_its_place)
+{
+    OrderTable table(5);
+    for (unsigned long id = 1; id <= 5; ++id)
+    {
+        table.Insert(id, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY);
+    }
+    auto ids = [&table] {
+        std::vector<unsigned long> result;
+        for (const auto& order : table)
+        {
+            result.push_back(order.mClientOrderId);
+        }
+        return result;
+    };
+
+    BOOST_TEST(table.Remove(1));
+    BOOST_TEST(ids() == (std::vector<unsigned long>{5, 2, 3, 4}), boost::test_tools::per_element());
+    BOOST_TEST(table.Find(5) == &*table.begin());
+
+    // An order status with nothing remaining removes the order the same way
+    BOOST_TEST(table.ApplyStatus(2, 10, 0));
+    BOOST_TEST(ids() == (std::vector<unsigned long>{5, 4, 3}), boost::test_tools::per_element());
+    BOOST_TEST(table.Find(4) == &*(table.begin() + 1));
+
+    // Removing the last order moves nothing
+    BOOST_TEST(table.Remove(3));
+    BOOST_TEST(ids() == (std::vector<unsigned long>{5, 4}), boost::test_tools::per_element());
+    BOOST_TEST(!table.Find(3));
+    BOOST_TEST(!table.Remove(3));
+
+    BOOST_TEST(table.GetCount(Side::BUY) == 2u);
+    BOOST_TEST(table.GetVolumeAt(Side::BUY, 100) == 20u);
+    BOOST_TEST(table.GetRemainingVolume() == 20u);
+    BOOST_TEST(table.Insert(6, Side::BUY, 100, 10, Lifespan::GOOD_FOR_DAY) == &*(table.begin() + 2));
+}
+
+BOOST_AUTO_TEST_CASE(amends_and_order_statuses_keep_the_level_volumes)
+{
+    OrderTable table;
+    table.Insert(1, Side::SELL, 100, 10, Lifespan::GOOD_FOR_DAY);
+    table.Insert(2, Side::SELL, 100, 5, Lifespan::GOOD_FOR_DAY);
+    table.Insert(3, Side::BUY, 100, 7, Lifespan::GOOD_FOR_DAY);
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 15u);
+    BOOST_TEST(table.GetVolumeAt(Side::BUY, 100) == 7u);
+
+    // An amend can only reduce the volume
+    BOOST_TEST(table.Amend(1, 12));
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 15u);
+    BOOST_TEST(table.Amend(1, 4));
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 9u);
+    BOOST_TEST(table.Find(1)->mConfirmedVolume == 10u);
+
+    // A partial fill, confirming the amend
+    BOOST_TEST(table.ApplyStatus(1, 2, 2));
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 7u);
+    BOOST_TEST((table.Find(1)->mState == OrderState::LIVE));
+    BOOST_TEST(table.Find(1)->mVolume == 4u);
+    BOOST_TEST(table.Find(1)->mConfirmedVolume == 2u);
+
+    // Amending to no more than has been filled leaves nothing, but the order
+    // stays until the exchange says it has gone
+    BOOST_TEST(table.Amend(1, 1));
+    BOOST_TEST((table.Find(1)->mState == OrderState::CANCELLING));
+    BOOST_TEST(table.Find(1)->mRemainingVolume == 0u);
+    BOOST_TEST(table.Find(1)->mVolume == 2u);
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 5u);
+    BOOST_TEST(table.HasOrderAt(Side::SELL, 100));
+    BOOST_TEST(table.GetRemainingVolume() == 12u);
+
+    BOOST_TEST(table.ApplyStatus(1, 2, 0));
+    BOOST_TEST(!table.Find(1));
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 5u);
+    BOOST_TEST(table.ApplyStatus(2, 5, 0));
+    BOOST_TEST(!table.HasOrderAt(Side::SELL, 100));
+    BOOST_TEST(table.GetVolumeAt(Side::SELL, 100) == 0u);
+    BOOST_TEST(table.GetVolumeAt(Side::BUY, 100) == 7u);
+    BOOST_TEST(table.GetRemainingVolume() == 7u);
+
+    BOOST_TEST(!table.Amend(1, 1));
+    BOOST_TEST(!table.ApplyStatus(1, 2, 0));
+}
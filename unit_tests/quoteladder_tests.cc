@@ -0,0 +1,251 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE quoteladder_tests
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/baseautotrader.h"
+#include "ready_trader_go/localbook.h"
+#include "ready_trader_go/ordertable.h"
+#include "ready_trader_go/quoteladder.h"
+#include "ready_trader_go/traderclock.h"
+
+#include "mockconnection.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+// A quote ladder over an order table, sending through an auto-trader logged
+// in over a mock connection. The simulated clock never moves, so the message
+// frequency limit only allows as many messages as the test sets it to.
+struct LadderFixture
+{
+    LadderFixture()
+    {
+        boost::log::core::get()->set_logging_enabled(false);
+
+        auto connection = std::make_unique<MockConnection>();
+        mConnection = connection.get();
+        mTrader.SetExecutionConnection(std::move(connection));
+        mTrader.SetMessageFrequencyLimit(1s, 100000);
+        mConnection->mSent.clear();
+    }
+
+    // Add an order the exchange has acknowledged
+    void AddLiveOrder(unsigned long clientOrderId,
+                      Side side,
+                      Price price,
+                      Volume volume,
+                      Volume filledVolume = 0,
+                      Lifespan lifespan = Lifespan::GOOD_FOR_DAY)
+    {
+        mOrders.Insert(clientOrderId, side, price, volume, lifespan);
+        mOrders.ApplyStatus(clientOrderId, filledVolume, volume - filledVolume);
+    }
+
+    // Return the messages sent since the last call
+    std::vector<std::string> TakeSent()
+    {
+        std::vector<std::string> sent;
+        sent.swap(mConnection->mSent);
+        return sent;
+    }
+
+    // The remaining volume of the orders at each price that the ladder
+    // manages, leaving out those being cancelled
+    std::map<unsigned long, unsigned long> GetQuotedVolumes(Side side) const
+    {
+        std::map<unsigned long, unsigned long> volumes;
+        for (const auto& order : mOrders)
+        {
+            if (order.mSide == side && order.mState != OrderState::CANCELLING
+                && order.mLifespan == Lifespan::GOOD_FOR_DAY && order.mRemainingVolume != 0)
+            {
+                volumes[order.mPrice] += order.mRemainingVolume;
+            }
+        }
+        return volumes;
+    }
+
+    SimulatedClock mClock;
+    boost::asio::io_context mContext;
+    BaseAutoTrader mTrader{mContext};
+    MockConnection* mConnection;
+    OrderTable mOrders{100};
+    QuoteLadder mLadder{mOrders};
+    unsigned long mNextClientOrderId = 10;
+};
+
+BOOST_FIXTURE_TEST_SUITE(quote_ladder, LadderFixture)
+
+BOOST_AUTO_TEST_CASE(surplus_volume_is_taken_from_the_newest_orders_first)
+{
+    AddLiveOrder(1, Side::SELL, 100, 10);
+    AddLiveOrder(2, Side::SELL, 100, 10, 4);
+    AddLiveOrder(3, Side::SELL, 100, 10);
+
+    // 26 lots are live; order 3 is cancelled and order 2, which has had 4 of
+    // its 10 lots filled, is amended down to leave 3, so that order 1 keeps
+    // its place in the queue
+    mLadder.Diff(Side::SELL, {{100, 13}});
+    BOOST_TEST(mLadder.Apply(mTrader, mNextClientOrderId) == 2u);
+    const std::vector<std::string> expected{"0s cancel 3", "0s amend 2 7"};
+    BOOST_TEST(TakeSent() == expected, boost::test_tools::per_element());
+
+    BOOST_TEST((mOrders.Find(3)->mState == OrderState::CANCELLING));
+    BOOST_TEST(mOrders.Find(2)->mVolume == 7u);
+    BOOST_TEST(mOrders.Find(2)->mRemainingVolume == 3u);
+    BOOST_TEST(mOrders.Find(1)->mRemainingVolume == 10u);
+    BOOST_TEST(GetQuotedVolumes(Side::SELL)[100] == 13u);
+    BOOST_TEST(mNextClientOrderId == 10u);
+
+    // Nothing more to do
+    mLadder.Diff(Side::SELL, {{100, 13}});
+    BOOST_TEST(mLadder.GetActions().empty());
+}
+
+BOOST_AUTO_TEST_CASE(a_shortfall_is_made_up_with_a_single_insert)
+{
+    AddLiveOrder(1, Side::BUY, 100, 10);
+    AddLiveOrder(2, Side::BUY, 100, 5);
+    AddLiveOrder(3, Side::BUY, 99, 5);
+    AddLiveOrder(4, Side::BUY, 98, 5, 0, Lifespan::FILL_AND_KILL);
+    AddLiveOrder(5, Side::BUY, 98, 5);
+    mOrders.MarkCancelling(5);
+
+    // Order 3 is at a price that isn't wanted; the fill-and-kill order and
+    // the order already being cancelled are left alone. Cancels are sent
+    // before inserts, and quotes for no volume are ignored.
+    mLadder.Diff(Side::BUY, {{101, 5}, {100, 25}, {97, 0}});
+    BOOST_TEST(mLadder.GetActions().size() == 3u);
+    BOOST_TEST(mLadder.Apply(mTrader, mNextClientOrderId) == 3u);
+    const std::vector<std::string> expected{"0s cancel 3", "0s insert 10 10", "0s insert 11 5"};
+    BOOST_TEST(TakeSent() == expected, boost::test_tools::per_element());
+
+    BOOST_TEST(mNextClientOrderId == 12u);
+    BOOST_TEST(mOrders.Find(10)->mPrice == 100u);
+    BOOST_TEST(mOrders.Find(11)->mPrice == 101u);
+    const std::map<unsigned long, unsigned long> quoted{{100, 25}, {101, 5}};
+    BOOST_TEST((GetQuotedVolumes(Side::BUY) == quoted));
+}
+
+BOOST_AUTO_TEST_CASE(apply_stops_at_the_first_message_that_is_refused)
+{
+    AddLiveOrder(1, Side::SELL, 100, 10);
+    AddLiveOrder(2, Side::SELL, 101, 10);
+    AddLiveOrder(3, Side::SELL, 102, 10);
+    mTrader.SetMessageFrequencyLimit(1s, 2);
+
+    mLadder.Diff(Side::SELL, {{103, 10}});
+    BOOST_TEST(mLadder.Apply(mTrader, mNextClientOrderId) == 2u);
+    const std::vector<std::string> expected{"0s cancel 1", "0s cancel 2"};
+    BOOST_TEST(TakeSent() == expected, boost::test_tools::per_element());
+
+    // What wasn't sent isn't recorded, and is dropped from the ladder
+    BOOST_TEST((mOrders.Find(3)->mState == OrderState::LIVE));
+    BOOST_TEST(!mOrders.HasOrderAt(Side::SELL, 103));
+    BOOST_TEST(mNextClientOrderId == 10u);
+    BOOST_TEST(mLadder.GetActions().empty());
+}
+
+BOOST_AUTO_TEST_CASE(inserts_and_amends_are_tracked_in_the_local_book)
+{
+    LocalBook book;
+    QuoteLadder ladder(mOrders, nullptr, &book);
+    const std::array<Price, TOP_LEVEL_COUNT> asks{100, 200, 300, 400, 500};
+    const std::array<Price, TOP_LEVEL_COUNT> bids{};
+    std::array<Volume, TOP_LEVEL_COUNT> volumes{30, 10, 10, 10, 10};
+    book.ApplyOrderBook(1, asks, volumes, bids, {});
+
+    ladder.Diff(Side::SELL, {{100, 10}});
+    BOOST_TEST(ladder.Apply(mTrader, mNextClientOrderId) == 1u);
+    BOOST_TEST(book.GetVolumeAhead(10) == 30u);
+
+    // Once the order is amended down to 4 lots, 20 of the 24 on the level
+    // are others'
+    ladder.Diff(Side::SELL, {{100, 4}});
+    BOOST_TEST(ladder.Apply(mTrader, mNextClientOrderId) == 1u);
+    volumes[0] = 24;
+    book.ApplyOrderBook(2, asks, volumes, bids, {});
+    BOOST_TEST(book.GetVolumeAhead(10) == 20u);
+}
+
+BOOST_AUTO_TEST_CASE(a_random_walk_of_quotes_is_always_matched)
+{
+    std::mt19937 random(7);
+    auto upTo = [&random](unsigned long n) { return std::uniform_int_distribution<unsigned long>(0, n)(random); };
+    unsigned long mid = 1000;
+
+    for (int step = 0; step < 2000; ++step)
+    {
+        mid = mid + upTo(4) - 2;
+        std::vector<Quote> asks, bids;
+        for (unsigned long level = 1; level <= 3; ++level)
+        {
+            asks.push_back({mid + level, upTo(20)});
+            bids.push_back({mid - level, upTo(20)});
+        }
+
+        mLadder.Diff(Side::SELL, asks);
+        mLadder.Diff(Side::BUY, bids);
+        const std::size_t actionCount = mLadder.GetActions().size();
+        BOOST_REQUIRE(mLadder.Apply(mTrader, mNextClientOrderId) == actionCount);
+
+        for (const auto& [side, quotes] : {std::make_pair(Side::SELL, asks), std::make_pair(Side::BUY, bids)})
+        {
+            std::map<unsigned long, unsigned long> expected;
+            for (const auto& quote : quotes)
+            {
+                if (quote.mVolume != 0)
+                {
+                    expected[quote.mPrice] = quote.mVolume;
+                }
+            }
+            BOOST_REQUIRE_MESSAGE(GetQuotedVolumes(side) == expected, "step " << step << ": " << side);
+        }
+
+        // The exchange acknowledges everything, confirms the cancels and
+        // fills some of the orders
+        std::vector<LiveOrder> orders(mOrders.begin(), mOrders.end());
+        for (const auto& order : orders)
+        {
+            unsigned long remaining = order.mRemainingVolume;
+            if (order.mState == OrderState::CANCELLING)
+            {
+                remaining = 0;
+            }
+            else if (upTo(2) == 0)
+            {
+                remaining -= upTo(remaining);
+            }
+            mOrders.ApplyStatus(order.mClientOrderId, order.mVolume - remaining, remaining);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,412 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_UNIT_TESTS_REFERENCEORDERBOOK_H
+#define CPPREADY_TRADER_GO_UNIT_TESTS_REFERENCEORDERBOOK_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <map>
+#include <utility>
+
+#include <matching_engine/matchingbook.h>
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// The map-based order book the backtest used before MatchingBook: a
+// straight port of the exchange's ReferenceOrderBook (ready_trader_go/order_book.py),
+// fees and rounding included, kept as the reference MatchingBook is tested
+// and benchmarked against. It uses MatchingBook's Order and IOrderListener,
+// but not the orders' queue links.
+//
+// The book refers to orders but doesn't own them. A cancelled order stays
+// in its level's queue, with no remaining volume, until matching reaches it
+// or the level empties, so an order must outlive the book or its level.
+class ReferenceOrderBook
+{
+public:
+    ReferenceOrderBook(Instrument instrument, double makerFee, double takerFee);
+
+    ReferenceOrderBook(const ReferenceOrderBook&) = delete;
+    ReferenceOrderBook& operator=(const ReferenceOrderBook&) = delete;
+
+    // Decrease an order's volume, though not below the volume already filled
+    void Amend(double now, Order& order, unsigned long newVolume);
+    void Cancel(double now, Order& order);
+    // Match a new order and place what's left of it, unless it's fill-and-kill
+    void Insert(double now, Order& order);
+
+    // Zero if there are no orders on that side
+    unsigned long GetBestAsk() const noexcept { return mAsks.empty() ? 0 : mAsks.begin()->first; }
+    unsigned long GetBestBid() const noexcept { return mBids.empty() ? 0 : mBids.begin()->first; }
+    Instrument GetInstrument() const noexcept { return mInstrument; }
+    // Zero if nothing has traded yet
+    unsigned long GetLastTradedPrice() const noexcept { return mLastTradedPrice; }
+    // Zero unless there are orders on both sides
+    double GetMidpointPrice() const noexcept;
+
+    void TopLevels(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                   std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                   std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                   std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes) const;
+
+    // Return true, and fill in the volume traded at each price since the last
+    // call, if anything has traded
+    bool TradeTicks(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                    std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                    std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                    std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes);
+
+    // Return the volume that would trade, and its average price per lot
+    // (rounded down), for the given order without changing the book
+    std::pair<unsigned long, unsigned long> TryTrade(Side side, unsigned long limitPrice, unsigned long volume) const;
+
+    // Called after each level an order trades with
+    std::function<void(ReferenceOrderBook&)> TradeOccurred;
+
+private:
+    struct Level
+    {
+        std::deque<Order*> mOrders;
+        unsigned long mTotalVolume = 0;
+    };
+
+    template<typename Levels>
+    void Place(Levels& levels, Order& order);
+    void RemoveVolumeFromLevel(unsigned long price, unsigned long volume, Side side);
+    template<typename Levels>
+    void Trade(double now, Order& order, Levels& levels);
+    void TradeLevel(double now, Order& order, unsigned long price, Level& level);
+
+    Instrument mInstrument;
+    double mMakerFee;
+    double mTakerFee;
+
+    std::map<unsigned long, Level> mAsks;
+    std::map<unsigned long, Level, std::greater<unsigned long>> mBids;
+    std::map<unsigned long, unsigned long> mAskTicks;
+    std::map<unsigned long, unsigned long, std::greater<unsigned long>> mBidTicks;
+    unsigned long mLastTradedPrice = 0;
+};
+
+inline double ReferenceOrderBook::GetMidpointPrice() const noexcept
+{
+    if (mAsks.empty() || mBids.empty())
+    {
+        return 0.0;
+    }
+    return static_cast<double>(mBids.begin()->first + mAsks.begin()->first) / 2.0;
+}
+
+// Fees are rounded half to even, like Python's round
+inline long roundReferenceFee(unsigned long price, unsigned long volume, double rate)
+{
+    return std::lrint(static_cast<double>(price * volume) * rate);
+}
+
+template<typename Ticks>
+inline void copyReferenceTicks(const Ticks& ticks,
+                               std::array<Price, TOP_LEVEL_COUNT>& prices,
+                               std::array<Volume, TOP_LEVEL_COUNT>& volumes)
+{
+    std::size_t i = 0;
+    for (auto it = ticks.begin(); i < TOP_LEVEL_COUNT && it != ticks.end(); ++i, ++it)
+    {
+        prices[i] = it->first;
+        volumes[i] = it->second;
+    }
+    for (; i < TOP_LEVEL_COUNT; ++i)
+    {
+        prices[i] = 0;
+        volumes[i] = 0;
+    }
+}
+
+inline ReferenceOrderBook::ReferenceOrderBook(Instrument instrument, double makerFee, double takerFee)
+    : mInstrument(instrument), mMakerFee(makerFee), mTakerFee(takerFee)
+{
+}
+
+inline void ReferenceOrderBook::Amend(double now, Order& order, unsigned long newVolume)
+{
+    if (order.mRemainingVolume == 0)
+    {
+        return;
+    }
+
+    const unsigned long fillVolume = order.mVolume - order.mRemainingVolume;
+    const unsigned long diff = order.mVolume - std::min(std::max(newVolume, fillVolume), order.mVolume);
+    RemoveVolumeFromLevel(order.mPrice, diff, order.mSide);
+    order.mVolume -= diff;
+    order.mRemainingVolume -= diff;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderAmended(now, order, diff);
+    }
+}
+
+inline void ReferenceOrderBook::Cancel(double now, Order& order)
+{
+    if (order.mRemainingVolume == 0)
+    {
+        return;
+    }
+
+    RemoveVolumeFromLevel(order.mPrice, order.mRemainingVolume, order.mSide);
+    const unsigned long remaining = order.mRemainingVolume;
+    order.mRemainingVolume = 0;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderCancelled(now, order, remaining);
+    }
+}
+
+inline void ReferenceOrderBook::Insert(double now, Order& order)
+{
+    if (order.mSide == Side::SELL && !mBids.empty() && order.mPrice <= mBids.begin()->first)
+    {
+        Trade(now, order, mBids);
+    }
+    else if (order.mSide == Side::BUY && !mAsks.empty() && order.mPrice >= mAsks.begin()->first)
+    {
+        Trade(now, order, mAsks);
+    }
+
+    if (order.mRemainingVolume == 0)
+    {
+        return;
+    }
+
+    if (order.mLifespan == Lifespan::FILL_AND_KILL)
+    {
+        const unsigned long remaining = order.mRemainingVolume;
+        order.mRemainingVolume = 0;
+        if (order.mListener)
+        {
+            order.mListener->OnOrderCancelled(now, order, remaining);
+        }
+    }
+    else if (order.mSide == Side::SELL)
+    {
+        Place(mAsks, order);
+        if (order.mListener)
+        {
+            order.mListener->OnOrderPlaced(now, order);
+        }
+    }
+    else
+    {
+        Place(mBids, order);
+        if (order.mListener)
+        {
+            order.mListener->OnOrderPlaced(now, order);
+        }
+    }
+}
+
+template<typename Levels>
+inline void ReferenceOrderBook::Place(Levels& levels, Order& order)
+{
+    Level& level = levels[order.mPrice];
+    level.mOrders.push_back(&order);
+    level.mTotalVolume += order.mRemainingVolume;
+}
+
+inline void ReferenceOrderBook::RemoveVolumeFromLevel(unsigned long price, unsigned long volume, Side side)
+{
+    auto remove = [price, volume](auto& levels) {
+        auto it = levels.find(price);
+        if (it == levels.end())
+        {
+            return;
+        }
+        if (it->second.mTotalVolume == volume)
+        {
+            levels.erase(it);
+        }
+        else
+        {
+            it->second.mTotalVolume -= volume;
+        }
+    };
+
+    if (side == Side::SELL)
+    {
+        remove(mAsks);
+    }
+    else
+    {
+        remove(mBids);
+    }
+}
+
+inline void ReferenceOrderBook::TopLevels(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                          std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                          std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                          std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes) const
+{
+    std::size_t i = 0;
+    for (auto it = mAsks.begin(); i < TOP_LEVEL_COUNT && it != mAsks.end(); ++i, ++it)
+    {
+        askPrices[i] = it->first;
+        askVolumes[i] = it->second.mTotalVolume;
+    }
+    for (; i < TOP_LEVEL_COUNT; ++i)
+    {
+        askPrices[i] = 0;
+        askVolumes[i] = 0;
+    }
+
+    i = 0;
+    for (auto it = mBids.begin(); i < TOP_LEVEL_COUNT && it != mBids.end(); ++i, ++it)
+    {
+        bidPrices[i] = it->first;
+        bidVolumes[i] = it->second.mTotalVolume;
+    }
+    for (; i < TOP_LEVEL_COUNT; ++i)
+    {
+        bidPrices[i] = 0;
+        bidVolumes[i] = 0;
+    }
+}
+
+template<typename Levels>
+inline void ReferenceOrderBook::Trade(double now, Order& order, Levels& levels)
+{
+    auto it = levels.begin();
+    while (order.mRemainingVolume > 0
+           && ((order.mSide == Side::BUY) ? it->first <= order.mPrice : it->first >= order.mPrice)
+           && it->second.mTotalVolume > 0)
+    {
+        TradeLevel(now, order, it->first, it->second);
+        if (it->second.mTotalVolume == 0)
+        {
+            it = levels.erase(it);
+            if (it == levels.end())
+            {
+                break;
+            }
+        }
+    }
+}
+
+inline void ReferenceOrderBook::TradeLevel(double now, Order& order, unsigned long price, Level& level)
+{
+    unsigned long remaining = order.mRemainingVolume;
+    unsigned long totalVolume = level.mTotalVolume;
+
+    while (remaining > 0 && totalVolume > 0)
+    {
+        while (level.mOrders.front()->mRemainingVolume == 0)
+        {
+            level.mOrders.pop_front();
+        }
+        Order& passive = *level.mOrders.front();
+        const unsigned long volume = std::min(remaining, passive.mRemainingVolume);
+        const long fee = roundReferenceFee(price, volume, mMakerFee);
+        totalVolume -= volume;
+        remaining -= volume;
+        passive.mRemainingVolume -= volume;
+        passive.mTotalFees += fee;
+        if (passive.mListener)
+        {
+            passive.mListener->OnOrderFilled(now, passive, price, volume, fee);
+        }
+    }
+
+    level.mTotalVolume = totalVolume;
+    const unsigned long tradedVolume = order.mRemainingVolume - remaining;
+
+    if (order.mSide == Side::BUY)
+    {
+        mAskTicks[price] += tradedVolume;
+    }
+    else
+    {
+        mBidTicks[price] += tradedVolume;
+    }
+
+    const long fee = roundReferenceFee(price, tradedVolume, mTakerFee);
+    order.mRemainingVolume = remaining;
+    order.mTotalFees += fee;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderFilled(now, order, price, tradedVolume, fee);
+    }
+
+    mLastTradedPrice = price;
+    if (TradeOccurred)
+    {
+        TradeOccurred(*this);
+    }
+}
+
+inline bool ReferenceOrderBook::TradeTicks(std::array<Price, TOP_LEVEL_COUNT>& askPrices,
+                                           std::array<Volume, TOP_LEVEL_COUNT>& askVolumes,
+                                           std::array<Price, TOP_LEVEL_COUNT>& bidPrices,
+                                           std::array<Volume, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    if (mAskTicks.empty() && mBidTicks.empty())
+    {
+        return false;
+    }
+
+    copyReferenceTicks(mAskTicks, askPrices, askVolumes);
+    copyReferenceTicks(mBidTicks, bidPrices, bidVolumes);
+    mAskTicks.clear();
+    mBidTicks.clear();
+    return true;
+}
+
+inline std::pair<unsigned long, unsigned long> ReferenceOrderBook::TryTrade(Side side,
+                                                                            unsigned long limitPrice,
+                                                                            unsigned long volume) const
+{
+    unsigned long totalVolume = 0;
+    unsigned long totalValue = 0;
+
+    auto accumulate = [&](unsigned long price, const Level& level) {
+        const unsigned long weight = std::min(volume - totalVolume, level.mTotalVolume);
+        totalVolume += weight;
+        totalValue += weight * price;
+    };
+
+    if (side == Side::SELL)
+    {
+        for (auto it = mBids.begin(); totalVolume < volume && it != mBids.end() && it->first >= limitPrice; ++it)
+        {
+            accumulate(it->first, it->second);
+        }
+    }
+    else
+    {
+        for (auto it = mAsks.begin(); totalVolume < volume && it != mAsks.end() && it->first <= limitPrice; ++it)
+        {
+            accumulate(it->first, it->second);
+        }
+    }
+
+    return {totalVolume, (totalVolume > 0) ? totalValue / totalVolume : 0};
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_UNIT_TESTS_REFERENCEORDERBOOK_H
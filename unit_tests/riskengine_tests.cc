@@ -0,0 +1,407 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE riskengine_tests
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <random>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/riskengine.h"
+
+using namespace ReadyTraderGo;
+
+BOOST_AUTO_TEST_CASE(clip_insert_stops_at_the_active_order_count_limit)
+{
+    RiskEngine engine(2, 200, 100);
+    engine.OnInsert(Side::BUY, 1);
+    BOOST_TEST(engine.ClipInsert(Side::SELL, 5) == 5u);
+    engine.OnInsert(Side::SELL, 1);
+    BOOST_TEST(engine.ClipInsert(Side::SELL, 5) == 0u);
+    BOOST_TEST(engine.ClipInsert(Side::BUY, 5) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(clip_insert_stops_at_the_active_volume_limit)
+{
+    RiskEngine engine(10, 50, 100);
+    engine.OnInsert(Side::BUY, 30);
+    BOOST_TEST(engine.ClipInsert(Side::SELL, 30) == 20u);
+    engine.OnInsert(Side::SELL, 20);
+    BOOST_TEST(engine.ClipInsert(Side::BUY, 1) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(clip_insert_counts_active_orders_as_filled)
+{
+    RiskEngine engine(10, 1000, 100);
+    engine.OnOrderFilled(Side::BUY, 40);
+    BOOST_TEST(engine.ClipInsert(Side::BUY, 100) == 60u);
+    BOOST_TEST(engine.ClipInsert(Side::SELL, 200) == 140u);
+
+    // Active orders only count against their own side.
+    engine.OnInsert(Side::BUY, 50);
+    BOOST_TEST(engine.ClipInsert(Side::BUY, 100) == 10u);
+    BOOST_TEST(engine.ClipInsert(Side::SELL, 200) == 140u);
+    engine.OnInsert(Side::BUY, 10);
+    BOOST_TEST(engine.ClipInsert(Side::BUY, 1) == 0u);
+
+    // Position room ignores the active orders.
+    BOOST_TEST(engine.GetPositionRoom(Side::BUY) == 60);
+    BOOST_TEST(engine.GetPositionRoom(Side::SELL) == 140);
+}
+
+BOOST_AUTO_TEST_CASE(clip_hedge_counts_pending_hedges_as_filled)
+{
+    RiskEngine engine(10, 200, 100);
+    engine.OnHedgeFilled(Side::SELL, 0, 70);
+    BOOST_TEST(engine.GetFuturePosition() == -70);
+    BOOST_TEST(engine.ClipHedge(Side::SELL, 50) == 30u);
+    BOOST_TEST(engine.ClipHedge(Side::BUY, 500) == 170u);
+
+    engine.OnHedge(Side::SELL, 30);
+    BOOST_TEST(engine.GetPendingHedgeVolume(Side::SELL) == 30u);
+    BOOST_TEST(engine.ClipHedge(Side::SELL, 1) == 0u);
+
+    // A hedge that falls short frees the rest of its volume.
+    engine.OnHedgeFilled(Side::SELL, 30, 10);
+    BOOST_TEST(engine.GetPendingHedgeVolume(Side::SELL) == 0u);
+    BOOST_TEST(engine.GetFuturePosition() == -80);
+    BOOST_TEST(engine.ClipHedge(Side::SELL, 50) == 20u);
+}
+
+BOOST_AUTO_TEST_CASE(order_status_releases_volume_until_the_order_is_gone)
+{
+    RiskEngine engine(10, 200, 100);
+    engine.OnInsert(Side::SELL, 30);
+    BOOST_TEST(engine.GetActiveOrderCount() == 1u);
+    BOOST_TEST(engine.GetActiveVolume(Side::SELL) == 30u);
+
+    // A partial fill.
+    engine.OnOrderFilled(Side::SELL, 10);
+    engine.OnOrderStatus(Side::SELL, 30, 20);
+    BOOST_TEST(engine.GetActiveOrderCount() == 1u);
+    BOOST_TEST(engine.GetActiveVolume(Side::SELL) == 20u);
+    BOOST_TEST(engine.GetEtfPosition() == -10);
+
+    // A status that doesn't reduce the remaining volume changes nothing.
+    engine.OnOrderStatus(Side::SELL, 20, 20);
+    BOOST_TEST(engine.GetActiveVolume(Side::SELL) == 20u);
+
+    // An amend down, then a cancel.
+    engine.OnOrderStatus(Side::SELL, 20, 5);
+    BOOST_TEST(engine.GetActiveVolume(Side::SELL) == 5u);
+    engine.OnOrderStatus(Side::SELL, 5, 0);
+    BOOST_TEST(engine.GetActiveOrderCount() == 0u);
+    BOOST_TEST(engine.GetActiveVolume() == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(excess_unhedged_lots_are_beyond_the_limit)
+{
+    RiskEngine engine;
+    engine.OnOrderFilled(Side::BUY, 25);
+    engine.OnHedgeFilled(Side::SELL, 0, 12);
+    BOOST_TEST(engine.GetUnhedgedLots() == 13);
+    BOOST_TEST(engine.GetExcessUnhedgedLots() == 3);
+    engine.OnHedgeFilled(Side::SELL, 0, 30);
+    BOOST_TEST(engine.GetExcessUnhedgedLots() == -7);
+    BOOST_TEST(excessUnhedgedLots(UNHEDGED_LOTS_LIMIT) == 0);
+    BOOST_TEST(excessUnhedgedLots(-UNHEDGED_LOTS_LIMIT) == 0);
+}
+
+// An auto-trader sending random inserts, amends, cancels and hedges to an
+// exchange which fills its orders at random, with every message delayed by a
+// random amount (but delivered in order). The exchange makes the same checks
+// as the real one: it rejects an order that would breach the active order
+// count or volume limits, and notes a breach whenever a fill leaves a
+// position beyond the position limit.
+class DelayedMessageSimulation
+{
+public:
+    struct Outcome
+    {
+        unsigned long mInserts = 0;
+        unsigned long mRejects = 0;
+        unsigned long mBreaches = 0;
+    };
+
+    // With 'useEngine' false, inserts are clipped on the position alone, as
+    // a check that the simulation can find breaches at all.
+    DelayedMessageSimulation(unsigned seed, bool useEngine) : mRandom(seed), mUseEngine(useEngine) {}
+
+    Outcome Run(int steps)
+    {
+        for (int step = 0; step < steps; ++step)
+        {
+            mNow += std::exponential_distribution<double>(1.0)(mRandom);
+            Deliver(mNow);
+            Act();
+            Fill();
+        }
+        Deliver(mNow + 1e9);
+
+        // Once everything has arrived, the engine must agree with the
+        // exchange.
+        unsigned long activeVolumes[2] = {0, 0};
+        for (const auto& [id, order] : mExchangeOrders)
+        {
+            activeVolumes[static_cast<int>(order.mSide)] += order.mRemainingVolume;
+        }
+        BOOST_TEST(mEngine.GetActiveOrderCount() == mExchangeOrders.size());
+        BOOST_TEST(mEngine.GetActiveVolume(Side::SELL) == activeVolumes[0]);
+        BOOST_TEST(mEngine.GetActiveVolume(Side::BUY) == activeVolumes[1]);
+        BOOST_TEST(mEngine.GetEtfPosition() == mExchangeEtfPosition);
+        BOOST_TEST(mEngine.GetFuturePosition() == mExchangeFuturePosition);
+        BOOST_TEST(mEngine.GetPendingHedgeVolume(Side::BUY) == 0u);
+        BOOST_TEST(mEngine.GetPendingHedgeVolume(Side::SELL) == 0u);
+        return mOutcome;
+    }
+
+private:
+    struct ExchangeOrder
+    {
+        Side mSide;
+        unsigned long mVolume;
+        unsigned long mRemainingVolume;
+    };
+
+    struct TraderOrder
+    {
+        Side mSide;
+        Volume mConfirmedVolume;
+        bool mIsCancelling = false;
+    };
+
+    static long signedVolume(Side side, unsigned long volume)
+    {
+        return (side == Side::BUY) ? static_cast<long>(volume) : -static_cast<long>(volume);
+    }
+
+    // Messages in each direction arrive in the order they were sent.
+    void ToExchange(std::function<void()> message)
+    {
+        mToExchangeTime = std::max(mToExchangeTime, mNow + Delay());
+        mEvents.emplace(mToExchangeTime, std::move(message));
+    }
+
+    void ToTrader(std::function<void()> message)
+    {
+        mToTraderTime = std::max(mToTraderTime, mNow + Delay());
+        mEvents.emplace(mToTraderTime, std::move(message));
+    }
+
+    double Delay()
+    {
+        return std::exponential_distribution<double>(0.2)(mRandom);
+    }
+
+    void Deliver(double until)
+    {
+        while (!mEvents.empty() && mEvents.begin()->first <= until)
+        {
+            auto message = std::move(mEvents.begin()->second);
+            mNow = std::max(mNow, mEvents.begin()->first);
+            mEvents.erase(mEvents.begin());
+            message();
+        }
+    }
+
+    // The auto-trader's side
+
+    void Act()
+    {
+        const unsigned action = mRandom() % 10;
+        if (action < 5)
+        {
+            Insert(static_cast<Side>(mRandom() % 2), 1 + mRandom() % 40);
+        }
+        else if (action < 7 && !mTraderOrders.empty())
+        {
+            auto order = std::next(mTraderOrders.begin(), mRandom() % mTraderOrders.size());
+            if (!order->second.mIsCancelling)
+            {
+                order->second.mIsCancelling = true;
+                const unsigned long id = order->first;
+                ToExchange([this, id]() { ExchangeAmend(id, 0); });
+            }
+        }
+        else if (action < 8 && !mTraderOrders.empty())
+        {
+            auto order = std::next(mTraderOrders.begin(), mRandom() % mTraderOrders.size());
+            const unsigned long id = order->first;
+            const unsigned long volume = mRandom() % (order->second.mConfirmedVolume + 1);
+            ToExchange([this, id, volume]() { ExchangeAmend(id, volume); });
+        }
+        else if (action < 9)
+        {
+            const long unhedged = mEngine.GetUnhedgedLots();
+            const Side side = (unhedged > 0) ? Side::SELL : Side::BUY;
+            const Volume volume = mEngine.ClipHedge(side, std::labs(unhedged));
+            if (volume != 0)
+            {
+                mEngine.OnHedge(side, volume);
+                ToExchange([this, side, volume]() { ExchangeHedge(side, volume); });
+            }
+        }
+    }
+
+    void Insert(Side side, unsigned long volume)
+    {
+        Volume clipped;
+        if (mUseEngine)
+        {
+            clipped = mEngine.ClipInsert(side, volume);
+        }
+        else
+        {
+            const long room = mEngine.GetPositionRoom(side);
+            clipped = (room <= 0) ? 0 : std::min<unsigned long>(volume, room);
+        }
+        if (clipped == 0)
+        {
+            return;
+        }
+
+        const unsigned long id = mNextOrderId++;
+        mTraderOrders.emplace(id, TraderOrder{side, clipped});
+        mEngine.OnInsert(side, clipped);
+        ++mOutcome.mInserts;
+        ToExchange([this, id, side, clipped]() { ExchangeInsert(id, side, clipped); });
+    }
+
+    void TraderOrderFilled(unsigned long id, unsigned long volume)
+    {
+        mEngine.OnOrderFilled(mTraderOrders.at(id).mSide, volume);
+    }
+
+    void TraderOrderStatus(unsigned long id, unsigned long remainingVolume)
+    {
+        auto order = mTraderOrders.find(id);
+        mEngine.OnOrderStatus(order->second.mSide, order->second.mConfirmedVolume, remainingVolume);
+        order->second.mConfirmedVolume = remainingVolume;
+        if (remainingVolume == 0)
+        {
+            mTraderOrders.erase(order);
+        }
+    }
+
+    // The exchange's side
+
+    void ExchangeInsert(unsigned long id, Side side, unsigned long volume)
+    {
+        if (mExchangeOrders.size() >= mEngine.GetActiveOrderCountLimit()
+            || mExchangeActiveVolume + volume > mEngine.GetActiveVolumeLimit())
+        {
+            ++mOutcome.mRejects;
+            ToTrader([this, id]() { TraderOrderStatus(id, 0); });
+            return;
+        }
+        mExchangeOrders.emplace(id, ExchangeOrder{side, volume, volume});
+        mExchangeActiveVolume += volume;
+    }
+
+    void ExchangeAmend(unsigned long id, unsigned long newVolume)
+    {
+        auto order = mExchangeOrders.find(id);
+        if (order == mExchangeOrders.end() || newVolume >= order->second.mVolume)
+        {
+            return;
+        }
+        const unsigned long filled = order->second.mVolume - order->second.mRemainingVolume;
+        const unsigned long remaining = (newVolume > filled) ? newVolume - filled : 0;
+        mExchangeActiveVolume -= order->second.mRemainingVolume - remaining;
+        order->second.mVolume = newVolume;
+        order->second.mRemainingVolume = remaining;
+        if (remaining == 0)
+        {
+            mExchangeOrders.erase(order);
+        }
+        ToTrader([this, id, remaining]() { TraderOrderStatus(id, remaining); });
+    }
+
+    void ExchangeHedge(Side side, Volume volume)
+    {
+        mExchangeFuturePosition += signedVolume(side, volume);
+        if (std::labs(mExchangeFuturePosition) > mEngine.GetPositionLimit())
+        {
+            ++mOutcome.mBreaches;
+        }
+        ToTrader([this, side, volume]() { mEngine.OnHedgeFilled(side, volume, volume); });
+    }
+
+    void Fill()
+    {
+        if (mExchangeOrders.empty() || mRandom() % 3 != 0)
+        {
+            return;
+        }
+        auto order = std::next(mExchangeOrders.begin(), mRandom() % mExchangeOrders.size());
+        const unsigned long id = order->first;
+        const unsigned long volume = 1 + mRandom() % order->second.mRemainingVolume;
+        order->second.mRemainingVolume -= volume;
+        mExchangeActiveVolume -= volume;
+        mExchangeEtfPosition += signedVolume(order->second.mSide, volume);
+        if (std::labs(mExchangeEtfPosition) > mEngine.GetPositionLimit())
+        {
+            ++mOutcome.mBreaches;
+        }
+
+        const unsigned long remaining = order->second.mRemainingVolume;
+        if (remaining == 0)
+        {
+            mExchangeOrders.erase(order);
+        }
+        ToTrader([this, id, volume]() { TraderOrderFilled(id, volume); });
+        ToTrader([this, id, remaining]() { TraderOrderStatus(id, remaining); });
+    }
+
+    std::mt19937 mRandom;
+    bool mUseEngine;
+    double mNow = 0.0;
+    double mToExchangeTime = 0.0;
+    double mToTraderTime = 0.0;
+    std::multimap<double, std::function<void()>> mEvents;
+    Outcome mOutcome;
+
+    RiskEngine mEngine;
+    std::map<unsigned long, TraderOrder> mTraderOrders;
+    unsigned long mNextOrderId = 1;
+
+    std::map<unsigned long, ExchangeOrder> mExchangeOrders;
+    unsigned long mExchangeActiveVolume = 0;
+    long mExchangeEtfPosition = 0;
+    long mExchangeFuturePosition = 0;
+};
+
+BOOST_AUTO_TEST_CASE(randomly_delayed_messages_never_lead_to_a_reject_or_breach)
+{
+    for (unsigned seed = 1; seed <= 5; ++seed)
+    {
+        const auto outcome = DelayedMessageSimulation(seed, true).Run(20000);
+        BOOST_TEST_MESSAGE("seed " << seed << ": " << outcome.mInserts << " inserts");
+        BOOST_TEST(outcome.mInserts > 1000u);
+        BOOST_TEST(outcome.mRejects == 0u);
+        BOOST_TEST(outcome.mBreaches == 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(clipping_on_position_alone_does_lead_to_rejects_and_breaches)
+{
+    const auto outcome = DelayedMessageSimulation(1, false).Run(20000);
+    BOOST_TEST(outcome.mRejects > 0u);
+    BOOST_TEST(outcome.mBreaches > 0u);
+}
@@ -0,0 +1,114 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE sequencetracker_tests
+#include <chrono>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/sequencetracker.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+constexpr TraderClock::time_point T0{std::chrono::hours(1)};
+
+BOOST_AUTO_TEST_CASE(gaps_and_late_messages_are_counted)
+{
+    SequenceTracker tracker;
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 5, T0));
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 6, T0));
+
+    // Two ticks missing, then one of them arriving late, and a repeat
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 9, T0));
+    BOOST_TEST(!tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 7, T0));
+    BOOST_TEST(!tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 9, T0));
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 11, T0));
+
+    const SequenceStats& stats = tracker.GetStats(Instrument::ETF, InformationType::ORDER_BOOK);
+    BOOST_TEST(stats.mLastSequenceNumber == 11u);
+    BOOST_TEST(stats.mMessageCount == 4u);
+    BOOST_TEST(stats.mGapCount == 2u);
+    BOOST_TEST(stats.mMissedMessageCount == 3u);
+    BOOST_TEST(stats.mOutOfOrderCount == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(each_instrument_and_message_type_has_its_own_sequence)
+{
+    SequenceTracker tracker;
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 10, T0));
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::TRADE_TICKS, 3, T0));
+    BOOST_TEST(tracker.Update(Instrument::FUTURE, InformationType::ORDER_BOOK, 1, T0));
+    BOOST_TEST(tracker.Update(Instrument::FUTURE, InformationType::TRADE_TICKS, 1, T0));
+
+    // The first message of each is neither a gap nor late, whatever its
+    // sequence number
+    for (Instrument instrument : {Instrument::FUTURE, Instrument::ETF})
+    {
+        for (InformationType type : {InformationType::ORDER_BOOK, InformationType::TRADE_TICKS})
+        {
+            const SequenceStats& stats = tracker.GetStats(instrument, type);
+            BOOST_TEST(stats.mMessageCount == 1u);
+            BOOST_TEST(stats.mGapCount == 0u);
+            BOOST_TEST(stats.mOutOfOrderCount == 0u);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(an_order_book_is_stale_once_it_is_too_old)
+{
+    SequenceTracker tracker;
+    tracker.SetStaleAfter(500ms);
+    BOOST_TEST(tracker.IsStale(Instrument::ETF, T0));
+
+    tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 1, T0);
+    BOOST_TEST(!tracker.IsStale(Instrument::ETF, T0 + 500ms));
+    BOOST_TEST(tracker.IsStale(Instrument::ETF, T0 + 501ms));
+
+    // Trade ticks don't keep an order book fresh
+    tracker.Update(Instrument::ETF, InformationType::TRADE_TICKS, 1, T0 + 400ms);
+    BOOST_TEST(tracker.IsStale(Instrument::ETF, T0 + 501ms));
+
+    // A late order book is dropped, so it doesn't either
+    BOOST_TEST(!tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 1, T0 + 400ms));
+    BOOST_TEST(tracker.IsStale(Instrument::ETF, T0 + 501ms));
+
+    BOOST_TEST(tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 2, T0 + 501ms));
+    BOOST_TEST(!tracker.IsStale(Instrument::ETF, T0 + 501ms));
+}
+
+BOOST_AUTO_TEST_CASE(an_order_book_older_than_the_other_instruments_is_stale)
+{
+    SequenceTracker tracker;
+    tracker.Update(Instrument::FUTURE, InformationType::ORDER_BOOK, 1, T0);
+    tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 1, T0);
+    BOOST_TEST(!tracker.IsStale(Instrument::FUTURE, T0));
+    BOOST_TEST(!tracker.IsStale(Instrument::ETF, T0));
+
+    // The ETF's book for tick 2 is missed: until the next tick arrives for
+    // both, the ETF is stale however recent its book is
+    tracker.Update(Instrument::FUTURE, InformationType::ORDER_BOOK, 2, T0 + 250ms);
+    BOOST_TEST(!tracker.IsStale(Instrument::FUTURE, T0 + 250ms));
+    BOOST_TEST(tracker.IsStale(Instrument::ETF, T0 + 250ms));
+
+    tracker.Update(Instrument::ETF, InformationType::ORDER_BOOK, 3, T0 + 500ms);
+    BOOST_TEST(tracker.IsStale(Instrument::FUTURE, T0 + 500ms));
+    BOOST_TEST(!tracker.IsStale(Instrument::ETF, T0 + 500ms));
+    tracker.Update(Instrument::FUTURE, InformationType::ORDER_BOOK, 3, T0 + 500ms);
+    BOOST_TEST(!tracker.IsStale(Instrument::FUTURE, T0 + 500ms));
+    BOOST_TEST(tracker.GetStats(Instrument::ETF, InformationType::ORDER_BOOK).mMissedMessageCount == 1u);
+}
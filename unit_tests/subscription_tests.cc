@@ -0,0 +1,214 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE subscription_tests
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/log/core.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/connectivity.h"
+
+#include <unistd.h>
+
+using namespace ReadyTraderGo;
+
+namespace interprocess = boost::interprocess;
+
+// Writes frames the way pubsub.py does, with or without the generation the
+// stock publisher leaves at zero.
+class TestPublisher
+{
+public:
+    TestPublisher(unsigned char* buffer, bool writeGenerations)
+        : mBuffer(buffer), mWriteGenerations(writeGenerations)
+    {
+    }
+
+    void Publish(uint32_t value)
+    {
+        // Each payload is a message with a four-byte body holding the value.
+        constexpr uint16_t messageSize = MESSAGE_HEADER_SIZE + sizeof(uint32_t);
+        unsigned char* frame = mBuffer + mPosition;
+        *(uint32_t*)(frame + FRAME_PAYLOAD_SIZE_OFFSET) = boost::endian::native_to_big(uint32_t{messageSize});
+        *(uint16_t*)(frame + FRAME_HEADER_SIZE) = boost::endian::native_to_big(messageSize);
+        frame[FRAME_HEADER_SIZE + MESSAGE_TYPE_OFFSET] = 1;
+        *(uint32_t*)(frame + FRAME_HEADER_SIZE + MESSAGE_HEADER_SIZE) = value;
+        if (mWriteGenerations)
+        {
+            frame[1] = mGeneration & 0xFF;
+            frame[2] = (mGeneration >> 8) & 0xFF;
+            frame[3] = (mGeneration >> 16) & 0xFF;
+        }
+        mPosition = (mPosition + FRAME_SIZE) & (SUBSCRIPTION_TRANSPORT_BUFFER_SIZE - 1);
+        if (mPosition == 0)
+        {
+            mGeneration = (mGeneration + 1) & FRAME_GENERATION_MASK;
+        }
+        mBuffer[mPosition] = 0;
+        frame[0] = 1;
+    }
+
+private:
+    unsigned char* mBuffer;
+    bool mWriteGenerations;
+    std::size_t mPosition = 0;
+    uint32_t mGeneration = 0;
+};
+
+struct SubscriptionFixture
+{
+    explicit SubscriptionFixture(bool writeGenerations = true)
+        : mFileName((std::filesystem::temp_directory_path()
+                     / ("rtg_subscription_test_" + std::to_string(::getpid()))).string())
+    {
+        boost::log::core::get()->set_logging_enabled(false);
+        std::ofstream(mFileName, std::ios::binary) << std::string(SUBSCRIPTION_TRANSPORT_BUFFER_SIZE, '\0');
+        mFile = interprocess::file_mapping(mFileName.c_str(), interprocess::read_write);
+        mRegion = interprocess::mapped_region(mFile, interprocess::read_write);
+        mPublisher = std::make_unique<TestPublisher>(static_cast<unsigned char*>(mRegion.get_address()),
+                                                     writeGenerations);
+    }
+
+    ~SubscriptionFixture()
+    {
+        mSubscription.reset();
+        std::filesystem::remove(mFileName);
+    }
+
+    void Subscribe()
+    {
+        interprocess::file_mapping file{mFileName.c_str(), interprocess::read_only};
+        interprocess::mapped_region region{file, interprocess::read_only};
+        mSubscription = std::make_shared<Subscription>(mContext, file, region);
+        mSubscription->GapDetected = [this](auto*, unsigned long missedFrames) { mGaps.push_back(missedFrames); };
+        mSubscription->MessageReceived = [this](auto*, unsigned char, unsigned char const* data, std::size_t) {
+            mReceived.push_back(*(uint32_t const*)data);
+        };
+        mSubscription->AsyncReceive();
+    }
+
+    // Each poll checks for (at most) one frame.
+    void Poll(std::size_t count = 2 * FRAME_COUNT)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            mContext.poll_one();
+        }
+    }
+
+    void Publish(uint32_t first, uint32_t last)
+    {
+        for (uint32_t value = first; value < last; ++value)
+        {
+            mPublisher->Publish(value);
+        }
+    }
+
+    static std::vector<uint32_t> Range(uint32_t first, uint32_t last)
+    {
+        std::vector<uint32_t> result;
+        for (uint32_t value = first; value < last; ++value)
+        {
+            result.push_back(value);
+        }
+        return result;
+    }
+
+    boost::asio::io_context mContext;
+    std::string mFileName;
+    interprocess::file_mapping mFile;
+    interprocess::mapped_region mRegion;
+    std::unique_ptr<TestPublisher> mPublisher;
+    std::shared_ptr<Subscription> mSubscription;
+    std::vector<uint32_t> mReceived;
+    std::vector<unsigned long> mGaps;
+};
+
+struct StockPublisherFixture : SubscriptionFixture
+{
+    StockPublisherFixture() : SubscriptionFixture(false) {}
+};
+
+BOOST_FIXTURE_TEST_CASE(keeping_up_with_a_stock_publisher_reports_no_gaps, StockPublisherFixture)
+{
+    Subscribe();
+    for (uint32_t value = 0; value < 5 * FRAME_COUNT; ++value)
+    {
+        mPublisher->Publish(value);
+        Poll(1);
+    }
+    BOOST_TEST(mGaps.empty());
+    BOOST_TEST(mReceived == Range(0, 5 * FRAME_COUNT), boost::test_tools::per_element());
+}
+
+BOOST_FIXTURE_TEST_CASE(keeping_up_with_a_generation_publisher_reports_no_gaps, SubscriptionFixture)
+{
+    Subscribe();
+    for (uint32_t value = 0; value < 5 * FRAME_COUNT; ++value)
+    {
+        mPublisher->Publish(value);
+        Poll(1);
+    }
+    BOOST_TEST(mGaps.empty());
+    BOOST_TEST(mReceived == Range(0, 5 * FRAME_COUNT), boost::test_tools::per_element());
+}
+
+BOOST_FIXTURE_TEST_CASE(being_lapped_skips_to_the_latest_frame, SubscriptionFixture)
+{
+    Subscribe();
+    Publish(0, 10);
+    Poll();
+    Publish(10, 210);
+    Poll();
+
+    std::vector<uint32_t> expected = Range(0, 10);
+    expected.push_back(209);
+    BOOST_TEST(mReceived == expected, boost::test_tools::per_element());
+    BOOST_TEST(mGaps == std::vector<unsigned long>{199}, boost::test_tools::per_element());
+
+    Publish(210, 260);
+    Poll();
+    BOOST_TEST(mReceived.back() == 259u);
+    BOOST_TEST(mGaps.size() == 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(joining_late_starts_at_the_latest_frame_without_a_gap, SubscriptionFixture)
+{
+    Publish(0, 200);
+    Subscribe();
+    Poll();
+    for (uint32_t value = 200; value < 400; ++value)
+    {
+        mPublisher->Publish(value);
+        Poll(1);
+    }
+
+    std::vector<uint32_t> expected = Range(199, 400);
+    BOOST_TEST(mGaps.empty());
+    BOOST_TEST(mReceived == expected, boost::test_tools::per_element());
+}
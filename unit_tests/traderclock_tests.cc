@@ -0,0 +1,160 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE traderclock_tests
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ready_trader_go/frequencylimiter.h"
+#include "ready_trader_go/traderclock.h"
+#include "ready_trader_go/unhedgedlots.h"
+
+using namespace ReadyTraderGo;
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_CASE(without_a_simulation_the_clock_is_the_steady_clock)
+{
+    BOOST_TEST(!SimulatedClock::GetInstalled());
+    const auto before = std::chrono::steady_clock::now().time_since_epoch();
+    const auto now = TraderClock::now().time_since_epoch();
+    const auto after = std::chrono::steady_clock::now().time_since_epoch();
+    BOOST_TEST((before <= now && now <= after));
+}
+
+BOOST_AUTO_TEST_CASE(a_simulation_is_installed_for_as_long_as_it_exists)
+{
+    {
+        SimulatedClock clock;
+        BOOST_TEST(SimulatedClock::GetInstalled() == &clock);
+        BOOST_TEST((TraderClock::now() == SimulatedClock::START));
+    }
+    BOOST_TEST(!SimulatedClock::GetInstalled());
+}
+
+BOOST_AUTO_TEST_CASE(timers_expire_in_order_with_the_time_jumping_to_each)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    TraderTimer late{context}, early{context}, alsoEarly{context};
+    std::vector<std::pair<std::string, TraderClock::duration>> expired;
+    auto wait = [&](TraderTimer& timer, std::string name, TraderClock::duration after) {
+        timer.expires_after(after);
+        timer.async_wait([&, name](const boost::system::error_code& error) {
+            BOOST_TEST(!error);
+            expired.emplace_back(name, TraderClock::now() - SimulatedClock::START);
+        });
+    };
+    wait(late, "late", 30s);
+    wait(early, "early", 10s);
+    wait(alsoEarly, "also early", 10s);
+
+    const auto start = std::chrono::steady_clock::now();
+    BOOST_TEST(clock.Run(context) == 3u);
+    BOOST_TEST((std::chrono::steady_clock::now() - start < 1s));
+
+    BOOST_TEST(expired.size() == 3u);
+    BOOST_TEST(expired[0].first == "early");
+    BOOST_TEST(expired[1].first == "also early");
+    BOOST_TEST(expired[2].first == "late");
+    BOOST_TEST((expired[0].second == 10s && expired[1].second == 10s && expired[2].second == 30s));
+    BOOST_TEST((clock.Now() - SimulatedClock::START == 30s));
+}
+
+BOOST_AUTO_TEST_CASE(handlers_run_before_the_time_moves_on)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    TraderTimer timer{context};
+    int ticks = 0;
+    std::function<void(const boost::system::error_code&)> tick = [&](const boost::system::error_code& error) {
+        if (!error && ++ticks < 5)
+        {
+            // A timer re-armed for the current time expires without the
+            // time moving
+            timer.expires_at(TraderClock::now() + ((ticks % 2 == 0) ? 1s : 0s));
+            timer.async_wait(tick);
+        }
+    };
+    timer.expires_after(1s);
+    timer.async_wait(tick);
+    clock.Run(context);
+    BOOST_TEST(ticks == 5);
+    BOOST_TEST((clock.Now() - SimulatedClock::START == 3s));
+}
+
+BOOST_AUTO_TEST_CASE(cancelled_and_moved_waits_are_aborted)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    TraderTimer timer{context};
+    std::vector<boost::system::error_code> errors;
+    auto handler = [&](const boost::system::error_code& error) { errors.push_back(error); };
+
+    timer.expires_after(5s);
+    timer.async_wait(handler);
+    BOOST_TEST(timer.cancel() == 1u);
+    timer.async_wait(handler);
+    BOOST_TEST(timer.expires_after(2s) == 1u);
+    timer.async_wait(handler);
+    clock.Run(context);
+
+    BOOST_TEST(errors.size() == 3u);
+    BOOST_TEST((errors[0] == boost::asio::error::operation_aborted));
+    BOOST_TEST((errors[1] == boost::asio::error::operation_aborted));
+    BOOST_TEST(!errors[2]);
+    BOOST_TEST((clock.Now() - SimulatedClock::START == 2s));
+}
+
+BOOST_AUTO_TEST_CASE(a_stopped_context_stops_the_simulation)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+    TraderTimer first{context}, second{context};
+    bool isSecondRun = false;
+    first.expires_after(1s);
+    first.async_wait([&](const boost::system::error_code&) { context.stop(); });
+    second.expires_after(2s);
+    second.async_wait([&](const boost::system::error_code&) { isSecondRun = true; });
+    clock.Run(context);
+    BOOST_TEST(!isSecondRun);
+    BOOST_TEST((clock.Now() - SimulatedClock::START == 1s));
+}
+
+BOOST_AUTO_TEST_CASE(time_limits_are_measured_in_simulated_time)
+{
+    SimulatedClock clock;
+    boost::asio::io_context context;
+
+    FrequencyLimiter limiter{1s, 2};
+    BOOST_TEST(limiter.Admit());
+    BOOST_TEST(limiter.Admit());
+    BOOST_TEST(!limiter.Admit());
+    BOOST_TEST((limiter.GetNextAdmitTime() == SimulatedClock::START + 1s));
+
+    UnhedgedLots unhedgedLots{context, 5s};
+    TraderClock::duration expiredAfter{};
+    unhedgedLots.Expiring = [&] { expiredAfter = TraderClock::now() - SimulatedClock::START; };
+    unhedgedLots.Update(UNHEDGED_LOTS_LIMIT + 1);
+    clock.Run(context);
+    BOOST_TEST((expiredAfter == UNHEDGED_LOTS_TIME_LIMIT - 5s));
+    BOOST_TEST(limiter.Admit());
+}